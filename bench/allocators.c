@@ -0,0 +1,88 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <pstring/allocators.h>
+#include <pstring/dictionary.h>
+#include <pstring/pstring.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define STRINGS 100000
+#define ROUNDS 20
+#define KEY "request/session/0000000000000000/key"
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Simulates request-scoped work: many short strings, some of which grow,
+   are created and then all freed together. Strings start longer than the
+   SSO buffer, so the standard allocator is used without an allocator. */
+static int run_round(allocator_t *allocator, pstring_t *strings) {
+    for (size_t i = 0; i < STRINGS; i++) {
+        if (pstrnew(&strings[i], KEY, sizeof(KEY) - 1, allocator))
+            return 1;
+        for (size_t j = 0; j < i % 8; j++)
+            if (pstrcats(&strings[i], "0123456789abcdef", 16))
+                return 1;
+    }
+
+    for (size_t i = 0; i < STRINGS; i++)
+        pstrfree(&strings[i]);
+
+    return 0;
+}
+
+static double bench(allocator_t *allocator, pstrarena_t *arena) {
+    pstring_t *strings = malloc(STRINGS * sizeof(pstring_t));
+    if (!strings)
+        exit(1);
+
+    double start = now();
+    for (int i = 0; i < ROUNDS; i++) {
+        if (run_round(allocator, strings))
+            exit(1);
+        if (arena)
+            pstrarena_reset(arena);
+    }
+    double elapsed = now() - start;
+
+    free(strings);
+    return (double)STRINGS * ROUNDS / elapsed / 1e6;
+}
+
+int main(void) {
+    pstrarena_t *arena = pstrarena_new(0, NULL);
+    pstrpool_t *pool = pstrpool_new(NULL);
+    if (!arena || !pool)
+        return 1;
+
+    printf("malloc %8.2f Mstr/s\n", bench(NULL, NULL));
+    printf("arena  %8.2f Mstr/s\n", bench(pstrarena_allocator(arena), arena));
+    printf("pool   %8.2f Mstr/s\n", bench(pstrpool_allocator(pool), NULL));
+
+    pstrpool_free(pool);
+    pstrarena_free(arena);
+    return 0;
+}
@@ -0,0 +1,206 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <pstring/cdict.h>
+#include <pstring/dictionary.h>
+#include <pstring/pstring.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define KEYS (256 * 1024)
+#define KEY_SIZE 48
+#define MAX_THREADS 64
+#define DURATION 0.25
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Route-like keys, such as the paths of a shared routing table. */
+static void fill_keys(char *names, pstring_t *keys) {
+    for (size_t i = 0; i < KEYS; i++) {
+        char *name = &names[i * KEY_SIZE];
+        int length = snprintf(
+            name, KEY_SIZE, "/api/v%zu/service-%zu/route-%zu", i % 3, i % 97, i
+        );
+        pstrwrap(&keys[i], name, length, length);
+    }
+}
+
+/* The baseline, a `pstrdict_t` shared behind a global read-write lock. */
+struct locked {
+    pthread_rwlock_t lock;
+    pstrdict_t *dict;
+};
+
+struct run {
+    pstrcdict_t *cdict;
+    struct locked *locked;
+    const pstring_t *keys;
+    atomic_int stop;
+    size_t updates;
+    double lookups; /* millions of lookups per second */
+    double rate;    /* updates per second */
+};
+
+struct reader {
+    struct run *run;
+    size_t seed;
+    size_t lookups;
+};
+
+static void *read_keys(void *arg) {
+    struct reader *reader = arg;
+    struct run *run = reader->run;
+    size_t next = reader->seed, lookups = 0;
+
+    while (!atomic_load_explicit(&run->stop, memory_order_relaxed)) {
+        for (int i = 0; i < 256; i++) {
+            /* a linear congruential walk over the keys */
+            next = next * 6364136223846793005ull + 1442695040888963407ull;
+            const pstring_t *key = &run->keys[(next >> 33) % KEYS];
+
+            if (run->cdict) {
+                if (!pstrcdict_get(run->cdict, key))
+                    exit(1);
+            } else {
+                pthread_rwlock_rdlock(&run->locked->lock);
+                void *value = pstrdict_get(run->locked->dict, key);
+                pthread_rwlock_unlock(&run->locked->lock);
+                if (!value)
+                    exit(1);
+            }
+        }
+
+        lookups += 256;
+    }
+
+    reader->lookups = lookups;
+    return NULL;
+}
+
+/* Updates a key every millisecond while the readers run. Writers may starve
+   behind the readers of a read-write lock, so updates are counted too. */
+static void *update_keys(void *arg) {
+    struct run *run = arg;
+    struct timespec pause = { 0, 1000 * 1000 };
+
+    while (!atomic_load_explicit(&run->stop, memory_order_relaxed)) {
+        const pstring_t *key = &run->keys[run->updates * 7919 % KEYS];
+
+        if (run->cdict) {
+            pstrcdict_set(run->cdict, key, key);
+        } else {
+            pthread_rwlock_wrlock(&run->locked->lock);
+            pstrdict_set(run->locked->dict, key, key);
+            pthread_rwlock_unlock(&run->locked->lock);
+        }
+
+        run->updates++;
+        nanosleep(&pause, NULL);
+    }
+
+    return NULL;
+}
+
+static void measure(struct run *run, size_t threads) {
+    struct reader readers[MAX_THREADS];
+    pthread_t ids[MAX_THREADS], writer;
+    struct timespec duration = { 0, DURATION * 1e9 };
+
+    atomic_store(&run->stop, 0);
+    run->updates = 0;
+
+    double start = now();
+    for (size_t i = 0; i < threads; i++) {
+        readers[i] = (struct reader) { run, i + 1, 0 };
+        if (pthread_create(&ids[i], NULL, read_keys, &readers[i]))
+            exit(1);
+    }
+
+    if (pthread_create(&writer, NULL, update_keys, run))
+        exit(1);
+
+    nanosleep(&duration, NULL);
+    atomic_store(&run->stop, 1);
+
+    size_t lookups = 0;
+    for (size_t i = 0; i < threads; i++) {
+        pthread_join(ids[i], NULL);
+        lookups += readers[i].lookups;
+    }
+
+    pthread_join(writer, NULL);
+
+    double elapsed = now() - start;
+    run->lookups = lookups / elapsed / 1e6;
+    run->rate = run->updates / elapsed;
+}
+
+int main(void) {
+    char *names = malloc(KEYS * KEY_SIZE);
+    pstring_t *keys = malloc(KEYS * sizeof(pstring_t));
+    if (!names || !keys)
+        return 1;
+
+    fill_keys(names, keys);
+
+    struct locked locked = { .dict = pstrdict_new(NULL, NULL) };
+    pstrcdict_t *cdict = pstrcdict_new(0, NULL);
+    if (!locked.dict || !cdict || pthread_rwlock_init(&locked.lock, NULL))
+        return 1;
+
+    for (size_t i = 0; i < KEYS; i++)
+        if (pstrdict_set(locked.dict, &keys[i], &keys[i])
+            || pstrcdict_set(cdict, &keys[i], &keys[i]))
+            return 1;
+
+    struct run rwlock = { .locked = &locked, .keys = keys };
+    struct run concurrent = { .cdict = cdict, .keys = keys };
+
+    for (size_t threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        measure(&rwlock, threads);
+        measure(&concurrent, threads);
+
+        printf(
+            "%2zu readers  rwlock %8.1f M/s %5.0f upd/s   "
+            "cdict %8.1f M/s %5.0f upd/s   (%.1fx)\n",
+            threads,
+            rwlock.lookups,
+            rwlock.rate,
+            concurrent.lookups,
+            concurrent.rate,
+            concurrent.lookups / rwlock.lookups
+        );
+    }
+
+    pthread_rwlock_destroy(&locked.lock);
+    pstrdict_free(locked.dict);
+    pstrcdict_free(cdict);
+    free(keys);
+    free(names);
+    return 0;
+}
@@ -0,0 +1,189 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <pstring/dictionary.h>
+#include <pstring/pstring.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define KEYS (1024 * 1024)
+#define KEY_SIZE 48
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Keys of 8 to 47 bytes, like the values of a column being deduplicated. */
+static void fill_keys(char *names, pstring_t *keys) {
+    for (size_t i = 0; i < KEYS; i++) {
+        char *name = &names[i * KEY_SIZE];
+        int length = snprintf(
+            name, KEY_SIZE, "%.*s%zu", rand() % 38, "/static/assets/images/", i
+        );
+        pstrwrap(&keys[i], name, length, length);
+    }
+}
+
+static void bench_bulk(const pstring_t *keys, void **values) {
+    pstrdict_t *dict = pstrdict_new_seeded(42, NULL);
+    double start = now();
+
+    for (size_t i = 0; i < KEYS; i++)
+        if (pstrdict_set(dict, &keys[i], values[i]))
+            exit(1);
+
+    double single = now() - start;
+    pstrdict_free(dict);
+
+    dict = pstrdict_new_seeded(42, NULL);
+    start = now();
+    if (pstrdict_set_many(dict, keys, values, KEYS))
+        exit(1);
+
+    double many = now() - start;
+    pstrdict_free(dict);
+
+    printf(
+        "bulk load    set %6.1f ns/key   set_many %6.1f ns/key\n",
+        single * 1e9 / KEYS,
+        many * 1e9 / KEYS
+    );
+}
+
+/* Long URL-like keys, where hashing dominates the cost of a resize. */
+#define URL_SIZE 128
+
+static void fill_urls(char *names, pstring_t *keys) {
+    for (size_t i = 0; i < KEYS; i++) {
+        char *name = &names[i * URL_SIZE];
+        int length = snprintf(
+            name,
+            URL_SIZE,
+            "https://cdn.example.com/static/assets/%zu/images/thumbnails/"
+            "%zu/large/photo-%zu.jpeg?width=1024&height=768",
+            i % 97,
+            i % 1013,
+            i
+        );
+        pstrwrap(&keys[i], name, length, length);
+    }
+}
+
+/* Times every insertion that grows the table, which stalls the caller. */
+static void bench_resize(const pstring_t *keys, void **values) {
+    pstrdict_t *dict = pstrdict_new_seeded(42, NULL);
+    double total = 0, worst = 0;
+    size_t resizes = 0;
+
+    for (size_t i = 0; i < KEYS; i++) {
+        size_t capacity = pstrdict_capacity(dict);
+        double start = now();
+
+        if (pstrdict_set(dict, &keys[i], values[i]))
+            exit(1);
+
+        if (pstrdict_capacity(dict) != capacity) {
+            double elapsed = now() - start;
+            total += elapsed;
+            worst = elapsed > worst ? elapsed : worst;
+            resizes++;
+        }
+    }
+
+    printf(
+        "resize       %zu resizes %8.2f ms total %8.2f ms worst\n",
+        resizes,
+        total * 1e3,
+        worst * 1e3
+    );
+    pstrdict_free(dict);
+}
+
+/* Keeps a steady window of pairs while cycling through all keys, like a
+   cache evicting its oldest entry for every new one, then times misses. */
+#define WINDOW 10000
+
+static void bench_churn(const pstring_t *keys, void **values) {
+    pstrdict_t *dict = pstrdict_new_seeded(42, NULL);
+
+    for (size_t i = 0; i < WINDOW; i++)
+        if (pstrdict_set(dict, &keys[i], values[i]))
+            exit(1);
+
+    double start = now();
+    for (size_t i = WINDOW; i < 20 * KEYS; i++) {
+        pstrdict_remove(dict, &keys[(i - WINDOW) % KEYS]);
+        if (pstrdict_set(dict, &keys[i % KEYS], values[i % KEYS]))
+            exit(1);
+    }
+
+    double churn = now() - start;
+    size_t rounds = 20 * KEYS - WINDOW;
+
+    /* the keys just evicted are all misses */
+    start = now();
+    size_t found = 0;
+    for (size_t i = 0; i < KEYS - WINDOW; i++)
+        found += pstrdict_get(dict, &keys[i]) != NULL;
+
+    double misses = now() - start;
+
+    printf(
+        "churn        %6.1f ns/round  miss %6.1f ns/key   capacity %zu (%zu)\n",
+        churn * 1e9 / rounds,
+        misses * 1e9 / (KEYS - WINDOW),
+        pstrdict_capacity(dict),
+        found
+    );
+    pstrdict_free(dict);
+}
+
+int main(void) {
+    srand(42);
+
+    char *names = malloc(KEYS * KEY_SIZE);
+    pstring_t *keys = malloc(KEYS * sizeof(pstring_t));
+    void **values = malloc(KEYS * sizeof(void *));
+    if (!names || !keys || !values)
+        return 1;
+
+    fill_keys(names, keys);
+    for (size_t i = 0; i < KEYS; i++)
+        values[i] = &keys[i];
+
+    bench_bulk(keys, values);
+    bench_churn(keys, values);
+
+    char *urls = realloc(names, KEYS * URL_SIZE);
+    if (!urls)
+        return 1;
+
+    fill_urls(urls, keys);
+    bench_resize(keys, values);
+
+    free(values);
+    free(keys);
+    free(urls);
+    return 0;
+}
@@ -0,0 +1,98 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <pstring/parallel.h>
+#include <pstring/pstring.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HAYSTACK_SIZE (256 * 1024 * 1024)
+#define REPEAT 4
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void report(const char *name, double serial, double parallel) {
+    double bytes = (double)HAYSTACK_SIZE * REPEAT / (1024.0 * 1024.0);
+    printf(
+        "%-8s serial %8.1f MiB/s   parallel %8.1f MiB/s   (%.1fx)\n",
+        name,
+        bytes / serial,
+        bytes / parallel,
+        serial / parallel
+    );
+}
+
+int main(void) {
+    pstrdetect();
+    srand(42);
+
+    char *buffer = malloc(HAYSTACK_SIZE + 1);
+    if (!buffer)
+        return 1;
+
+    for (size_t i = 0; i < HAYSTACK_SIZE; i++)
+        buffer[i] = "abcdefgh \n"[rand() % 10];
+
+    pstring_t hay, needle = PSTRWRAP("hgfedcba");
+    pstrwrap(&hay, buffer, HAYSTACK_SIZE, HAYSTACK_SIZE);
+
+    double start = now();
+    for (int i = 0; i < REPEAT; i++)
+        pstrchr(&hay, 'z');
+    double serial = now() - start;
+
+    start = now();
+    for (int i = 0; i < REPEAT; i++)
+        pstrchr_par(&hay, 'z', NULL);
+    report("chr", serial, now() - start);
+
+    start = now();
+    for (int i = 0; i < REPEAT; i++)
+        pstrstr(&hay, &needle);
+    serial = now() - start;
+
+    start = now();
+    for (int i = 0; i < REPEAT; i++)
+        pstrstr_par(&hay, &needle, NULL);
+    report("str", serial, now() - start);
+
+    size_t expected = pstrcount(&hay, PSTR("ab"));
+    start = now();
+    for (int i = 0; i < REPEAT; i++)
+        if (pstrcount(&hay, PSTR("ab")) != expected)
+            return 1;
+    serial = now() - start;
+
+    start = now();
+    for (int i = 0; i < REPEAT; i++)
+        if (pstrcount_par(&hay, PSTR("ab"), NULL) != expected)
+            return 1;
+    report("count", serial, now() - start);
+
+    free(buffer);
+    return 0;
+}
@@ -0,0 +1,113 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#define _GNU_SOURCE
+#include <pstring/pstring.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HAYSTACK_SIZE (16 * 1024 * 1024)
+#define REPEAT 8
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fill_text(char *buffer, size_t length) {
+    static const char *words[] = {
+        "GET ",   "/index.html ", "HTTP/1.1 ", "200 ",  "-- ",
+        "user=",  "session ",     "0000 ",     "ms\n", "INFO ",
+    };
+
+    size_t i = 0;
+    while (i < length) {
+        const char *word = words[rand() % 10];
+        for (size_t j = 0; word[j] && i < length; j++)
+            buffer[i++] = word[j];
+    }
+}
+
+static void bench(const char *name, const pstring_t *hay, const char *needle) {
+    pstring_t sub;
+    pstrwrap(&sub, (char *)needle, 0, 0);
+
+    const char *expected = memmem(
+        pstrbuf(hay), pstrlen(hay), pstrbuf(&sub), pstrlen(&sub)
+    );
+
+    if (expected != pstrstr(hay, &sub)) {
+        fprintf(stderr, "%s: pstrstr and memmem disagree\n", name);
+        exit(1);
+    }
+
+    double start = now();
+    for (int i = 0; i < REPEAT; i++)
+        if (pstrstr(hay, &sub) != expected)
+            exit(1);
+    double ours = now() - start;
+
+    start = now();
+    for (int i = 0; i < REPEAT; i++)
+        if (memmem(pstrbuf(hay), pstrlen(hay), needle, pstrlen(&sub))
+            != expected)
+            exit(1);
+    double theirs = now() - start;
+
+    double bytes = (double)pstrlen(hay) * REPEAT / (1024.0 * 1024.0);
+    printf(
+        "%-12s pstrstr %8.1f MiB/s   memmem %8.1f MiB/s\n",
+        name,
+        bytes / ours,
+        bytes / theirs
+    );
+}
+
+int main(void) {
+    pstrdetect();
+    srand(42);
+
+    char *buffer = malloc(HAYSTACK_SIZE + 1);
+    if (!buffer)
+        return 1;
+
+    pstring_t hay;
+    pstrwrap(&hay, buffer, HAYSTACK_SIZE, HAYSTACK_SIZE);
+
+    fill_text(buffer, HAYSTACK_SIZE);
+    bench("text/short", &hay, "XYZ");
+    bench("text/word", &hay, "session 0000 ms\nERROR");
+    bench("text/long", &hay, "GET /index.html HTTP/1.1 500 -- user=root");
+
+    memset(buffer, 'a', HAYSTACK_SIZE);
+    bench("repeat/2", &hay, "ab");
+    bench("repeat/16", &hay, "aaaaaaaaaaaaaaab");
+    bench("repeat/64",
+          &hay,
+          "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab");
+    bench("repeat/mid", &hay, "aaaaaaaabaaaaaaaa");
+
+    free(buffer);
+    return 0;
+}
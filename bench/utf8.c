@@ -0,0 +1,190 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <pstring/encoding.h>
+#include <pstring/pstring.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TEXT_SIZE (16 * 1024 * 1024)
+#define REPEAT 16
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fill_text(char *buffer, size_t length, const char **words) {
+    size_t i = 0;
+    while (i < length) {
+        const char *word = words[rand() % 4];
+        size_t size = strlen(word);
+
+        if (length - i < size)
+            break;
+
+        memcpy(&buffer[i], word, size);
+        i += size;
+    }
+
+    memset(&buffer[i], ' ', length - i);
+}
+
+/* decodes every character, which is how validation was done before */
+static size_t decode_all(const pstring_t *str) {
+    const char *chr = pstrbuf(str);
+    const char *end = pstrend(str);
+    size_t count = 0;
+    uint32_t code;
+
+    for (; chr < end; count++)
+        chr = pstr_read_utf8(chr, end, &code);
+
+    return count;
+}
+
+static void bench(const char *name, const pstring_t *text) {
+    size_t expected = decode_all(text);
+
+    if (!pstrvalid_utf8(text) || pstrlen_utf8(text) != expected) {
+        fprintf(stderr, "%s: unexpected result\n", name);
+        exit(1);
+    }
+
+    double start = now();
+    for (int i = 0; i < REPEAT; i++)
+        if (!pstrvalid_utf8(text))
+            exit(1);
+    double valid = now() - start;
+
+    start = now();
+    for (int i = 0; i < REPEAT; i++)
+        if (pstrlen_utf8(text) != expected)
+            exit(1);
+    double length = now() - start;
+
+    start = now();
+    for (int i = 0; i < REPEAT; i++)
+        if (decode_all(text) != expected)
+            exit(1);
+    double decode = now() - start;
+
+    double bytes = (double)pstrlen(text) * REPEAT / (1024.0 * 1024.0);
+    printf(
+        "%-8s valid %8.1f MiB/s   len %8.1f MiB/s   decode %8.1f MiB/s\n",
+        name,
+        bytes / valid,
+        bytes / length,
+        bytes / decode
+    );
+}
+
+static void bench_transcode(const char *name, const pstring_t *text) {
+    size_t units = 0, codes = 0;
+    pstring_t out = { 0 };
+
+    pstrenc_utf16le(NULL, &units, text);
+    pstrdec_utf8(NULL, &codes, text);
+
+    uint16_t *utf16 = malloc(units * sizeof(uint16_t));
+    uint32_t *utf32 = malloc(codes * sizeof(uint32_t));
+    if (!utf16 || !utf32 || pstrreserve(&out, pstrlen(text)))
+        exit(1);
+
+    double start = now();
+    for (int i = 0; i < REPEAT; i++) {
+        size_t length = units;
+        if (pstrenc_utf16le(utf16, &length, text))
+            exit(1);
+    }
+    double to16 = now() - start;
+
+    start = now();
+    for (int i = 0; i < REPEAT; i++) {
+        pstrclear(&out);
+        if (pstrdec_utf16le(&out, utf16, units))
+            exit(1);
+    }
+    double from16 = now() - start;
+
+    start = now();
+    for (int i = 0; i < REPEAT; i++) {
+        size_t length = codes;
+        if (pstrdec_utf8(utf32, &length, text))
+            exit(1);
+    }
+    double to32 = now() - start;
+
+    if (!pstrequals(&out, pstrbuf(text), pstrlen(text))) {
+        fprintf(stderr, "%s: unexpected result\n", name);
+        exit(1);
+    }
+
+    double bytes = (double)pstrlen(text) * REPEAT / (1024.0 * 1024.0);
+    printf(
+        "%-8s utf16 %8.1f MiB/s   from utf16 %8.1f MiB/s   utf32 %8.1f MiB/s\n",
+        name,
+        bytes / to16,
+        bytes / from16,
+        bytes / to32
+    );
+
+    pstrfree(&out);
+    free(utf16);
+    free(utf32);
+}
+
+int main(void) {
+    static const char *ascii[] = { "request ", "body ", "json\n", "{} " };
+    static const char *latin[] = {
+        "caf\xC3\xA9 ", "na\xC3\xAFve ", "request ", "stra\xC3\x9F" "e ",
+    };
+    static const char *cjk[] = {
+        "\xE6\x96\x87\xE5\xAD\x97 ", "\xE6\xBC\xA2\xE5\xAD\x97",
+        "\xF0\x9F\x98\x80", "\xE3\x81\x82",
+    };
+
+    pstrdetect();
+    srand(42);
+
+    char *buffer = malloc(TEXT_SIZE + 1);
+    if (!buffer)
+        return 1;
+
+    pstring_t text;
+    pstrwrap(&text, buffer, TEXT_SIZE, TEXT_SIZE);
+
+    fill_text(buffer, TEXT_SIZE, ascii);
+    bench("ascii", &text);
+    bench_transcode("ascii", &text);
+    fill_text(buffer, TEXT_SIZE, latin);
+    bench("latin", &text);
+    bench_transcode("latin", &text);
+    fill_text(buffer, TEXT_SIZE, cjk);
+    bench("cjk", &text);
+    bench_transcode("cjk", &text);
+
+    free(buffer);
+    return 0;
+}
@@ -0,0 +1,93 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef PSTRING_ALLOCATORS_H
+#define PSTRING_ALLOCATORS_H
+
+#ifndef PSTR_INLINE
+    #define PSTR_INLINE static inline
+#endif
+
+#ifndef PSTR_API
+    #define PSTR_API
+#endif
+
+#include <stddef.h>
+
+typedef struct allocator_t allocator_t;
+
+/** `pstrarena_t` is a bump allocator: memory is handed out from large
+    blocks in order and is only reclaimed all at once, by resetting or
+    freeing the arena. Freeing or growing the most recent allocation is
+    done in place. Suited for request-scoped work which creates many
+    short-lived strings. Arenas are not thread-safe.
+**/
+typedef struct pstrarena_t pstrarena_t;
+
+/** `pstrpool_t` keeps freed blocks in lists by size class and reuses them
+    for later allocations of the same class. Classes match the capacities
+    produced by `pstralloc` and `pstrgrow`, larger blocks are passed to the
+    parent allocator. Alignments larger than 32 bytes are not supported.
+    Pools are not thread-safe, each thread should use its own pool.
+**/
+typedef struct pstrpool_t pstrpool_t;
+
+/** Creates an arena which allocates blocks of at least `block_size`
+    bytes using `parent`. If `block_size` is zero, a default is used.
+    If `parent` is `NULL`, the standard allocator is used.
+    Returns `NULL` if memory runs out.
+**/
+PSTR_API pstrarena_t *pstrarena_new(size_t block_size, allocator_t *parent);
+
+/** Frees `arena` and all the memory allocated from it. **/
+PSTR_API void pstrarena_free(pstrarena_t *arena);
+
+/** Releases all memory allocated from `arena` in constant time, keeping
+    its blocks for future allocations.
+**/
+PSTR_API void pstrarena_reset(pstrarena_t *arena);
+
+/** Returns the allocator which allocates from `arena`, for use with
+    `pstralloc`, `pstrnew`, `pstrdict_new` and other functions.
+**/
+PSTR_API allocator_t *pstrarena_allocator(pstrarena_t *arena);
+
+/** Returns the number of bytes allocated from `arena` since the last reset,
+    including padding.
+**/
+PSTR_API size_t pstrarena_used(const pstrarena_t *arena);
+
+/** Creates a pool which allocates its slabs and large blocks using `parent`.
+    If `parent` is `NULL`, the standard allocator is used.
+    Returns `NULL` if memory runs out.
+**/
+PSTR_API pstrpool_t *pstrpool_new(allocator_t *parent);
+
+/** Frees `pool` and all the memory allocated from it, except blocks larger
+    than the largest size class, which are owned by the parent allocator.
+**/
+PSTR_API void pstrpool_free(pstrpool_t *pool);
+
+/** Returns the allocator which allocates from `pool`, for use with
+    `pstralloc`, `pstrnew`, `pstrdict_new` and other functions.
+**/
+PSTR_API allocator_t *pstrpool_allocator(pstrpool_t *pool);
+
+#endif
@@ -0,0 +1,116 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef PSTRING_BUILDER_H
+#define PSTRING_BUILDER_H
+
+#ifndef PSTR_INLINE
+    #define PSTR_INLINE static inline
+#endif
+
+#ifndef PSTR_API
+    #define PSTR_API
+#endif
+
+#include <stddef.h>
+
+typedef struct allocator_t allocator_t;
+typedef struct pstring_t pstring_t;
+typedef struct pstream_t pstream_t;
+
+/** `pstrbuilder_t` collects strings appended one after another into a list
+    of segments, each at least as large as all previous ones together.
+    Unlike growing a `pstring_t`, bytes already written are never moved,
+    and the result is copied only once, when it's joined or written out.
+
+    Builders initialized with `{0}` are empty and use the standard allocator.
+**/
+typedef struct pstrbuilder_t {
+    struct pstrbuilder_segment *head;
+    struct pstrbuilder_segment *tail;
+    allocator_t *allocator;
+    size_t length;   /* bytes appended */
+    size_t capacity; /* bytes allocated for segments */
+    size_t segments; /* number of segments */
+    size_t initial;  /* capacity of the first segment */
+} pstrbuilder_t;
+
+/** Statistics of a builder, used to choose its initial capacity. **/
+typedef struct pstrbuilder_stats_t {
+    size_t length;   /* bytes appended */
+    size_t capacity; /* bytes allocated for segments */
+    size_t segments; /* number of segments */
+} pstrbuilder_stats_t;
+
+/** Initializes `out` as an empty builder, allocated by `allocator`.
+    The first segment will fit at least `capacity` bytes.
+    If `allocator` is `NULL`, the standard allocator is used.
+    Possible error codes: PSTRING_EINVAL.
+**/
+PSTR_API int pstrbuilder_new(
+    pstrbuilder_t *out, size_t capacity, allocator_t *allocator
+);
+
+/** Frees all segments of `builder`, leaving it empty. **/
+PSTR_API void pstrbuilder_free(pstrbuilder_t *builder);
+
+/** Returns the number of bytes appended to `builder`. **/
+PSTR_API size_t pstrbuilder_len(const pstrbuilder_t *builder);
+
+/** Stores statistics of `builder` into `out`.
+    Possible error codes: PSTRING_EINVAL.
+**/
+PSTR_API int pstrbuilder_stats(
+    const pstrbuilder_t *builder, pstrbuilder_stats_t *out
+);
+
+/** Appends `src` to `builder`.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrbuilder_cat(pstrbuilder_t *builder, const pstring_t *src);
+
+/** Appends `length` bytes of `src` to `builder`.
+    If `length` is zero, `src` is treated as a null-terminated string.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrbuilder_cats(
+    pstrbuilder_t *builder, const char *src, size_t length
+);
+
+/** Appends a single character to `builder`.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrbuilder_catc(pstrbuilder_t *builder, char chr);
+
+/** Concatenates everything appended to `builder` onto `dst`, growing it
+    at most once, by exactly the number of missing bytes.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrbuilder_join(const pstrbuilder_t *builder, pstring_t *dst);
+
+/** Writes everything appended to `builder` to `stream`, one segment at
+    a time, without joining them first.
+    Possible error codes: PSTRING_EINVAL, PSTRING_EIO.
+**/
+PSTR_API int pstrbuilder_write(
+    const pstrbuilder_t *builder, pstream_t *stream
+);
+
+#endif
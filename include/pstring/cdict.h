@@ -0,0 +1,95 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef PSTRING_CDICT_H
+#define PSTRING_CDICT_H
+
+#ifndef PSTR_INLINE
+    #define PSTR_INLINE static inline
+#endif
+
+#ifndef PSTR_API
+    #define PSTR_API
+#endif
+
+#include <stddef.h>
+
+typedef struct allocator_t allocator_t;
+typedef struct pstring_t pstring_t;
+
+/** `pstrcdict_t` is a hashdict like `pstrdict_t` that can be read and updated
+    from multiple threads at once, made for dictionaries read far more often
+    than they are updated. Keys are split between shards, each with its own
+    table and writer lock. Readers take no locks and write no shared memory,
+    instead they retry when a writer changed their shard while they were
+    looking, so lookups on different threads don't slow each other down.
+
+    Tables are copied into new ones when they grow, and the old tables are
+    kept until the dictionary is freed, as readers may still be using them.
+    Since tables double in size, that's at most as much memory as the current
+    tables take. Keys and values are stored as pointers, and since a reader
+    may still look at a pair while it's removed, they must remain valid until
+    no lookup that started before their removal is running, such as strings
+    interned by `pstrintern_t` or freed with the dictionary.
+**/
+typedef struct pstrcdict_t pstrcdict_t;
+
+/** Creates a concurrent dictionary allocated by `allocator`, split between
+    `shards` tables, rounded up to a power of two. If `shards` is zero, a
+    default of 64 is used. If `allocator` is `NULL`, the standard allocator
+    is used. Keys are hashed by `pstrhash_seeded` with a random seed.
+    Returns `NULL` if memory runs out.
+**/
+PSTR_API pstrcdict_t *pstrcdict_new(size_t shards, allocator_t *allocator);
+
+/** Frees `dict` and all of its tables. No other thread may be using it. **/
+PSTR_API void pstrcdict_free(pstrcdict_t *dict);
+
+/** Returns the number of key-value pairs in `dict`, which may already be
+    outdated if other threads are updating it.
+**/
+PSTR_API size_t pstrcdict_count(const pstrcdict_t *dict);
+
+/** Retrieves the value associated with `key` or `NULL` if not found, without
+    taking any locks.
+**/
+PSTR_API void *pstrcdict_get(const pstrcdict_t *dict, const pstring_t *key);
+
+/** Sets the value associated with `key` to `value`, inserting them if `key` is
+    not already present in `dict`.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrcdict_set(
+    pstrcdict_t *dict, const pstring_t *key, const void *value
+);
+
+/** Inserts the key-value pair if it's not already present in `dict`.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM, PSTRING_EEXIST.
+**/
+PSTR_API int pstrcdict_insert(
+    pstrcdict_t *dict, const pstring_t *key, const void *value
+);
+
+/** Removes the key-value pair from `dict`, if it's found.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOENT.
+**/
+PSTR_API int pstrcdict_remove(pstrcdict_t *dict, const pstring_t *key);
+
+#endif
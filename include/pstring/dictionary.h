@@ -41,17 +41,53 @@ typedef struct pstring_t pstring_t;
 typedef struct pstrdict_t pstrdict_t;
 typedef size_t(pstrhash_fn)(const pstring_t *str);
 
+/** `pstrkey_t` is a key together with its hash, computed once by
+    `pstrdict_key` and reused by the `_hashed` variants of dictionary
+    operations. The hash is reused by every dictionary hashing keys the same
+    way, which are the ones using the same custom hash function, or the
+    default one with the same seed, as set by `pstrdict_new_seeded`. Other
+    dictionaries hash `str` again, so a key is valid for all of them. As with
+    other keys, `str` is stored by a dictionary instead of the `pstrkey_t`.
+**/
+typedef struct pstrkey_t {
+    const pstring_t *str;
+    size_t hash;
+    pstrhash_fn *hasher; /* hash function of the dictionary, or `NULL` */
+    size_t seed;         /* seed of the default hash, if `hasher` is `NULL` */
+} pstrkey_t;
+
 /** Allocates a new `pstrdict` using the `allocator` that will produce key hashes
     using the provided `hash` function. For each of the parameters that are
-    `NULL`, the default ones will be used.
+    `NULL`, the default ones will be used. The default hash is
+    `pstrhash_seeded` with a random seed picked for each dictionary, so keys
+    from untrusted input can't be chosen to collide.
 **/
 PSTR_API pstrdict_t *pstrdict_new(pstrhash_fn *hash, allocator_t *allocator);
 
+/** Allocates a new `pstrdict` like `pstrdict_new` with the default hash, but
+    with a fixed `seed`, for reproducible layouts and iteration order.
+**/
+PSTR_API pstrdict_t *pstrdict_new_seeded(size_t seed, allocator_t *allocator);
+
 /** Reserves space to fit at least `count` more key-value pairs inside `dict`.
+    Slots left behind by removed pairs are reclaimed in place before the
+    table grows, when they make up most of it.
     Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
 **/
 PSTR_API int pstrdict_reserve(pstrdict_t *dict, size_t count);
 
+/** Rehashes `dict` in place to drop the slots left behind by removed pairs,
+    shortening probe chains without changing its capacity.
+    Possible error codes: PSTRING_EINVAL.
+**/
+PSTR_API int pstrdict_compact(pstrdict_t *dict);
+
+/** Reduces the capacity of `dict` to the smallest one that fits its pairs,
+    freeing all slots when it's empty, and compacts it otherwise.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrdict_shrink(pstrdict_t *dict);
+
 /** Frees all memory resources used by `dict`. **/
 PSTR_API void pstrdict_free(pstrdict_t *dict);
 
@@ -67,9 +103,23 @@ PSTR_API allocator_t *pstrdict_allocator(const pstrdict_t *dict);
 /** Removes all key-value pairs from `dict` **/
 PSTR_API void pstrdict_clear(pstrdict_t *dict);
 
+/** Initializes `out` as `str` with its hash computed as `dict` hashes keys.
+    Possible error codes: PSTRING_EINVAL.
+**/
+PSTR_API int pstrdict_key(
+    const pstrdict_t *dict, pstrkey_t *out, const pstring_t *str
+);
+
 /** Retrieves the value associated with `key` or `NULL` if not found. **/
 PSTR_API void *pstrdict_get(const pstrdict_t *dict, const pstring_t *key);
 
+/** Retrieves the value associated with `key` like `pstrdict_get`, using its
+    precomputed hash.
+**/
+PSTR_API void *pstrdict_get_hashed(
+    const pstrdict_t *dict, const pstrkey_t *key
+);
+
 /** Retrieves the value associated with `key` or `NULL` if not found. **/
 PSTR_API void *pstrdict_gets(
     const pstrdict_t *dict, const char *key, size_t length
@@ -85,6 +135,26 @@ PSTR_API int pstrdict_set(
     pstrdict_t *dict, const pstring_t *key, const void *value
 );
 
+/** Sets the value associated with `key` like `pstrdict_set`, using its
+    precomputed hash.
+
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrdict_set_hashed(
+    pstrdict_t *dict, const pstrkey_t *key, const void *value
+);
+
+/** Sets the values of `count` keys at once, like calling `pstrdict_set` for
+    each pair of `keys[i]` and `values[i]` in order, but reserving space once
+    and hashing the keys in batches. Pointers to elements of `keys` are
+    stored, so the array must remain valid like the keys of `pstrdict_set`.
+
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrdict_set_many(
+    pstrdict_t *dict, const pstring_t *keys, void *const *values, size_t count
+);
+
 /** Inserts the key-value pair if it's not already present in `dict`.
     Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM, PSTRING_EEXIST.
 **/
@@ -92,11 +162,27 @@ PSTR_API int pstrdict_insert(
     pstrdict_t *dict, const pstring_t *key, const void *value
 );
 
+/** Inserts the key-value pair like `pstrdict_insert`, using the precomputed
+    hash of `key`.
+
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM, PSTRING_EEXIST.
+**/
+PSTR_API int pstrdict_insert_hashed(
+    pstrdict_t *dict, const pstrkey_t *key, const void *value
+);
+
 /** Removes the key-value pair from `dict`, if it's found.
     Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM, PSTRING_ENOENT.
 **/
 PSTR_API int pstrdict_remove(pstrdict_t *dict, const pstring_t *key);
 
+/** Removes the key-value pair like `pstrdict_remove`, using the precomputed
+    hash of `key`.
+
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM, PSTRING_ENOENT.
+**/
+PSTR_API int pstrdict_remove_hashed(pstrdict_t *dict, const pstrkey_t *key);
+
 /** Forcefully inserts the key-value pair, without checking for it's presence.
     Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
 **/
@@ -104,6 +190,15 @@ PSTR_API int pstrdict_finsert(
     pstrdict_t *dict, const pstring_t *key, const void *value
 );
 
+/** Forcefully inserts the key-value pair like `pstrdict_finsert`, using the
+    precomputed hash of `key`.
+
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrdict_finsert_hashed(
+    pstrdict_t *dict, const pstrkey_t *key, const void *value
+);
+
 /** Callback that traverses the key-value pairs of a dictionary. **/
 typedef int(pstrdict_fn)(void *user, pstring_t *key, void *value);
 
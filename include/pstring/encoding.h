@@ -56,8 +56,9 @@ typedef struct pstring_t pstring_t;
     This way of handling parameters allows for encoding a stream of data.
 
     Many operations on pstrings are encoding-agnostic, while others assume
-    an ASCII or UTF-8 encoding. For those, UTF-16 support is not explicitly
-    supported and pstrings need to be converted to UTF-8 for them to work.
+    an ASCII or UTF-8 encoding. Text in other Unicode encodings needs to be
+    converted to UTF-8 first, which `pstrenc_utf8`, `pstrdec_utf16le` and
+    `pstrdec_utf16be` do for UTF-32 and UTF-16.
 
     [TOC]
 
@@ -145,7 +146,8 @@ PSTR_API int pstrenc_cstring(pstring_t *dst, const pstring_t *src);
 **/
 PSTR_API int pstrdec_cstring(pstring_t *dst, const pstring_t *src);
 
-/** Encodes codepoints from `src` as UTF8 characters.
+/** Encodes codepoints from `src` as UTF8 characters. Codepoints past
+    U+10FFFF are replaced with U+FFFD.
     Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
 **/
 PSTR_API int pstrenc_utf8(pstring_t *dst, const uint32_t *src, size_t length);
@@ -153,10 +155,37 @@ PSTR_API int pstrenc_utf8(pstring_t *dst, const uint32_t *src, size_t length);
 /** Decodes UTF-8 characters from `src` as Unicode codepoints.
     Parameter `length` should point to the maximum length of the buffer `dst`,
     which will be changed by the function to the number of codepoints decoded.
+    If `dst` is `NULL`, `length` is set to the number of codepoints in `src`.
     Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
 **/
 PSTR_API int pstrdec_utf8(uint32_t *dst, size_t *length, const pstring_t *src);
 
+/** Encodes UTF-8 characters from `src` as UTF-16 code units stored in
+    little-endian or big-endian byte order, regardless of the platform.
+    Parameter `length` works the same way as in `pstrdec_utf8`, counting
+    code units instead. Characters that can't be represented in UTF-16 are
+    replaced with U+FFFD.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrenc_utf16le(
+    uint16_t *dst, size_t *length, const pstring_t *src
+);
+PSTR_API int pstrenc_utf16be(
+    uint16_t *dst, size_t *length, const pstring_t *src
+);
+
+/** Decodes `length` UTF-16 code units from `src`, stored in little-endian
+    or big-endian byte order, as UTF-8 characters. Unpaired surrogates are
+    replaced with U+FFFD.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrdec_utf16le(
+    pstring_t *dst, const uint16_t *src, size_t length
+);
+PSTR_API int pstrdec_utf16be(
+    pstring_t *dst, const uint16_t *src, size_t length
+);
+
 /** Encodes `src` as a JSON string into `dst`.
     Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
 **/
@@ -204,4 +233,25 @@ PSTR_API const char *pstr_read_utf8(
 **/
 PSTR_API char *pstr_write_utf8(char *out, uint32_t c);
 
+/** Returns the simple lowercase or uppercase mapping of the Unicode code
+    point `c`, or `c` itself if it doesn't have one.
+**/
+PSTR_API uint32_t pstr_tolower(uint32_t c);
+PSTR_API uint32_t pstr_toupper(uint32_t c);
+
+/** Checks if `str` is well-formed UTF-8, rejecting overlong encodings,
+    surrogates and code points past U+10FFFF.
+**/
+PSTR_API int pstrvalid_utf8(const pstring_t *str);
+
+/** Returns the number of UTF-8 characters in `str`, which is assumed to be
+    valid. Otherwise, every byte that isn't a continuation byte is counted.
+**/
+PSTR_API size_t pstrlen_utf8(const pstring_t *str);
+
+/** Returns the number of UTF-16 code units needed for `str`, which is
+    assumed to be valid UTF-8.
+**/
+PSTR_API size_t pstrlen_utf16(const pstring_t *str);
+
 #endif
@@ -0,0 +1,96 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef PSTRING_FUZZY_H
+#define PSTRING_FUZZY_H
+
+#ifndef PSTR_INLINE
+    #define PSTR_INLINE static inline
+#endif
+
+#ifndef PSTR_API
+    #define PSTR_API
+#endif
+
+#include <stddef.h>
+
+typedef struct allocator_t allocator_t;
+typedef struct pstring_t pstring_t;
+
+/** `pstrfuzzy_t` is an index over a set of strings, which finds the entries
+    closest to a query using the same distance as `pstrdistance`, without
+    comparing the query against every entry. Entries are copied when the
+    index is built. Once built, the index is never modified, so it can be
+    searched from multiple threads at the same time.
+**/
+typedef struct pstrfuzzy_t pstrfuzzy_t;
+
+/** Entry found by a fuzzy search. **/
+typedef struct pstrfuzzy_match_t {
+    size_t index;    /* index of the entry passed to `pstrfuzzy_new` */
+    size_t distance; /* distance between the entry and the query */
+} pstrfuzzy_match_t;
+
+/** Builds an index over `count` `entries`, allocated by `allocator`.
+    If `allocator` is `NULL`, the standard allocator is used.
+    Returns `NULL` if there are no entries or memory runs out.
+**/
+PSTR_API pstrfuzzy_t *pstrfuzzy_new(
+    const pstring_t *entries, size_t count, allocator_t *allocator
+);
+
+/** Frees all memory resources used by `fuzzy`. **/
+PSTR_API void pstrfuzzy_free(pstrfuzzy_t *fuzzy);
+
+/** Returns the number of entries in `fuzzy`. **/
+PSTR_API size_t pstrfuzzy_count(const pstrfuzzy_t *fuzzy);
+
+/** Callback that receives the index of the entry and its distance. **/
+typedef int(pstrfuzzy_fn)(void *user, size_t index, size_t distance);
+
+/** Calls `fn` for every entry within distance `k` of `query`, in no
+    particular order. If a non-zero value is returned by `fn`, the search
+    is interrupted.
+
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM, PSTRING_EINTR.
+**/
+PSTR_API int pstrfuzzy_each(
+    const pstrfuzzy_t *fuzzy,
+    const pstring_t *query,
+    size_t k,
+    pstrfuzzy_fn *fn,
+    void *user
+);
+
+/** Stores at most `n` entries nearest to `query`, which are within
+    distance `k`, into `out`, ordered by distance and then by index.
+    Returns the number of stored entries.
+
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrfuzzy_nearest(
+    const pstrfuzzy_t *fuzzy,
+    const pstring_t *query,
+    size_t k,
+    pstrfuzzy_match_t *out,
+    size_t n
+);
+
+#endif
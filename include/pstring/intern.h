@@ -0,0 +1,74 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef PSTRING_INTERN_H
+#define PSTRING_INTERN_H
+
+#ifndef PSTR_INLINE
+    #define PSTR_INLINE static inline
+#endif
+
+#ifndef PSTR_API
+    #define PSTR_API
+#endif
+
+#include <stddef.h>
+
+typedef struct allocator_t allocator_t;
+typedef struct pstring_t pstring_t;
+
+/** `pstrintern_t` maps strings to canonical copies, so that equal strings
+    interned by the same pool are represented by the same pointer and can be
+    compared without looking at their contents. Canonical strings are
+    immutable slices, stored next to their contents in arenas, and remain
+    valid until the pool is freed.
+
+    A pool with shards splits strings between multiple dictionaries, each
+    protected by its own lock, so it can be used from multiple threads.
+**/
+typedef struct pstrintern_t pstrintern_t;
+
+/** Creates an interning pool allocated by `allocator`. If `shards` is zero,
+    the pool is not thread-safe and uses no locks, otherwise strings are
+    split between `shards` locked dictionaries.
+    If `allocator` is `NULL`, the standard allocator is used.
+    Returns `NULL` if memory runs out.
+**/
+PSTR_API pstrintern_t *pstrintern_new(size_t shards, allocator_t *allocator);
+
+/** Frees `intern` and all of its canonical strings. **/
+PSTR_API void pstrintern_free(pstrintern_t *intern);
+
+/** Returns the number of distinct strings interned by `intern`. **/
+PSTR_API size_t pstrintern_count(pstrintern_t *intern);
+
+/** Returns the canonical copy of `str`, inserting it into `intern` if it's
+    not already present, or `NULL` if memory runs out.
+**/
+PSTR_API const pstring_t *pstrintern(
+    pstrintern_t *intern, const pstring_t *str
+);
+
+/** Returns the canonical copy of `str` or `NULL` if it's not interned. **/
+PSTR_API const pstring_t *pstrintern_find(
+    pstrintern_t *intern, const pstring_t *str
+);
+
+#endif
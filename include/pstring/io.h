@@ -34,6 +34,7 @@
 #include <stdio.h>
 typedef struct pstring_t pstring_t;
 typedef struct pstream_t pstream_t;
+typedef struct pstrhash_state_t pstrhash_state_t;
 
 #define PSTREAM_STATE_SIZE 24
 
@@ -122,6 +123,18 @@ PSTR_API int pstream_string(pstream_t *out, pstring_t *str);
 **/
 PSTR_API int pstream_json(pstream_t *out, pstream_t *base);
 
+/** Initializes a stream that reads from and writes to `base`, adding every
+    byte passing through it to the hash in `state`, so data can be hashed
+    while it's transferred. `state` must already be started by
+    `pstrhash_init`, and can be finished after the stream is done. Closing
+    the stream closes `base`, and seeking isn't supported.
+
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOSYS.
+**/
+PSTR_API int pstream_hash(
+    pstream_t *out, pstream_t *base, pstrhash_state_t *state
+);
+
 /** Initializes `out` as a custom stream.
     `vtable` and it's members cannot be `NULL`.
 
@@ -0,0 +1,83 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef PSTRING_PARALLEL_H
+#define PSTRING_PARALLEL_H
+
+#ifndef PSTR_INLINE
+    #define PSTR_INLINE static inline
+#endif
+
+#ifndef PSTR_API
+    #define PSTR_API
+#endif
+
+#include <stddef.h>
+
+typedef struct pstring_t pstring_t;
+
+/** Parallel variants of scans split large strings into chunks, which are
+    scanned by a shared pool of worker threads, started as scans ask for
+    more of them, with the calling thread helping out. Searches for substrings
+    extend every chunk by the length of the substring, so matches crossing
+    the chunk boundary are still found, and the results of all chunks are
+    merged into the same result the serial function returns.
+
+    `pstrpar_t` limits how a parallel scan is run, with zero fields meaning
+    their defaults, as does passing `NULL` instead. Strings shorter than
+    `threshold` bytes are scanned serially, as are all strings while the
+    pool is busy with another call, including calls from inside a scan.
+    Workers live until `pstrpar_shutdown` is called, or the process exits.
+**/
+typedef struct pstrpar_t {
+    size_t threads;   /* maximum number of threads, the CPU count by default */
+    size_t threshold; /* minimum length worth splitting, 1 MiB by default */
+} pstrpar_t;
+
+/** Parallel `pstrchr`. **/
+PSTR_API char *pstrchr_par(const pstring_t *str, int ch, const pstrpar_t *par);
+
+/** Parallel `pstrstr`. **/
+PSTR_API char *pstrstr_par(
+    const pstring_t *str, const pstring_t *sub, const pstrpar_t *par
+);
+
+/** Parallel `pstrcount`. **/
+PSTR_API size_t pstrcount_par(
+    const pstring_t *str, const pstring_t *sub, const pstrpar_t *par
+);
+
+/** Parallel `pstrreplc`, which replaces all instances of `src` with `dst`.
+    A non-zero `max` is handled serially, since the instances to replace
+    depend on those before them.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrreplc_par(
+    pstring_t *str, char src, char dst, size_t max, const pstrpar_t *par
+);
+
+/** Stops and joins the worker threads of the pool, waiting for a running
+    scan to finish first. Later parallel scans start new workers as needed,
+    so this only needs to be called before unloading the library, or to
+    release the threads while no scans are expected for a while.
+**/
+PSTR_API void pstrpar_shutdown(void);
+
+#endif
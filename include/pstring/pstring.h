@@ -31,6 +31,7 @@
 
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
 
 typedef struct allocator_t allocator_t;
 struct tm; /* <time.h> */
@@ -86,6 +87,16 @@ typedef struct pstring_t {
     };
 } pstring_t;
 
+/** `pstrset_t` is a set of bytes compiled by `pstrset_init`. Compiled sets
+    classify a whole vector of characters in a constant number of
+    instructions, regardless of how many characters they contain.
+**/
+typedef struct pstrset_t {
+    unsigned char low[16];  /* high nibbles 0-7, indexed by the low nibble */
+    unsigned char high[16]; /* high nibbles 8-15, indexed by the low nibble */
+    unsigned char bitmap[32];
+} pstrset_t;
+
 enum pstring_bool {
     PSTRING_TRUE = 1,
     PSTRING_FALSE = 0,
@@ -184,6 +195,21 @@ PSTR_API int pstrdup(
     pstring_t *out, const pstring_t *str, allocator_t *allocator
 );
 
+/** Initializes `out` as another reference to the buffer of `str`, without
+    copying it. A shared buffer is copied before any of its references is
+    modified and freed with the last one, so references behave like separate
+    strings and can be read from different threads at the same time.
+    `pstrdup` takes a new reference to buffers that are already shared.
+
+    Owned buffers are moved into a shared buffer by the first call, slices
+    and short strings are copied into `out` as they are.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrshare(pstring_t *out, pstring_t *str);
+
+/** Checks if `str` shares its buffer with other strings. **/
+PSTR_API int pstrshared(const pstring_t *str);
+
 /** Initializes `out` and reserves `capacity` bytes.
     Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
 **/
@@ -192,9 +218,10 @@ PSTR_API int pstralloc(pstring_t *out, size_t capacity, allocator_t *alloc);
 /** Frees all resources used by `str`, if it is owned. */
 PSTR_API void pstrfree(pstring_t *str);
 
-/** When `PSTRING_DETECT` is defined, this function detects the
-    SIMD capabilities of the CPU at runtime. Otherwise, the function
-    immediately exits, while the SIMD detection occurs at compile-time.
+/** Kept for compatibility, it immediately exits. The fastest SIMD
+    implementation supported by the CPU (SSE2, SSSE3, AVX2 or AVX-512BW) is
+    selected once, when the library is loaded, with GCC and Clang on x86.
+    Elsewhere, including NEON on AArch64, it's selected at compile-time.
 **/
 PSTR_API void pstrdetect(void);
 
@@ -269,7 +296,7 @@ PSTR_API int pstrgrow(pstring_t *str, size_t count);
 PSTR_API int pstrshrink(pstring_t *str);
 
 /** Removes all characters from `str`, setting it's length to 0. **/
-#define pstrclear(str) pstr__setlen((str), 0)
+#define pstrclear(str) pstr__clear((str))
 
 /** Checks if `left` and `right` pstring are equal. **/
 PSTR_API int pstrequal(const pstring_t *left, const pstring_t *right);
@@ -288,6 +315,16 @@ PSTR_API int pstrequals(
 **/
 PSTR_API int pstrcmp(const pstring_t *left, const pstring_t *right);
 
+/** Compares `left` and `right` like `pstrcmp`, ignoring the case of ASCII
+    letters and Unicode characters with a simple case folding. Characters
+    are compared by their folded code points, while bytes of invalid UTF-8
+    sequences only compare equal to themselves and sort after all of them.
+
+    The `pstrcaseequal` variant checks whether they are equal instead.
+**/
+PSTR_API int pstrcasecmp(const pstring_t *left, const pstring_t *right);
+PSTR_API int pstrcaseequal(const pstring_t *left, const pstring_t *right);
+
 /** Searches for character `ch` from the start of `str`,
     returning it's address if found and `NULL` otherwise.
 
@@ -314,6 +351,17 @@ PSTR_API char *pstrrcpbrk(const pstring_t *str, const char *set);
 **/
 PSTR_API char *pstrstr(const pstring_t *str, const pstring_t *sub);
 
+/** Searches for `sub` inside `str` ignoring case like `pstrcasecmp`,
+    returning the address of the first character of the first match,
+    or `NULL` if not found.
+**/
+PSTR_API char *pstrcasestr(const pstring_t *str, const pstring_t *sub);
+
+/** Counts the non-overlapping matches of `sub` inside `str`, the same ones
+    `pstrrepl` would replace. An empty `sub` has no matches.
+**/
+PSTR_API size_t pstrcount(const pstring_t *str, const pstring_t *sub);
+
 /** Tokenizes input string `src` into a sequence of tokens separated by
     a character inside `set`. If not found, `PSTRING_ENOENT` is returned.
 
@@ -352,6 +400,18 @@ PSTR_INLINE int pstrsplits(
     return pstrsplit(dst, src, &tmp);
 }
 
+/** Splits `src` into fields separated by the substring `sep` in a single
+    pass, storing up to `max` of them into `out` as slices. Empty fields are
+    kept, so there is always one more field than separators found. If `out`
+    is `NULL`, fields are only counted.
+
+    Returns the number of fields in `src`, which is larger than `max` if not
+    all of them were stored, or zero if `sep` is empty.
+**/
+PSTR_API size_t pstrsplit_all(
+    const pstring_t *src, const pstring_t *sep, pstring_t *out, size_t max
+);
+
 /** Returns the number of consecutive characters that appear
     at the start of `str` that are included in the `set`.
 
@@ -365,6 +425,40 @@ PSTR_API size_t pstrcspn(const pstring_t *str, const char *set);
 PSTR_API size_t pstrrspn(const pstring_t *str, const char *set);
 PSTR_API size_t pstrrcspn(const pstring_t *str, const char *set);
 
+/** Compiles `length` characters from `chars` into `out`.
+    If `length` is zero, `strlen` is called.
+    Possible error codes: PSTRING_EINVAL.
+**/
+PSTR_API int pstrset_init(pstrset_t *out, const char *chars, size_t length);
+
+/** Checks if `chr` is included in `set`. **/
+PSTR_INLINE int pstrset_has(const pstrset_t *set, char chr) {
+    unsigned char c = (unsigned char)chr;
+    return (set->bitmap[c >> 3] >> (c & 7)) & 1;
+}
+
+/** Variants of `pstrspn`, `pstrcspn`, `pstrpbrk`, `pstrcpbrk`, `pstrtok` and
+    `pstrstrip` which use a compiled `set`. Unlike their string counterparts,
+    `pstrspn_set` and `pstrcspn_set` return the length of `str` if every
+    character is, or isn't, included in `set`, while `pstrstrip_set` leaves
+    an empty string if every character is included in `set`.
+**/
+PSTR_API size_t pstrspn_set(const pstring_t *str, const pstrset_t *set);
+PSTR_API size_t pstrcspn_set(const pstring_t *str, const pstrset_t *set);
+PSTR_API char *pstrpbrk_set(const pstring_t *str, const pstrset_t *set);
+PSTR_API char *pstrcpbrk_set(const pstring_t *str, const pstrset_t *set);
+PSTR_API int pstrtok_set(
+    pstring_t *dst, const pstring_t *src, const pstrset_t *set
+);
+PSTR_API int pstrstrip_set(pstring_t *str, const pstrset_t *set);
+
+/** Splits `src` like `pstrsplit_all`, where every character included in
+    `set` separates two fields.
+**/
+PSTR_API size_t pstrsplit_set(
+    const pstring_t *src, const pstrset_t *set, pstring_t *out, size_t max
+);
+
 /** Concatenates `src` onto the end of `dst`.
     Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
 **/
@@ -429,16 +523,91 @@ PSTR_API int pstrrepls(
 );
 PSTR_API int pstrreplc(pstring_t *str, char src, char dst, size_t max);
 
+/** Concatenates `src` onto `dst`, replacing at most `max` instances of
+    substring `from` with `to`. If `max` is zero, all instances of `from`
+    will be replaced. `dst` must not overlap with `src`.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrrepl_into(
+    pstring_t *dst,
+    const pstring_t *src,
+    const pstring_t *from,
+    const pstring_t *to,
+    size_t max
+);
+
 /** Returns a non-unique integer value representing the contents of `str`.
+    Uses XXH3 when built with xxHash, and a bundled wyhash otherwise, so the
+    values aren't stable between builds.
+
     Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
 **/
 PSTR_API size_t pstrhash(const pstring_t *str);
 
-/** Returns Damerau–Levenshtein distance between `left` and `right`.
+/** Returns the hash of `str` like `pstrhash`, mixed with `seed`. Keys hashed
+    with a secret random seed can't be picked to collide on purpose.
+**/
+PSTR_API size_t pstrhash_seeded(const pstring_t *str, size_t seed);
+
+/** Stores the `pstrhash` of each of the `count` strings in `strs` in `out`.
+**/
+PSTR_API void pstrhash_many(const pstring_t *strs, size_t count, size_t *out);
+
+/** Stores the `pstrhash_seeded` of each of the `count` strings in `strs` with
+    the same `seed` in `out`, like `pstrhash_many`.
+**/
+PSTR_API void pstrhash_many_seeded(
+    const pstring_t *strs, size_t count, size_t seed, size_t *out
+);
+
+/** State of a hash computed over input arriving in pieces, which gives the
+    same result as `pstrhash_seeded` of all the pieces concatenated.
+**/
+typedef struct pstrhash_state_t {
+    uint64_t seeds[3];
+    uint64_t length;
+    unsigned char buffer[64]; /* the last 16 bytes hashed, then pending ones */
+    void *xxh3;               /* used instead when built with xxHash */
+} pstrhash_state_t;
+
+/** Starts hashing into `state` with `seed`, where a `seed` of zero gives the
+    same result as `pstrhash`. Every started state must be finished by
+    `pstrhash_final`, which releases it.
+
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrhash_init(pstrhash_state_t *state, size_t seed);
+
+/** Adds the contents of `data` to the hash in `state`.
+    Possible error codes: PSTRING_EINVAL.
+**/
+PSTR_API int pstrhash_update(pstrhash_state_t *state, const pstring_t *data);
+
+/** Adds `length` bytes of `data` to the hash in `state`.
+    Possible error codes: PSTRING_EINVAL.
+**/
+PSTR_API int pstrhash_updates(
+    pstrhash_state_t *state, const char *data, size_t length
+);
+
+/** Returns the hash of everything added to `state`, and releases it. **/
+PSTR_API size_t pstrhash_final(pstrhash_state_t *state);
+
+/** Returns the restricted Damerau–Levenshtein (optimal string alignment)
+    distance between `left` and `right`.
     Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
 **/
 PSTR_API int pstrdistance(const pstring_t *left, const pstring_t *right);
 
+/** Returns the same distance as `pstrdistance` if it is at most `max`,
+    and `max + 1` otherwise, stopping as soon as the distance is known
+    to exceed `max`.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrdistance_bounded(
+    const pstring_t *left, const pstring_t *right, size_t max
+);
+
 /** Concatenates the contents of the file onto the end of `out`.
     Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM, PSTRING_EIO.
 **/
@@ -529,6 +698,21 @@ PSTR_API int pstrdedent(pstring_t *str, int count, int tab);
 **/
 PSTR_API int pstrindent(pstring_t *str, int count, int tab);
 
+/** Converts UTF-8 characters in `str` to lowercase or uppercase in place,
+    using simple case mappings. Characters whose mapping has a different
+    encoded length, and invalid sequences, are left unchanged.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrlower(pstring_t *str);
+PSTR_API int pstrupper(pstring_t *str);
+
+/** Concatenates `src` onto `dst`, converted to lowercase or uppercase
+    like `pstrlower` and `pstrupper`. `dst` must not overlap with `src`.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrlower_into(pstring_t *dst, const pstring_t *src);
+PSTR_API int pstrupper_into(pstring_t *dst, const pstring_t *src);
+
 /** Checks if `str` starts with a `prefix`. **/
 PSTR_API int pstrprefix(
     const pstring_t *str, const char *prefix, size_t length
@@ -552,4 +736,39 @@ PSTR_INLINE void pstr__setlen(pstring_t *str, size_t length) {
 
 PSTR_API size_t pstr__nlen(const char *str, size_t max);
 
+/** Allocator of shared buffers, see `pstrshare`. Buffers keep the allocator
+    they were shared from, while new ones allocated through `pstr__shared`,
+    such as those of strings created with the allocator of a shared string,
+    are taken from the standard allocator.
+**/
+PSTR_API extern allocator_t pstr__shared;
+
+/** Copies a shared buffer, unless `str` is its only reference. **/
+PSTR_API int pstr__unshare(pstring_t *str);
+
+/** Makes sure `str` doesn't share its buffer before it's modified.
+    Possible error codes: PSTRING_ENOMEM.
+**/
+PSTR_INLINE int pstr__writable(pstring_t *str) {
+    if (pstrallocator(str) != &pstr__shared)
+        return PSTRING_OK;
+
+    return pstr__unshare(str);
+}
+
+PSTR_INLINE void pstr__clear(pstring_t *str) {
+    /* contents of shared buffers are dropped before they would be copied */
+    if (pstrallocator(str) == &pstr__shared)
+        str->base.length = 0;
+
+    if (pstr__writable(str) == PSTRING_OK)
+        pstr__setlen(str, 0);
+}
+
+/** Levenshtein distance, or `pstrdistance` if `transpose` is non-zero,
+    bounded like `pstrdistance_bounded`. **/
+PSTR_API int pstr__distance(
+    const pstring_t *left, const pstring_t *right, size_t max, int transpose
+);
+
 #endif
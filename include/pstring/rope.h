@@ -0,0 +1,120 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef PSTRING_ROPE_H
+#define PSTRING_ROPE_H
+
+#ifndef PSTR_INLINE
+    #define PSTR_INLINE static inline
+#endif
+
+#ifndef PSTR_API
+    #define PSTR_API
+#endif
+
+#include <stddef.h>
+
+typedef struct allocator_t allocator_t;
+typedef struct pstring_t pstring_t;
+
+/** `pstrrope_t` stores large strings as a balanced tree of chunks, so that
+    inserting and removing text anywhere in the string, splitting it or
+    concatenating two of them takes logarithmic time, instead of moving
+    all the characters after the edit.
+
+    Ropes initialized with `{0}` are empty and use the standard allocator.
+    Contents are read chunk by chunk with `pstrrope_chunk`, which returns
+    slices that work with all read-only `pstring_t` functions, or copied
+    into a `pstring_t` with `pstrrope_flatten`. Inserting, removing and
+    concatenating merge the chunks meeting at the edit when they fit in one,
+    and chunks left less than half full by a removal are merged with their
+    neighbours in the same way.
+**/
+typedef struct pstrrope_t {
+    struct pstrrope_node *root;
+    allocator_t *allocator;
+    unsigned seed;
+} pstrrope_t;
+
+/** Initializes `out` with a copy of `str`, if it's not `NULL`.
+    If `allocator` is `NULL`, the standard allocator is used.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrrope_new(
+    pstrrope_t *out, const pstring_t *str, allocator_t *allocator
+);
+
+/** Frees all resources used by `rope`, leaving it empty. **/
+PSTR_API void pstrrope_free(pstrrope_t *rope);
+
+/** Returns the length, number of bytes, of `rope`. **/
+PSTR_API size_t pstrrope_len(const pstrrope_t *rope);
+
+/** Returns the character at index `i` or `'\0'` if out of bounds. **/
+PSTR_API char pstrrope_get(const pstrrope_t *rope, size_t i);
+
+/** Inserts `src` into `rope` at index `at`.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrrope_insert(pstrrope_t *rope, size_t at, const pstring_t *src);
+
+/** Removes characters from `rope` in the specified range.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrrope_remove(pstrrope_t *rope, size_t from, size_t to);
+
+/** Moves the characters of `rope` starting at index `at` into `out`,
+    which is initialized with the same allocator.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrrope_split(pstrrope_t *rope, size_t at, pstrrope_t *out);
+
+/** Moves the contents of `src` onto the end of `dst`, leaving `src` empty.
+    Both ropes must use the same allocator.
+    Possible error codes: PSTRING_EINVAL.
+**/
+PSTR_API int pstrrope_concat(pstrrope_t *dst, pstrrope_t *src);
+
+/** Stores the part of the chunk which starts at index `at` into `out` as
+    a slice. The whole rope can be visited using:
+
+        for (size_t at = 0; !pstrrope_chunk(rope, at, &chunk);
+             at += pstrlen(&chunk)) { ... }
+
+    Slices remain valid until `rope` is modified.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOENT.
+**/
+PSTR_API int pstrrope_chunk(
+    const pstrrope_t *rope, size_t at, pstring_t *out
+);
+
+/** Concatenates characters of `rope` in the specified range onto `dst`.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrrope_substr(
+    const pstrrope_t *rope, pstring_t *dst, size_t from, size_t to
+);
+
+/** Concatenates all characters of `rope` onto `dst`.
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrrope_flatten(const pstrrope_t *rope, pstring_t *dst);
+
+#endif
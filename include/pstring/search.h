@@ -0,0 +1,113 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef PSTRING_SEARCH_H
+#define PSTRING_SEARCH_H
+
+#ifndef PSTR_INLINE
+    #define PSTR_INLINE static inline
+#endif
+
+#ifndef PSTR_API
+    #define PSTR_API
+#endif
+
+#include <stddef.h>
+
+typedef struct allocator_t allocator_t;
+typedef struct pstring_t pstring_t;
+
+/** `pstrsearch_t` is a compiled set of literal needles which can be searched
+    for in a single pass over the input, regardless of how many needles there
+    are. Needles are copied during compilation, so they don't need to remain
+    valid afterwards.
+**/
+typedef struct pstrsearch_t pstrsearch_t;
+
+/** Compiles `count` non-empty `needles` into a searcher allocated by
+    `allocator`. If `allocator` is `NULL`, the standard allocator is used.
+    Needles that appear more than once are reported using their first index.
+    Returns `NULL` if any of the needles are empty, there are more than
+    `INT_MAX` of them or memory runs out.
+**/
+PSTR_API pstrsearch_t *pstrsearch_new(
+    const pstring_t *needles, size_t count, allocator_t *allocator
+);
+
+/** Frees all memory resources used by `search`. **/
+PSTR_API void pstrsearch_free(pstrsearch_t *search);
+
+/** Returns the number of needles compiled into `search`. **/
+PSTR_API size_t pstrsearch_count(const pstrsearch_t *search);
+
+/** Searches `str` for the leftmost match of any needle, preferring the
+    longest needle if several of them start at the same position. The matched
+    bytes are stored as a slice in `match`, if it's not `NULL`, and the index
+    of the matched needle is returned.
+
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOENT.
+**/
+PSTR_API int pstrsearch_find(
+    const pstrsearch_t *search, const pstring_t *str, pstring_t *match
+);
+
+/** Callback that receives the index of the matched needle and its slice. **/
+typedef int(pstrsearch_fn)(void *user, size_t id, pstring_t *match);
+
+/** Calls `fn` for every, possibly overlapping, match of every needle in
+    `str`, ordered by the position at which the match ends. If a non-zero
+    value is returned by `fn`, the iteration is interrupted.
+
+    Possible error codes: PSTRING_EINVAL, PSTRING_EINTR.
+**/
+PSTR_API int pstrsearch_each(
+    const pstrsearch_t *search,
+    const pstring_t *str,
+    pstrsearch_fn *fn,
+    void *user
+);
+
+/** Concatenates `src` onto `dst`, replacing every leftmost-longest match of
+    needle `i` with `to[i]`. `to` must hold `pstrsearch_count(search)`
+    strings. Replaced text is never searched again and `dst` must not
+    overlap with `src`.
+
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrsearch_repl(
+    const pstrsearch_t *search,
+    pstring_t *dst,
+    const pstring_t *src,
+    const pstring_t *to
+);
+
+/** Replaces every instance of `from[i]` in `str` with `to[i]`, for `n`
+    pairs of strings, in a single pass. If several instances start at the
+    same position, the longest one is replaced. To apply the same pairs
+    many times, compile `from` once with `pstrsearch_new` and use
+    `pstrsearch_repl` instead.
+
+    Possible error codes: PSTRING_EINVAL, PSTRING_ENOMEM.
+**/
+PSTR_API int pstrrepl_many(
+    pstring_t *str, const pstring_t *from, const pstring_t *to, size_t n
+);
+
+#endif
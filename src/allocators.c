@@ -0,0 +1,341 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <pstring/allocators.h>
+#include <pstring/pstring.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "allocator_std.h"
+
+/* Blocks and slabs are aligned to the widest vector type used for string
+   buffers, so every size class is a multiple of it as well. */
+#define GRANULE 32
+#define ALIGN(x, a) (((x) + ((a) - 1)) & ~((uintptr_t)(a) - 1))
+#define HEADER ALIGN(sizeof(struct block), GRANULE)
+#define DATA(block) ((char *)(block) + HEADER)
+
+#define ARENA_BLOCK (64 * 1024)
+#define POOL_SLAB (64 * 1024)
+
+/* Size classes are multiples of `GRANULE` up to 512 bytes, and powers of
+   two up to 8 KiB after that. */
+#define LINEAR_CLASSES 16
+#define LINEAR_MAX (LINEAR_CLASSES * GRANULE)
+#define CLASS_COUNT (LINEAR_CLASSES + 4)
+#define CLASS_MAX 8192
+
+struct block {
+    struct block *next;
+    size_t size; /* bytes available after the header */
+};
+
+typedef struct pstrarena_t {
+    allocator_t base;
+    allocator_t *parent;
+    struct block *first;
+    struct block *current;
+    char *cursor; /* start of the free space in the current block */
+    char *end;    /* end of the current block */
+    char *last;   /* most recent allocation, if it can be resized */
+    size_t block_size;
+    size_t used;
+} pstrarena_t;
+
+typedef struct pstrpool_t {
+    allocator_t base;
+    allocator_t *parent;
+    struct block *slabs;
+    char *cursor; /* start of the unused part of the current slab */
+    char *end;    /* end of the current slab */
+    void *free[CLASS_COUNT];
+} pstrpool_t;
+
+static struct block *new_block(allocator_t *parent, size_t size) {
+    struct block *block = allocate_aligned(parent, HEADER + size, GRANULE);
+    if (!block)
+        return NULL;
+
+    block->next = NULL;
+    block->size = size;
+    return block;
+}
+
+/* Moves the arena to the next block which fits `required` bytes, reusing
+   blocks kept by a reset when they are large enough. */
+static int next_block(pstrarena_t *arena, size_t required) {
+    struct block *next = arena->current ? arena->current->next : arena->first;
+    if (!next || next->size < required) {
+        size_t size = required > arena->block_size ? required
+                                                   : arena->block_size;
+        struct block *block = new_block(arena->parent, size);
+        if (!block)
+            return 0;
+
+        block->next = next;
+        if (arena->current)
+            arena->current->next = block;
+        else
+            arena->first = block;
+
+        next = block;
+    }
+
+    arena->current = next;
+    arena->cursor = DATA(next);
+    arena->end = DATA(next) + next->size;
+    return 1;
+}
+
+static void *arena_alloc(allocator_t *allocator, size_t size, size_t align) {
+    pstrarena_t *arena = (pstrarena_t *)allocator;
+    if (align == 0)
+        align = 1;
+
+    for (;;) {
+        if (arena->current) {
+            char *start = (char *)ALIGN((uintptr_t)arena->cursor, align);
+            if (start <= arena->end && size <= (size_t)(arena->end - start)) {
+                arena->used += (size_t)(start - arena->cursor) + size;
+                arena->cursor = start + size;
+                arena->last = start;
+                return start;
+            }
+        }
+
+        if (size > SIZE_MAX - align || !next_block(arena, size + align))
+            return NULL;
+    }
+}
+
+static void *arena_realloc(
+    allocator_t *allocator, void *ptr, size_t old, size_t size, size_t align
+) {
+    pstrarena_t *arena = (pstrarena_t *)allocator;
+    if (!ptr)
+        return arena_alloc(allocator, size, align);
+
+    /* the most recent allocation ends at the cursor */
+    char *start = ptr;
+    if (start == arena->last && size <= (size_t)(arena->end - start)) {
+        arena->used = arena->used - old + size;
+        arena->cursor = start + size;
+        return ptr;
+    }
+
+    if (size <= old)
+        return ptr;
+
+    void *out = arena_alloc(allocator, size, align);
+    if (out)
+        memcpy(out, ptr, old);
+
+    return out;
+}
+
+static void arena_free(allocator_t *allocator, void *ptr, size_t size) {
+    pstrarena_t *arena = (pstrarena_t *)allocator;
+    if (ptr && ptr == arena->last) {
+        arena->used -= size;
+        arena->cursor = arena->last;
+        arena->last = NULL;
+    }
+}
+
+pstrarena_t *pstrarena_new(size_t block_size, allocator_t *parent) {
+    if (!parent)
+        parent = &standard_allocator;
+
+    pstrarena_t *arena = allocate(parent, sizeof(pstrarena_t));
+    if (!arena)
+        return NULL;
+
+    arena->base = (allocator_t) {
+        .alloc = arena_alloc,
+        .realloc = arena_realloc,
+        .free = arena_free,
+    };
+    arena->parent = parent;
+    arena->first = arena->current = NULL;
+    arena->cursor = arena->end = arena->last = NULL;
+    arena->block_size = block_size ? block_size : ARENA_BLOCK;
+    arena->used = 0;
+    return arena;
+}
+
+void pstrarena_free(pstrarena_t *arena) {
+    if (!arena)
+        return;
+
+    struct block *block = arena->first;
+    while (block) {
+        struct block *next = block->next;
+        deallocate(arena->parent, block, HEADER + block->size);
+        block = next;
+    }
+
+    deallocate(arena->parent, arena, sizeof(pstrarena_t));
+}
+
+void pstrarena_reset(pstrarena_t *arena) {
+    if (!arena)
+        return;
+
+    arena->current = arena->first;
+    arena->cursor = arena->first ? DATA(arena->first) : NULL;
+    arena->end = arena->first ? DATA(arena->first) + arena->first->size
+                              : NULL;
+    arena->last = NULL;
+    arena->used = 0;
+}
+
+allocator_t *pstrarena_allocator(pstrarena_t *arena) {
+    return arena ? &arena->base : NULL;
+}
+
+size_t pstrarena_used(const pstrarena_t *arena) {
+    return arena ? arena->used : 0;
+}
+
+static int class_of(size_t size) {
+    if (size <= LINEAR_MAX)
+        return size ? (int)((size - 1) / GRANULE) : 0;
+
+    int class = LINEAR_CLASSES;
+    for (size_t limit = LINEAR_MAX * 2; limit < size; limit *= 2)
+        class++;
+
+    return class;
+}
+
+static size_t class_size(int class) {
+    if (class < LINEAR_CLASSES)
+        return (size_t)(class + 1) * GRANULE;
+
+    return (size_t)LINEAR_MAX << (class - LINEAR_CLASSES + 1);
+}
+
+static void *pool_alloc(allocator_t *allocator, size_t size, size_t align) {
+    pstrpool_t *pool = (pstrpool_t *)allocator;
+    if (align > GRANULE)
+        return NULL;
+    if (size > CLASS_MAX)
+        return allocate_aligned(pool->parent, size, align);
+
+    int class = class_of(size);
+    void *out = pool->free[class];
+    if (out) {
+        memcpy(&pool->free[class], out, sizeof(void *));
+        return out;
+    }
+
+    size_t length = class_size(class);
+    if ((size_t)(pool->end - pool->cursor) < length) {
+        struct block *slab = new_block(pool->parent, POOL_SLAB);
+        if (!slab)
+            return NULL;
+
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+        pool->cursor = DATA(slab);
+        pool->end = DATA(slab) + slab->size;
+    }
+
+    out = pool->cursor;
+    pool->cursor += length;
+    return out;
+}
+
+static void pool_free(allocator_t *allocator, void *ptr, size_t size) {
+    pstrpool_t *pool = (pstrpool_t *)allocator;
+    if (!ptr)
+        return;
+
+    if (size > CLASS_MAX) {
+        deallocate(pool->parent, ptr, size);
+        return;
+    }
+
+    int class = class_of(size);
+    memcpy(ptr, &pool->free[class], sizeof(void *));
+    pool->free[class] = ptr;
+}
+
+static void *pool_realloc(
+    allocator_t *allocator, void *ptr, size_t old, size_t size, size_t align
+) {
+    pstrpool_t *pool = (pstrpool_t *)allocator;
+    if (!ptr)
+        return pool_alloc(allocator, size, align);
+
+    if (old > CLASS_MAX && size > CLASS_MAX && align <= GRANULE)
+        return reallocate(pool->parent, ptr, old, size);
+
+    if (old <= CLASS_MAX && size <= CLASS_MAX && align <= GRANULE
+        && class_of(old) == class_of(size))
+        return ptr;
+
+    void *out = pool_alloc(allocator, size, align);
+    if (!out)
+        return NULL;
+
+    memcpy(out, ptr, old < size ? old : size);
+    pool_free(allocator, ptr, old);
+    return out;
+}
+
+pstrpool_t *pstrpool_new(allocator_t *parent) {
+    if (!parent)
+        parent = &standard_allocator;
+
+    pstrpool_t *pool = allocate(parent, sizeof(pstrpool_t));
+    if (!pool)
+        return NULL;
+
+    pool->base = (allocator_t) {
+        .alloc = pool_alloc,
+        .realloc = pool_realloc,
+        .free = pool_free,
+    };
+    pool->parent = parent;
+    pool->slabs = NULL;
+    pool->cursor = pool->end = NULL;
+    memset(pool->free, 0, sizeof(pool->free));
+    return pool;
+}
+
+void pstrpool_free(pstrpool_t *pool) {
+    if (!pool)
+        return;
+
+    struct block *slab = pool->slabs;
+    while (slab) {
+        struct block *next = slab->next;
+        deallocate(pool->parent, slab, HEADER + slab->size);
+        slab = next;
+    }
+
+    deallocate(pool->parent, pool, sizeof(pstrpool_t));
+}
+
+allocator_t *pstrpool_allocator(pstrpool_t *pool) {
+    return pool ? &pool->base : NULL;
+}
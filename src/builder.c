@@ -0,0 +1,201 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <pstring/builder.h>
+#include <pstring/io.h>
+#include <pstring/pstring.h>
+
+#include <string.h>
+
+#include "allocator_std.h"
+
+#define MIN_SEGMENT 256
+#define SEGMENT_SIZE(capacity) (sizeof(struct pstrbuilder_segment) + (capacity))
+
+struct pstrbuilder_segment {
+    struct pstrbuilder_segment *next;
+    size_t length;
+    size_t capacity;
+    char data[];
+};
+
+typedef struct pstrbuilder_segment segment_t;
+
+static allocator_t *allocator_of(pstrbuilder_t *builder) {
+    if (!builder->allocator)
+        builder->allocator = &standard_allocator;
+    return builder->allocator;
+}
+
+/* Segments double the total capacity, so the number of segments stays
+   logarithmic in the number of bytes appended. */
+static segment_t *add_segment(pstrbuilder_t *builder, size_t required) {
+    size_t capacity = builder->capacity ? builder->capacity : builder->initial;
+    if (capacity < MIN_SEGMENT)
+        capacity = MIN_SEGMENT;
+    if (capacity < required)
+        capacity = required;
+
+    allocator_t *allocator = allocator_of(builder);
+    segment_t *segment = allocate(allocator, SEGMENT_SIZE(capacity));
+    if (!segment)
+        return NULL;
+
+    segment->next = NULL;
+    segment->length = 0;
+    segment->capacity = capacity;
+    if (builder->tail)
+        builder->tail->next = segment;
+    else
+        builder->head = segment;
+
+    builder->tail = segment;
+    builder->capacity += capacity;
+    builder->segments++;
+    return segment;
+}
+
+int pstrbuilder_new(
+    pstrbuilder_t *out, size_t capacity, allocator_t *allocator
+) {
+    if (!out)
+        return PSTRING_EINVAL;
+
+    out->head = out->tail = NULL;
+    out->allocator = allocator ? allocator : &standard_allocator;
+    out->length = 0;
+    out->capacity = 0;
+    out->segments = 0;
+    out->initial = capacity;
+    return PSTRING_OK;
+}
+
+void pstrbuilder_free(pstrbuilder_t *builder) {
+    if (!builder)
+        return;
+
+    segment_t *segment = builder->head;
+    while (segment) {
+        segment_t *next = segment->next;
+        deallocate(
+            allocator_of(builder), segment, SEGMENT_SIZE(segment->capacity)
+        );
+        segment = next;
+    }
+
+    builder->head = builder->tail = NULL;
+    builder->length = 0;
+    builder->capacity = 0;
+    builder->segments = 0;
+}
+
+size_t pstrbuilder_len(const pstrbuilder_t *builder) {
+    return builder ? builder->length : 0;
+}
+
+int pstrbuilder_stats(const pstrbuilder_t *builder, pstrbuilder_stats_t *out) {
+    if (!builder || !out)
+        return PSTRING_EINVAL;
+
+    out->length = builder->length;
+    out->capacity = builder->capacity;
+    out->segments = builder->segments;
+    return PSTRING_OK;
+}
+
+int pstrbuilder_cats(pstrbuilder_t *builder, const char *src, size_t length) {
+    if (!builder || !src)
+        return PSTRING_EINVAL;
+
+    if (length == 0)
+        length = strlen(src);
+
+    segment_t *segment = builder->tail;
+    size_t available = segment ? segment->capacity - segment->length : 0;
+    if (available > length)
+        available = length;
+
+    /* the rest of the string goes into a single new segment */
+    if (available < length && !add_segment(builder, length - available))
+        return PSTRING_ENOMEM;
+
+    if (available) {
+        memcpy(&segment->data[segment->length], src, available);
+        segment->length += available;
+    }
+
+    if (available < length) {
+        segment = builder->tail;
+        memcpy(segment->data, &src[available], length - available);
+        segment->length = length - available;
+    }
+
+    builder->length += length;
+    return PSTRING_OK;
+}
+
+int pstrbuilder_cat(pstrbuilder_t *builder, const pstring_t *src) {
+    if (!builder || !src)
+        return PSTRING_EINVAL;
+    if (pstrlen(src) == 0)
+        return PSTRING_OK;
+
+    return pstrbuilder_cats(builder, pstrbuf(src), pstrlen(src));
+}
+
+int pstrbuilder_catc(pstrbuilder_t *builder, char chr) {
+    return pstrbuilder_cats(builder, &chr, 1);
+}
+
+int pstrbuilder_join(const pstrbuilder_t *builder, pstring_t *dst) {
+    if (!builder || !dst)
+        return PSTRING_EINVAL;
+
+    if (pstr__writable(dst))
+        return PSTRING_ENOMEM;
+
+    size_t length = pstrlen(dst) + builder->length;
+    if (length > pstrcap(dst)) {
+        int res = pstrgrow(dst, length - pstrcap(dst));
+        if (res != PSTRING_OK)
+            return res;
+    }
+
+    char *out = pstrend(dst);
+    for (segment_t *segment = builder->head; segment; segment = segment->next) {
+        memcpy(out, segment->data, segment->length);
+        out += segment->length;
+    }
+
+    pstr__setlen(dst, length);
+    return PSTRING_OK;
+}
+
+int pstrbuilder_write(const pstrbuilder_t *builder, pstream_t *stream) {
+    if (!builder || !stream)
+        return PSTRING_EINVAL;
+
+    for (segment_t *segment = builder->head; segment; segment = segment->next)
+        if (pstream_write(stream, segment->data, segment->length)
+            != segment->length)
+            return PSTRING_EIO;
+
+    return PSTRING_OK;
+}
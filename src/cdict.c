@@ -0,0 +1,573 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <pstring/cdict.h>
+#include <pstring/pstring.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "allocator_std.h"
+#include "internal.h"
+
+/* Tables use the bucket layout of `pstrdict_t`, with a byte of each hash
+   matched first, then the full hashes and the pairs. Every field is atomic,
+   so readers can load them while a writer changes them, and the bytes are
+   loaded as words of 8. */
+#define CDICT_BUCKET_SIZE 16
+#define CDICT_WORDS (CDICT_BUCKET_SIZE / 8)
+#define CDICT_THRESHOLD 0.7
+#define CDICT_EMPTY 0
+#define CDICT_TOMB 1
+
+#define DEFAULT_SHARDS 64
+#define CACHE_LINE 64
+
+#define BYTES(x) (0x0101010101010101ull * (x))
+
+struct pair {
+    _Atomic(const pstring_t *) key;
+    _Atomic(const void *) value;
+};
+
+struct bucket {
+    _Atomic uint64_t parts[CDICT_WORDS];
+    _Atomic size_t hashes[CDICT_BUCKET_SIZE];
+    struct pair pairs[CDICT_BUCKET_SIZE];
+};
+
+struct table {
+    size_t capacity;       /* number of slots, a power of two */
+    struct table *retired; /* table it replaced, readers may still use it */
+    struct bucket buckets[];
+};
+
+/* Readers of a shard only load from it, and shards are aligned to cache
+   lines, so only writers of the same shard invalidate the lines they use. */
+struct shard {
+    _Alignas(CACHE_LINE) atomic_uint seq; /* odd while the table changes */
+    _Atomic(struct table *) table;
+    atomic_size_t count;
+    pthread_mutex_t lock; /* held by writers, protects the fields below */
+    size_t tombs;
+};
+
+typedef struct pstrcdict_t {
+    allocator_t *allocator;
+    size_t seed;
+    size_t size;  /* size of the allocation */
+    size_t count; /* number of shards, a power of two */
+    struct shard shards[];
+} pstrcdict_t;
+
+/* Buckets are indexed by the low bits of the hash, while the byte stored in
+   metadata and the shard are taken from the high bits after mixing. */
+static inline uint8_t hash_part(size_t hash) {
+    uint8_t part = ((uint64_t)hash * 0x9E3779B97F4A7C15ull) >> 56;
+    if (part == CDICT_EMPTY)
+        part++;
+    if (part == CDICT_TOMB)
+        part++;
+    return part;
+}
+
+static inline struct shard *shard_of(const pstrcdict_t *dict, size_t hash) {
+    uint64_t mixed = (uint64_t)hash * 0x9E3779B97F4A7C15ull;
+    return (struct shard *)&dict->shards[(mixed >> 32) & (dict->count - 1)];
+}
+
+/* Returns a mask of the slots in `b` whose byte is `part`. Bytes are compared
+   a word at a time, setting the high bit of each equal byte without carries
+   between them, and the high bits are then gathered into the top byte. */
+static inline uint32_t bucket_match(struct bucket *b, uint8_t part) {
+    uint32_t out = 0;
+
+    for (int w = 0; w < CDICT_WORDS; w++) {
+        uint64_t word
+            = atomic_load_explicit(&b->parts[w], memory_order_relaxed);
+        uint64_t x = word ^ BYTES(part);
+        uint64_t equal = ~(((x & BYTES(0x7F)) + BYTES(0x7F)) | x) & BYTES(0x80);
+
+        out |= (uint32_t)(((equal >> 7) * 0x0102040810204080ull) >> 56)
+            << (w * 8);
+    }
+
+    return out;
+}
+
+static inline uint8_t get_part(struct bucket *b, uint8_t i) {
+    uint64_t word
+        = atomic_load_explicit(&b->parts[i / 8], memory_order_relaxed);
+    return word >> (i % 8 * 8);
+}
+
+static inline void set_part(struct bucket *b, uint8_t i, uint8_t part) {
+    uint64_t word
+        = atomic_load_explicit(&b->parts[i / 8], memory_order_relaxed);
+    word &= ~((uint64_t)0xFF << (i % 8 * 8));
+    word |= (uint64_t)part << (i % 8 * 8);
+    atomic_store_explicit(&b->parts[i / 8], word, memory_order_relaxed);
+}
+
+static uint8_t bitset_next(uint32_t *set) {
+    for (uint8_t i = 0;; i++) {
+        if (*set & (1u << i)) {
+            *set &= ~(1u << i);
+            return i;
+        }
+    }
+}
+
+static inline struct bucket *iter_init(struct table *table, size_t hash) {
+    return &table->buckets[(hash & (table->capacity - 1)) / CDICT_BUCKET_SIZE];
+}
+
+static inline struct bucket *iter_next(struct table *table, struct bucket *b) {
+    return ++b >= &table->buckets[table->capacity / CDICT_BUCKET_SIZE]
+        ? table->buckets
+        : b;
+}
+
+/* Writers make the sequence odd while they change a table, and readers retry
+   if it was odd or changed while they were looking. The fences order the
+   relaxed accesses of the table against the sequence. */
+static void write_begin(struct shard *shard) {
+    unsigned seq = atomic_load_explicit(&shard->seq, memory_order_relaxed);
+    atomic_store_explicit(&shard->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static void write_end(struct shard *shard) {
+    unsigned seq = atomic_load_explicit(&shard->seq, memory_order_relaxed);
+    atomic_store_explicit(&shard->seq, seq + 1, memory_order_release);
+}
+
+/* Finds the slot of `key`, which may be torn while a writer changes the table,
+   so the probe stops after visiting every bucket, as there might be no empty
+   slot, and keys that aren't stored yet are skipped. */
+static const void *find(
+    struct table *table, const pstring_t *key, size_t hash
+) {
+    if (!table)
+        return NULL;
+
+    uint8_t part = hash_part(hash);
+    struct bucket *b = iter_init(table, hash);
+
+    for (size_t n = table->capacity / CDICT_BUCKET_SIZE; n > 0; n--) {
+        uint32_t matches = bucket_match(b, part);
+
+        /* pairs with the fence in `put`, so the matched slots hold the
+           pairs stored before their bytes */
+        if (matches)
+            atomic_thread_fence(memory_order_acquire);
+
+        while (matches) {
+            uint8_t i = bitset_next(&matches);
+            size_t other_hash
+                = atomic_load_explicit(&b->hashes[i], memory_order_relaxed);
+            const pstring_t *other
+                = atomic_load_explicit(&b->pairs[i].key, memory_order_relaxed);
+
+            if (other_hash == hash && other && pstrequal(key, other))
+                return atomic_load_explicit(
+                    &b->pairs[i].value, memory_order_relaxed
+                );
+        }
+
+        if (bucket_match(b, CDICT_EMPTY))
+            break;
+
+        b = iter_next(table, b);
+    }
+
+    return NULL;
+}
+
+/* Finds the slot of `key` in a table only changed by the calling writer. */
+static struct bucket *find_slot(
+    struct table *table, const pstring_t *key, size_t hash, uint8_t *out
+) {
+    if (!table)
+        return NULL;
+
+    uint8_t part = hash_part(hash);
+    struct bucket *b = iter_init(table, hash);
+
+    while (1) {
+        uint32_t matches = bucket_match(b, part);
+
+        while (matches) {
+            uint8_t i = bitset_next(&matches);
+            const pstring_t *other
+                = atomic_load_explicit(&b->pairs[i].key, memory_order_relaxed);
+
+            if (atomic_load_explicit(&b->hashes[i], memory_order_relaxed)
+                    == hash
+                && pstrequal(key, other)) {
+                *out = i;
+                return b;
+            }
+        }
+
+        if (bucket_match(b, CDICT_EMPTY))
+            return NULL;
+
+        b = iter_next(table, b);
+    }
+}
+
+/* Finds the first empty or removed slot for `hash`. */
+static struct bucket *free_slot(
+    struct table *table, size_t hash, uint8_t *out
+) {
+    struct bucket *b = iter_init(table, hash);
+    uint32_t matches;
+
+    while (!(matches = bucket_match(b, CDICT_EMPTY)
+                       | bucket_match(b, CDICT_TOMB)))
+        b = iter_next(table, b);
+
+    *out = bitset_next(&matches);
+    return b;
+}
+
+/* Stores a pair in a free slot. The fence orders the pair before its byte,
+   so readers that see the byte also see the pair and not the one removed
+   from the slot before. */
+static void put(
+    struct bucket *b,
+    uint8_t i,
+    const pstring_t *key,
+    const void *value,
+    size_t hash
+) {
+    atomic_store_explicit(&b->hashes[i], hash, memory_order_relaxed);
+    atomic_store_explicit(&b->pairs[i].key, key, memory_order_relaxed);
+    atomic_store_explicit(&b->pairs[i].value, value, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    set_part(b, i, hash_part(hash));
+}
+
+/* Copies the pairs into a new table of `capacity` slots and publishes it.
+   The old table is left untouched for readers still using it. */
+static int grow(pstrcdict_t *dict, struct shard *shard, size_t capacity) {
+    struct table *old
+        = atomic_load_explicit(&shard->table, memory_order_relaxed);
+    struct table *table = zallocate(
+        dict->allocator,
+        sizeof(struct table)
+            + capacity / CDICT_BUCKET_SIZE * sizeof(struct bucket)
+    );
+    if (!table)
+        return PSTRING_ENOMEM;
+
+    table->capacity = capacity;
+    table->retired = old;
+
+    size_t buckets = old ? old->capacity / CDICT_BUCKET_SIZE : 0;
+    for (size_t n = 0; n < buckets; n++) {
+        struct bucket *b = &old->buckets[n];
+
+        for (uint8_t i = 0; i < CDICT_BUCKET_SIZE; i++) {
+            uint8_t part = get_part(b, i);
+            if (part == CDICT_EMPTY || part == CDICT_TOMB)
+                continue;
+
+            size_t hash
+                = atomic_load_explicit(&b->hashes[i], memory_order_relaxed);
+            uint8_t j;
+            struct bucket *to = free_slot(table, hash, &j);
+
+            put(
+                to,
+                j,
+                atomic_load_explicit(&b->pairs[i].key, memory_order_relaxed),
+                atomic_load_explicit(&b->pairs[i].value, memory_order_relaxed),
+                hash
+            );
+        }
+    }
+
+    shard->tombs = 0;
+    atomic_store_explicit(&shard->table, table, memory_order_release);
+    return PSTRING_OK;
+}
+
+/* Drops removed slots in place, like `pstrdict_compact`: pairs are marked as
+   removed, then each is moved to the first empty or marked slot of its probe
+   chain, swapping places with a marked pair. */
+static void rehash(struct shard *shard) {
+    struct table *table
+        = atomic_load_explicit(&shard->table, memory_order_relaxed);
+    struct bucket *end = &table->buckets[table->capacity / CDICT_BUCKET_SIZE];
+
+    for (struct bucket *b = table->buckets; b < end; b++) {
+        for (uint8_t i = 0; i < CDICT_BUCKET_SIZE; i++) {
+            uint8_t part = get_part(b, i);
+            set_part(
+                b,
+                i,
+                part == CDICT_EMPTY || part == CDICT_TOMB ? CDICT_EMPTY
+                                                          : CDICT_TOMB
+            );
+        }
+    }
+
+    for (struct bucket *b = table->buckets; b < end; b++) {
+        for (uint8_t i = 0; i < CDICT_BUCKET_SIZE; i++) {
+            while (get_part(b, i) == CDICT_TOMB) {
+                size_t hash
+                    = atomic_load_explicit(&b->hashes[i], memory_order_relaxed);
+                const pstring_t *key = atomic_load_explicit(
+                    &b->pairs[i].key, memory_order_relaxed
+                );
+                const void *value = atomic_load_explicit(
+                    &b->pairs[i].value, memory_order_relaxed
+                );
+
+                uint8_t j;
+                struct bucket *to = free_slot(table, hash, &j);
+
+                if (to == b) {
+                    set_part(b, i, hash_part(hash));
+                    break;
+                }
+
+                /* an empty slot ends the chain, a marked pair is swapped in
+                   and moved next */
+                uint8_t state = get_part(to, j);
+                put(
+                    b,
+                    i,
+                    atomic_load_explicit(
+                        &to->pairs[j].key, memory_order_relaxed
+                    ),
+                    atomic_load_explicit(
+                        &to->pairs[j].value, memory_order_relaxed
+                    ),
+                    atomic_load_explicit(&to->hashes[j], memory_order_relaxed)
+                );
+                set_part(b, i, state);
+                put(to, j, key, value, hash);
+            }
+        }
+    }
+
+    shard->tombs = 0;
+}
+
+/* Makes room for one more pair in `shard`, like `pstrdict_reserve`. */
+static int reserve(pstrcdict_t *dict, struct shard *shard) {
+    struct table *table
+        = atomic_load_explicit(&shard->table, memory_order_relaxed);
+    size_t count = atomic_load_explicit(&shard->count, memory_order_relaxed);
+    size_t capacity = table ? table->capacity : 0;
+
+    if (count + shard->tombs + 1 <= capacity * CDICT_THRESHOLD)
+        return PSTRING_OK;
+
+    if (count + 1 <= capacity * CDICT_THRESHOLD * 3 / 4) {
+        write_begin(shard);
+        rehash(shard);
+        write_end(shard);
+        return PSTRING_OK;
+    }
+
+    return grow(dict, shard, capacity ? capacity * 2 : CDICT_BUCKET_SIZE);
+}
+
+pstrcdict_t *pstrcdict_new(size_t shards, allocator_t *allocator) {
+    if (!allocator)
+        allocator = &standard_allocator;
+
+    size_t count = 1;
+    while (count < (shards ? shards : DEFAULT_SHARDS)) {
+        if (count > (SIZE_MAX - sizeof(pstrcdict_t)) / sizeof(struct shard) / 2)
+            return NULL;
+        count *= 2;
+    }
+
+    size_t size = sizeof(pstrcdict_t) + count * sizeof(struct shard);
+    pstrcdict_t *dict
+        = allocate_aligned(allocator, size, _Alignof(pstrcdict_t));
+    if (!dict)
+        return NULL;
+
+    memset(dict, 0, size);
+    dict->allocator = allocator;
+    dict->seed = pstr__random_seed(dict);
+    dict->size = size;
+    dict->count = count;
+
+    for (size_t i = 0; i < count; i++) {
+        if (pthread_mutex_init(&dict->shards[i].lock, NULL)) {
+            dict->count = i;
+            pstrcdict_free(dict);
+            return NULL;
+        }
+    }
+
+    return dict;
+}
+
+void pstrcdict_free(pstrcdict_t *dict) {
+    if (!dict)
+        return;
+
+    for (size_t i = 0; i < dict->count; i++) {
+        struct shard *shard = &dict->shards[i];
+        struct table *table
+            = atomic_load_explicit(&shard->table, memory_order_relaxed);
+
+        while (table) {
+            struct table *retired = table->retired;
+            deallocate(
+                dict->allocator,
+                table,
+                sizeof(struct table)
+                    + table->capacity / CDICT_BUCKET_SIZE
+                          * sizeof(struct bucket)
+            );
+            table = retired;
+        }
+
+        pthread_mutex_destroy(&shard->lock);
+    }
+
+    deallocate(dict->allocator, dict, dict->size);
+}
+
+size_t pstrcdict_count(const pstrcdict_t *dict) {
+    if (!dict)
+        return 0;
+
+    size_t count = 0;
+    for (size_t i = 0; i < dict->count; i++) {
+        struct shard *shard = (struct shard *)&dict->shards[i];
+        count += atomic_load_explicit(&shard->count, memory_order_relaxed);
+    }
+
+    return count;
+}
+
+void *pstrcdict_get(const pstrcdict_t *dict, const pstring_t *key) {
+    if (!dict || !key)
+        return NULL;
+
+    size_t hash = pstrhash_seeded(key, dict->seed);
+    struct shard *shard = shard_of(dict, hash);
+
+    while (1) {
+        unsigned seq = atomic_load_explicit(&shard->seq, memory_order_acquire);
+        if (seq & 1)
+            continue;
+
+        struct table *table
+            = atomic_load_explicit(&shard->table, memory_order_acquire);
+        const void *value = find(table, key, hash);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&shard->seq, memory_order_relaxed) == seq)
+            return (void *)value;
+    }
+}
+
+static int store(
+    pstrcdict_t *dict, const pstring_t *key, const void *value, int replace
+) {
+    if (!dict || !key || !value)
+        return PSTRING_EINVAL;
+
+    size_t hash = pstrhash_seeded(key, dict->seed);
+    struct shard *shard = shard_of(dict, hash);
+    int out = PSTRING_OK;
+    uint8_t i;
+
+    pthread_mutex_lock(&shard->lock);
+
+    struct table *table
+        = atomic_load_explicit(&shard->table, memory_order_relaxed);
+    struct bucket *b = find_slot(table, key, hash, &i);
+
+    if (b && !replace) {
+        out = PSTRING_EEXIST;
+    } else if (b) {
+        /* readers see either value whole, so the sequence stays the same */
+        atomic_store_explicit(&b->pairs[i].value, value, memory_order_release);
+    } else if (reserve(dict, shard)) {
+        out = PSTRING_ENOMEM;
+    } else {
+        table = atomic_load_explicit(&shard->table, memory_order_relaxed);
+        b = free_slot(table, hash, &i);
+        if (get_part(b, i) == CDICT_TOMB)
+            shard->tombs--;
+
+        write_begin(shard);
+        put(b, i, key, value, hash);
+        write_end(shard);
+        atomic_fetch_add_explicit(&shard->count, 1, memory_order_relaxed);
+    }
+
+    pthread_mutex_unlock(&shard->lock);
+    return out;
+}
+
+int pstrcdict_set(pstrcdict_t *dict, const pstring_t *key, const void *value) {
+    return store(dict, key, value, PSTRING_TRUE);
+}
+
+int pstrcdict_insert(
+    pstrcdict_t *dict, const pstring_t *key, const void *value
+) {
+    return store(dict, key, value, PSTRING_FALSE);
+}
+
+int pstrcdict_remove(pstrcdict_t *dict, const pstring_t *key) {
+    if (!dict || !key)
+        return PSTRING_EINVAL;
+
+    size_t hash = pstrhash_seeded(key, dict->seed);
+    struct shard *shard = shard_of(dict, hash);
+    uint8_t i;
+
+    pthread_mutex_lock(&shard->lock);
+
+    struct table *table
+        = atomic_load_explicit(&shard->table, memory_order_relaxed);
+    struct bucket *b = find_slot(table, key, hash, &i);
+
+    if (b) {
+        /* only full buckets need a tombstone to keep probe chains intact */
+        int empty = bucket_match(b, CDICT_EMPTY) != 0;
+
+        write_begin(shard);
+        set_part(b, i, empty ? CDICT_EMPTY : CDICT_TOMB);
+        write_end(shard);
+
+        shard->tombs += !empty;
+        atomic_fetch_sub_explicit(&shard->count, 1, memory_order_relaxed);
+    }
+
+    pthread_mutex_unlock(&shard->lock);
+    return b ? PSTRING_OK : PSTRING_ENOENT;
+}
@@ -21,15 +21,28 @@
 #include <pstring/dictionary.h>
 #include <pstring/pstring.h>
 
+#include <stdatomic.h>
 #include <stdint.h>
+#include <string.h>
+#include <time.h>
 
 #include "allocator_std.h"
+#include "internal.h"
 
 #define PSTRDICT_BUCKET_SIZE 16
 #define PSTRDICT_THRESHOLD 0.7
 #define PSTRDICT_EMPTY 0
 #define PSTRDICT_TOMB 1
 
+#if defined(__linux__)
+    #define PSTRDICT_GETRANDOM
+    #include <sys/random.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) \
+    || defined(__NetBSD__)
+    #define PSTRDICT_ARC4RANDOM
+    #include <stdlib.h>
+#endif
+
 #if !defined(PSTRING_NO_SIMD) && defined(__SSE2__) && PSTRDICT_BUCKET_SIZE >= 16
     #define PSTRDICT_SSE2
     #include <emmintrin.h>
@@ -49,14 +62,17 @@ union metadata {
 
 struct bucket {
     union metadata meta;
+    size_t hashes[PSTRDICT_BUCKET_SIZE]; /* full hashes of the keys */
     struct pair pairs[PSTRDICT_BUCKET_SIZE];
 };
 
 struct pstrdict_t {
     struct bucket *buckets;
     size_t count;
+    size_t tombs; /* slots of removed pairs, still part of probe chains */
     size_t capacity;
-    pstrhash_fn *hash;
+    pstrhash_fn *hash; /* `NULL` for `pstrhash_seeded` with `seed` */
+    size_t seed;
     allocator_t *allocator;
 };
 
@@ -93,8 +109,10 @@ static inline size_t round_pow2(size_t v) {
     return v;
 }
 
+/* Buckets are indexed by the low bits of the hash, so the part stored in
+   metadata is taken from the high bits of the hash mixed with all of them. */
 static inline uint8_t hash_part(size_t hash) {
-    uint8_t part = hash & 0xFF;
+    uint8_t part = ((uint64_t)hash * 0x9E3779B97F4A7C15ull) >> 56;
     if (part == PSTRDICT_EMPTY)
         part++;
     if (part == PSTRDICT_TOMB)
@@ -102,30 +120,130 @@ static inline uint8_t hash_part(size_t hash) {
     return part;
 }
 
-pstrdict_t *pstrdict_new(pstrhash_fn *hash, allocator_t *allocator) {
+static inline size_t dict_hash(const pstrdict_t *dict, const pstring_t *key) {
+    return dict->hash ? dict->hash(key) : pstrhash_seeded(key, dict->seed);
+}
+
+static inline void key_init(
+    const pstrdict_t *dict, pstrkey_t *out, const pstring_t *str
+) {
+    out->str = str;
+    out->hash = dict_hash(dict, str);
+    out->hasher = dict->hash;
+    out->seed = dict->seed;
+}
+
+/* Returns the hash of `key` in `dict`, which is the precomputed one unless
+   the key was hashed by a dictionary hashing keys differently. */
+static inline size_t key_hash(const pstrdict_t *dict, const pstrkey_t *key) {
+    if (key->hasher == dict->hash && (dict->hash || key->seed == dict->seed))
+        return key->hash;
+
+    return dict_hash(dict, key->str);
+}
+
+static uint8_t bitset_next(uint64_t *set) {
+    if (!set)
+        return 0;
+
+    for (uint8_t i = 0;; i++) {
+        if (*set & (1 << i)) {
+            *set &= ~((uint64_t)1 << i);
+            return i;
+        }
+    }
+}
+
+struct pstrdict_iter {
+    struct bucket *buckets;
+    struct bucket *current;
+    size_t mask;
+    size_t b;
+};
+
+static inline struct bucket *iter_init(const pstrdict_t *dict, size_t hash) {
+    return &dict->buckets[(hash & (dict->capacity - 1)) / PSTRDICT_BUCKET_SIZE];
+}
+
+static inline struct bucket *iter_end(const pstrdict_t *dict) {
+    size_t end = dict->capacity / PSTRDICT_BUCKET_SIZE;
+    return &dict->buckets[end];
+}
+
+static inline struct bucket *iter_next(
+    const pstrdict_t *dict, struct bucket *prev
+) {
+    return ++prev >= iter_end(dict) ? dict->buckets : prev;
+}
+
+size_t pstr__random_seed(const void *salt) {
+    static atomic_size_t counter;
+    size_t seed;
+
+#if defined(PSTRDICT_GETRANDOM)
+    if (getrandom(&seed, sizeof(seed), GRND_NONBLOCK) == sizeof(seed))
+        return seed;
+#elif defined(PSTRDICT_ARC4RANDOM)
+    arc4random_buf(&seed, sizeof(seed));
+    return seed;
+#endif
+
+    struct {
+        struct timespec time;
+        const void *salt;
+        size_t count;
+    } state;
+
+    memset(&state, 0, sizeof(state));
+    timespec_get(&state.time, TIME_UTC);
+    state.salt = salt;
+    state.count = atomic_fetch_add_explicit(&counter, 1, memory_order_relaxed);
+
+    pstring_t bytes;
+    pstrwrap(&bytes, (char *)&state, sizeof(state), sizeof(state));
+    return pstrhash_seeded(&bytes, (size_t)(uintptr_t)&counter);
+}
+
+static pstrdict_t *dict_new(
+    pstrhash_fn *hash, size_t seed, allocator_t *allocator
+) {
     if (!allocator)
         allocator = &standard_allocator;
-    if (!hash)
-        hash = &pstrhash;
 
     pstrdict_t *out = allocate(allocator, sizeof(pstrdict_t));
 
     if (out) {
         out->buckets = NULL;
         out->count = 0;
+        out->tombs = 0;
         out->capacity = 0;
         out->hash = hash;
+        out->seed = seed;
         out->allocator = allocator;
     }
 
     return out;
 }
 
+pstrdict_t *pstrdict_new(pstrhash_fn *hash, allocator_t *allocator) {
+    pstrdict_t *out = dict_new(hash, 0, allocator);
+
+    if (out && !hash)
+        out->seed = pstr__random_seed(out);
+
+    return out;
+}
+
+pstrdict_t *pstrdict_new_seeded(size_t seed, allocator_t *allocator) {
+    return dict_new(NULL, seed, allocator);
+}
+
 void pstrdict_clear(pstrdict_t *dict) {
     if (!dict)
         return;
 
     dict->count = 0;
+    dict->tombs = 0;
     for (size_t b = 0; b < dict->capacity / PSTRDICT_BUCKET_SIZE; b++) {
         union metadata *meta = &dict->buckets[b].meta;
         memset(meta, 0, sizeof(union metadata));
@@ -149,20 +267,65 @@ static int grow_empty(pstrdict_t *dict, size_t capacity) {
     return PSTRING_OK;
 }
 
-static int grow_not_empty(pstrdict_t *dict, size_t capacity) {
+/* Removes the pair in slot `i`. Lookups stop at a bucket with an empty
+   slot, so only full buckets need a tombstone to keep probe chains intact. */
+static void clear_slot(pstrdict_t *dict, struct bucket *b, uint8_t i) {
+    if (bucket_match(&b->meta, PSTRDICT_EMPTY)) {
+        b->meta.hashes[i] = PSTRDICT_EMPTY;
+    } else {
+        b->meta.hashes[i] = PSTRDICT_TOMB;
+        dict->tombs++;
+    }
+
+    dict->count--;
+}
+
+/* Stores the pair in the first empty or removed slot for `hash`, without
+   looking for its key, after space for it has been reserved. */
+static void place(
+    pstrdict_t *dict, const pstring_t *key, const void *value, size_t hash
+) {
+    struct bucket *b = iter_init(dict, hash);
+    uint64_t matches;
+
+    while (!(matches = bucket_match(&b->meta, PSTRDICT_EMPTY)
+                       | bucket_match(&b->meta, PSTRDICT_TOMB)))
+        b = iter_next(dict, b);
+
+    uint8_t i = bitset_next(&matches);
+    if (b->meta.hashes[i] == PSTRDICT_TOMB)
+        dict->tombs--;
+
+    dict->count++;
+    b->meta.hashes[i] = hash_part(hash);
+    b->hashes[i] = hash;
+    b->pairs[i].key = key;
+    b->pairs[i].value = value;
+}
+
+/* Moves every pair to a table of `capacity` slots, placing them by their
+   stored hashes without reading their keys. */
+static int resize(pstrdict_t *dict, size_t capacity) {
     pstrdict_t tmp = *dict;
     tmp.buckets = NULL;
     tmp.capacity = 0;
     tmp.count = 0;
+    tmp.tombs = 0;
 
     if (grow_empty(&tmp, capacity))
         return PSTRING_ENOMEM;
 
     for (size_t b = 0; b < dict->capacity / PSTRDICT_BUCKET_SIZE; b++) {
-        struct pair *pairs = dict->buckets[b].pairs;
+        struct bucket *bucket = &dict->buckets[b];
+
+        for (size_t i = 0; i < PSTRDICT_BUCKET_SIZE; i++) {
+            uint8_t part = bucket->meta.hashes[i];
+            if (part == PSTRDICT_EMPTY || part == PSTRDICT_TOMB)
+                continue;
 
-        for (size_t i = 0; i < PSTRDICT_BUCKET_SIZE; i++)
-            pstrdict_finsert(&tmp, pairs[i].key, pairs[i].value);
+            struct pair *pair = &bucket->pairs[i];
+            place(&tmp, pair->key, pair->value, bucket->hashes[i]);
+        }
     }
 
     deallocate(
@@ -175,19 +338,125 @@ static int grow_not_empty(pstrdict_t *dict, size_t capacity) {
     return PSTRING_OK;
 }
 
+/* Rebuilds the table without tombstones at the same capacity. Pairs are
+   first marked as tombstones, then each is moved to the first empty or
+   marked slot of its probe chain, swapping places with a marked pair. */
+static void rehash(pstrdict_t *dict) {
+    struct bucket *end = iter_end(dict);
+
+    for (struct bucket *b = dict->buckets; b < end; b++) {
+        for (size_t i = 0; i < PSTRDICT_BUCKET_SIZE; i++) {
+            uint8_t part = b->meta.hashes[i];
+            b->meta.hashes[i] = part == PSTRDICT_EMPTY || part == PSTRDICT_TOMB
+                ? PSTRDICT_EMPTY
+                : PSTRDICT_TOMB;
+        }
+    }
+
+    dict->tombs = 0;
+    for (struct bucket *b = dict->buckets; b < end; b++) {
+        for (uint8_t i = 0; i < PSTRDICT_BUCKET_SIZE; i++) {
+            while (b->meta.hashes[i] == PSTRDICT_TOMB) {
+                size_t hash = b->hashes[i];
+                struct bucket *to = iter_init(dict, hash);
+                uint64_t matches;
+
+                while (!(matches = bucket_match(&to->meta, PSTRDICT_EMPTY)
+                                   | bucket_match(&to->meta, PSTRDICT_TOMB)))
+                    to = iter_next(dict, to);
+
+                if (to == b) {
+                    b->meta.hashes[i] = hash_part(hash);
+                    break;
+                }
+
+                uint8_t j = bitset_next(&matches);
+                struct pair pair = b->pairs[i];
+
+                /* an empty slot ends the chain, a marked pair is swapped in
+                   and moved next */
+                b->meta.hashes[i] = to->meta.hashes[j];
+                b->hashes[i] = to->hashes[j];
+                b->pairs[i] = to->pairs[j];
+
+                to->meta.hashes[j] = hash_part(hash);
+                to->hashes[j] = hash;
+                to->pairs[j] = pair;
+            }
+        }
+    }
+}
+
 int pstrdict_reserve(pstrdict_t *dict, size_t count) {
     if (!dict)
         return PSTRING_EINVAL;
 
-    if (dict->count + count <= dict->capacity * PSTRDICT_THRESHOLD)
+    if (count > SIZE_MAX - dict->count - dict->tombs)
+        return PSTRING_ENOMEM;
+
+    size_t used = dict->count + dict->tombs + count;
+    if (used <= dict->capacity * PSTRDICT_THRESHOLD)
+        return PSTRING_OK;
+
+    /* enough tombstones that dropping them frees a quarter of the usable
+       slots, which keeps rehashing in place amortized over the inserts */
+    if (dict->count + count <= dict->capacity * PSTRDICT_THRESHOLD * 3 / 4) {
+        rehash(dict);
         return PSTRING_OK;
+    }
 
     size_t capacity = round_pow2(dict->capacity) * 2;
     if (capacity < PSTRDICT_BUCKET_SIZE)
         capacity = PSTRDICT_BUCKET_SIZE;
 
+    /* largest capacity whose buckets can still be sized in a size_t */
+    size_t max = SIZE_MAX / sizeof(struct bucket) * PSTRDICT_BUCKET_SIZE;
+    while (dict->count + count > capacity * PSTRDICT_THRESHOLD) {
+        if (capacity > max / 2)
+            return PSTRING_ENOMEM;
+
+        capacity *= 2;
+    }
+
     return dict->count == 0 ? grow_empty(dict, capacity)
-                            : grow_not_empty(dict, capacity);
+                            : resize(dict, capacity);
+}
+
+int pstrdict_compact(pstrdict_t *dict) {
+    if (!dict)
+        return PSTRING_EINVAL;
+
+    if (dict->tombs > 0)
+        rehash(dict);
+
+    return PSTRING_OK;
+}
+
+int pstrdict_shrink(pstrdict_t *dict) {
+    if (!dict)
+        return PSTRING_EINVAL;
+
+    if (dict->count == 0) {
+        deallocate(
+            dict->allocator,
+            dict->buckets,
+            dict->capacity / PSTRDICT_BUCKET_SIZE * sizeof(struct bucket)
+        );
+
+        dict->buckets = NULL;
+        dict->capacity = 0;
+        dict->tombs = 0;
+        return PSTRING_OK;
+    }
+
+    size_t capacity = PSTRDICT_BUCKET_SIZE;
+    while (dict->count > capacity * PSTRDICT_THRESHOLD)
+        capacity *= 2;
+
+    if (capacity >= dict->capacity)
+        return pstrdict_compact(dict);
+
+    return resize(dict, capacity);
 }
 
 void pstrdict_free(pstrdict_t *dict) {
@@ -212,45 +481,21 @@ allocator_t *pstrdict_allocator(const pstrdict_t *dict) {
     return dict ? dict->allocator : 0;
 }
 
-static uint8_t bitset_next(uint64_t *set) {
-    if (!set)
-        return 0;
-
-    for (uint8_t i = 0;; i++) {
-        if (*set & (1 << i)) {
-            *set &= ~((uint64_t)1 << i);
-            return i;
-        }
-    }
-}
-
-struct pstrdict_iter {
-    struct bucket *buckets;
-    struct bucket *current;
-    size_t mask;
-    size_t b;
-};
-
-static inline struct bucket *iter_init(const pstrdict_t *dict, size_t hash) {
-    return &dict->buckets[(hash & (dict->capacity - 1)) / PSTRDICT_BUCKET_SIZE];
-}
-
-static inline struct bucket *iter_end(const pstrdict_t *dict) {
-    size_t end = dict->capacity / PSTRDICT_BUCKET_SIZE;
-    return &dict->buckets[end];
-}
-
-static inline struct bucket *iter_next(
-    const pstrdict_t *dict, struct bucket *prev
+int pstrdict_key(
+    const pstrdict_t *dict, pstrkey_t *out, const pstring_t *str
 ) {
-    return ++prev >= iter_end(dict) ? dict->buckets : prev;
+    if (!dict || !out || !str)
+        return PSTRING_EINVAL;
+
+    key_init(dict, out, str);
+    return PSTRING_OK;
 }
 
-void *pstrdict_get(const pstrdict_t *dict, const pstring_t *key) {
-    if (!dict || !key || dict->count == 0)
+void *pstrdict_get_hashed(const pstrdict_t *dict, const pstrkey_t *key) {
+    if (!dict || !key || !key->str || dict->count == 0)
         return NULL;
 
-    size_t hash = dict->hash(key);
+    size_t hash = key_hash(dict, key);
     uint8_t part = hash_part(hash);
     struct bucket *b = iter_init(dict, hash);
 
@@ -260,7 +505,7 @@ void *pstrdict_get(const pstrdict_t *dict, const pstring_t *key) {
         while (matches) {
             uint8_t i = bitset_next(&matches);
 
-            if (pstrequal(key, b->pairs[i].key))
+            if (b->hashes[i] == hash && pstrequal(key->str, b->pairs[i].key))
                 return (void *)b->pairs[i].value;
         }
 
@@ -273,6 +518,15 @@ void *pstrdict_get(const pstrdict_t *dict, const pstring_t *key) {
     return NULL;
 }
 
+void *pstrdict_get(const pstrdict_t *dict, const pstring_t *key) {
+    if (!dict || !key || dict->count == 0)
+        return NULL;
+
+    pstrkey_t hashed;
+    key_init(dict, &hashed, key);
+    return pstrdict_get_hashed(dict, &hashed);
+}
+
 void *pstrdict_gets(const pstrdict_t *dict, const char *key, size_t length) {
     if (!dict || (!key && length > 0))
         return NULL;
@@ -282,16 +536,17 @@ void *pstrdict_gets(const pstrdict_t *dict, const char *key, size_t length) {
     return pstrdict_get(dict, &buffer);
 }
 
-int pstrdict_set(pstrdict_t *dict, const pstring_t *key, const void *value) {
-    if (!dict || !key || !value)
-        return PSTRING_EINVAL;
-
-    if (pstrdict_reserve(dict, 1))
-        return PSTRING_ENOMEM;
-
-    size_t hash = dict->hash(key);
-    uint8_t i, part = hash_part(hash);
-    struct bucket *b = iter_init(dict, hash);
+/* Sets or inserts the pair with a precomputed `hash`, after space for it has
+   been reserved, only replacing the value of a present key if `replace`. */
+static int set_hashed(
+    pstrdict_t *dict,
+    const pstring_t *key,
+    const void *value,
+    size_t hash,
+    int replace
+) {
+    uint8_t i, tomb_i = 0, part = hash_part(hash);
+    struct bucket *b = iter_init(dict, hash), *tomb = NULL;
 
     while (1) {
         uint64_t matches = bucket_match(&b->meta, part);
@@ -299,19 +554,36 @@ int pstrdict_set(pstrdict_t *dict, const pstring_t *key, const void *value) {
         while (matches) {
             i = bitset_next(&matches);
 
-            if (pstrequal(key, b->pairs[i].key)) {
+            if (b->hashes[i] == hash && pstrequal(key, b->pairs[i].key)) {
+                if (!replace)
+                    return PSTRING_EEXIST;
+
                 b->pairs[i].value = value;
                 return PSTRING_OK;
             }
         }
 
+        matches = bucket_match(&b->meta, PSTRDICT_TOMB);
+        if (matches && !tomb) {
+            tomb = b;
+            tomb_i = bitset_next(&matches);
+        }
+
         matches = bucket_match(&b->meta, PSTRDICT_EMPTY);
 
         if (matches) {
             i = bitset_next(&matches);
 
+            /* the key is missing, reuse the first removed slot seen */
+            if (tomb) {
+                b = tomb;
+                i = tomb_i;
+                dict->tombs--;
+            }
+
             dict->count++;
             b->meta.hashes[i] = part;
+            b->hashes[i] = hash;
             b->pairs[i].key = key;
             b->pairs[i].value = value;
             return PSTRING_OK;
@@ -321,51 +593,97 @@ int pstrdict_set(pstrdict_t *dict, const pstring_t *key, const void *value) {
     }
 }
 
-int pstrdict_insert(pstrdict_t *dict, const pstring_t *key, const void *value) {
+int pstrdict_set_hashed(
+    pstrdict_t *dict, const pstrkey_t *key, const void *value
+) {
+    if (!dict || !key || !key->str || !value)
+        return PSTRING_EINVAL;
+
+    if (pstrdict_reserve(dict, 1))
+        return PSTRING_ENOMEM;
+
+    size_t hash = key_hash(dict, key);
+    return set_hashed(dict, key->str, value, hash, PSTRING_TRUE);
+}
+
+int pstrdict_set(pstrdict_t *dict, const pstring_t *key, const void *value) {
     if (!dict || !key || !value)
         return PSTRING_EINVAL;
 
     if (pstrdict_reserve(dict, 1))
         return PSTRING_ENOMEM;
 
-    size_t hash = dict->hash(key);
-    uint8_t i, part = hash_part(hash);
-    struct bucket *b = iter_init(dict, hash);
+    return set_hashed(dict, key, value, dict_hash(dict, key), PSTRING_TRUE);
+}
 
-    while (1) {
-        uint64_t matches = bucket_match(&b->meta, part);
+/* Keys are hashed in batches of this many by `pstrdict_set_many`. */
+#define HASH_BATCH 64
 
-        while (matches) {
-            i = bitset_next(&matches);
+int pstrdict_set_many(
+    pstrdict_t *dict, const pstring_t *keys, void *const *values, size_t count
+) {
+    if (!dict || (count > 0 && (!keys || !values)))
+        return PSTRING_EINVAL;
 
-            if (pstrequal(key, b->pairs[i].key))
-                return PSTRING_EEXIST;
-        }
+    for (size_t i = 0; i < count; i++)
+        if (!values[i])
+            return PSTRING_EINVAL;
 
-        matches = bucket_match(&b->meta, PSTRDICT_EMPTY);
+    if (pstrdict_reserve(dict, count))
+        return PSTRING_ENOMEM;
 
-        if (matches) {
-            i = bitset_next(&matches);
+    size_t hashes[HASH_BATCH];
 
-            dict->count++;
-            b->meta.hashes[i] = part;
-            b->pairs[i].key = key;
-            b->pairs[i].value = value;
-            return PSTRING_OK;
+    for (size_t i = 0; i < count; i += HASH_BATCH) {
+        size_t batch = count - i < HASH_BATCH ? count - i : HASH_BATCH;
+
+        if (dict->hash) {
+            for (size_t k = 0; k < batch; k++)
+                hashes[k] = dict->hash(&keys[i + k]);
+        } else {
+            pstrhash_many_seeded(&keys[i], batch, dict->seed, hashes);
         }
 
-        b = iter_next(dict, b);
+        for (size_t k = 0; k < batch; k++)
+            set_hashed(
+                dict, &keys[i + k], values[i + k], hashes[k], PSTRING_TRUE
+            );
     }
+
+    return PSTRING_OK;
 }
 
-int pstrdict_remove(pstrdict_t *dict, const pstring_t *key) {
-    if (!dict || !key)
+int pstrdict_insert_hashed(
+    pstrdict_t *dict, const pstrkey_t *key, const void *value
+) {
+    if (!dict || !key || !key->str || !value)
+        return PSTRING_EINVAL;
+
+    if (pstrdict_reserve(dict, 1))
+        return PSTRING_ENOMEM;
+
+    size_t hash = key_hash(dict, key);
+    return set_hashed(dict, key->str, value, hash, PSTRING_FALSE);
+}
+
+int pstrdict_insert(pstrdict_t *dict, const pstring_t *key, const void *value) {
+    if (!dict || !key || !value)
+        return PSTRING_EINVAL;
+
+    if (pstrdict_reserve(dict, 1))
+        return PSTRING_ENOMEM;
+
+    return set_hashed(dict, key, value, dict_hash(dict, key), PSTRING_FALSE);
+}
+
+int pstrdict_remove_hashed(pstrdict_t *dict, const pstrkey_t *key) {
+    if (!dict || !key || !key->str)
         return PSTRING_EINVAL;
 
     if (dict->count == 0)
         return PSTRING_ENOENT;
 
-    size_t hash = dict->hash(key);
+    size_t hash = key_hash(dict, key);
     uint8_t part = hash_part(hash);
     struct bucket *b = iter_init(dict, hash);
 
@@ -375,9 +693,8 @@ int pstrdict_remove(pstrdict_t *dict, const pstring_t *key) {
         while (matches) {
             uint8_t i = bitset_next(&matches);
 
-            if (pstrequal(key, b->pairs[i].key)) {
-                b->meta.hashes[i] = PSTRDICT_TOMB;
-                dict->count--;
+            if (b->hashes[i] == hash && pstrequal(key->str, b->pairs[i].key)) {
+                clear_slot(dict, b, i);
                 return PSTRING_OK;
             }
         }
@@ -391,34 +708,40 @@ int pstrdict_remove(pstrdict_t *dict, const pstring_t *key) {
     return PSTRING_ENOENT;
 }
 
-int pstrdict_finsert(
-    pstrdict_t *dict, const pstring_t *key, const void *value
+int pstrdict_remove(pstrdict_t *dict, const pstring_t *key) {
+    if (!dict || !key)
+        return PSTRING_EINVAL;
+
+    if (dict->count == 0)
+        return PSTRING_ENOENT;
+
+    pstrkey_t hashed;
+    key_init(dict, &hashed, key);
+    return pstrdict_remove_hashed(dict, &hashed);
+}
+
+int pstrdict_finsert_hashed(
+    pstrdict_t *dict, const pstrkey_t *key, const void *value
 ) {
-    if (!dict || !key || !value)
+    if (!dict || !key || !key->str || !value)
         return PSTRING_EINVAL;
 
     if (pstrdict_reserve(dict, 1))
         return PSTRING_ENOMEM;
 
-    size_t hash = dict->hash(key);
-    uint8_t i, part = hash_part(hash);
-    struct bucket *b = iter_init(dict, hash);
-
-    while (1) {
-        uint64_t matches = bucket_match(&b->meta, PSTRDICT_EMPTY);
-
-        if (matches) {
-            i = bitset_next(&matches);
+    place(dict, key->str, value, key_hash(dict, key));
+    return PSTRING_OK;
+}
 
-            dict->count++;
-            b->meta.hashes[i] = part;
-            b->pairs[i].key = key;
-            b->pairs[i].value = value;
-            return PSTRING_OK;
-        }
+int pstrdict_finsert(
+    pstrdict_t *dict, const pstring_t *key, const void *value
+) {
+    if (!dict || !key || !value)
+        return PSTRING_EINVAL;
 
-        b = iter_next(dict, b);
-    }
+    pstrkey_t hashed;
+    key_init(dict, &hashed, key);
+    return pstrdict_finsert_hashed(dict, &hashed, value);
 }
 
 int pstrdict_each(pstrdict_t *dict, pstrdict_fn *fn, void *user) {
@@ -465,10 +788,8 @@ PSTR_API int pstrdict_filter(pstrdict_t *dict, pstrdict_fn *fn, void *user) {
             pstring_t *key = (pstring_t *)b->pairs[i].key;
             void *value = (void *)b->pairs[i].value;
 
-            if (!fn(user, key, value)) {
-                b->meta.hashes[i] = PSTRDICT_TOMB;
-                dict->count--;
-            }
+            if (!fn(user, key, value))
+                clear_slot(dict, b, i);
         }
     }
 
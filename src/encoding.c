@@ -24,6 +24,20 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "internal.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    #define HOST_BIG_ENDIAN 1
+#else
+    #define HOST_BIG_ENDIAN 0
+#endif
+
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+
+/* UTF-8 is transcoded in chunks of about this many bytes, each validated at
+   once so only invalid ones are decoded one character at a time */
+#define UTF8_CHUNK 4096
+
 static const char *hexdigits = "0123456789ABCDEF";
 
 static struct {
@@ -534,21 +548,6 @@ int pstrdec_cstring(pstring_t *dst, const pstring_t *src) {
     return PSTRING_OK;
 }
 
-int pstrenc_utf8(pstring_t *dst, const uint32_t *src, size_t length) {
-    if (!dst || !src)
-        return PSTRING_EINVAL;
-
-    if (pstrreserve(dst, length * 4))
-        return PSTRING_ENOMEM;
-
-    char *out = pstrend(dst);
-    for (size_t i = 0; i < length; i++)
-        out = pstr_write_utf8(out, src[i]);
-
-    pstr__setlen(dst, out - pstrbuf(dst));
-    return PSTRING_OK;
-}
-
 static int utf8_length(char c) {
     if ((c & 0xF8) == 0xF0)
         return 4; /* 4-byte character, mask = 0x07, shift = 18 */
@@ -604,24 +603,494 @@ const char *pstr_read_utf8(const char *chr, const char *end, uint32_t *out) {
     return chr;
 }
 
-int pstrdec_utf8(uint32_t *dst, size_t *length, const pstring_t *src) {
-    if (!dst || !src)
+/* Reads a character from UTF-8 that is known to be valid. */
+static inline const char *read_valid_utf8(const char *chr, uint32_t *out) {
+    unsigned char lead = (unsigned char)chr[0];
+
+    if (lead < 0x80) {
+        *out = lead;
+        return chr + 1;
+    }
+
+    if (lead < 0xE0) {
+        *out = (lead & 0x1F) << 6 | (chr[1] & 0x3F);
+        return chr + 2;
+    }
+
+    if (lead < 0xF0) {
+        *out = (lead & 0x0F) << 12 | (chr[1] & 0x3F) << 6 | (chr[2] & 0x3F);
+        return chr + 3;
+    }
+
+    *out = (uint32_t)(lead & 0x07) << 18 | (chr[1] & 0x3F) << 12
+         | (chr[2] & 0x3F) << 6 | (chr[3] & 0x3F);
+    return chr + 4;
+}
+
+/* Finds the end of the chunk starting at `from`. Chunks end right before a
+   byte that isn't a continuation byte, where `pstr_read_utf8` would start
+   reading a new character anyway, so validating and decoding them one by
+   one gives the same result as decoding the whole string at once. */
+static size_t utf8_chunk(const char *src, size_t from, size_t length) {
+    size_t end = length - from > UTF8_CHUNK ? from + UTF8_CHUNK : length;
+
+    while (end < length && (src[end] & 0xC0) == 0x80)
+        end++;
+
+    return end;
+}
+
+/* UTF-16 code units of `c`, or of U+FFFD if it can't be represented */
+static inline size_t utf16_units(uint32_t c) {
+    return c >= 0x10000 && c <= 0x10FFFF ? 2 : 1;
+}
+
+static inline uint32_t load_unit(const void *src, size_t width, int swap) {
+    if (width == 4)
+        return *(const uint32_t *)src;
+
+    uint16_t unit = *(const uint16_t *)src;
+    return swap ? (uint16_t)(unit << 8 | unit >> 8) : unit;
+}
+
+static inline void store_unit(
+    void *dst, uint32_t unit, size_t width, int swap
+) {
+    if (width == 4)
+        *(uint32_t *)dst = unit;
+    else if (swap)
+        *(uint16_t *)dst = (uint16_t)(unit << 8 | unit >> 8);
+    else
+        *(uint16_t *)dst = (uint16_t)unit;
+}
+
+/* Counts the UTF-16 or UTF-32 code units, `width` bytes wide, that `src`
+   decodes into. */
+static size_t utf8_units(const char *src, size_t length, size_t width) {
+    size_t count = 0;
+
+    for (size_t i = 0, end; i < length; i = end) {
+        end = utf8_chunk(src, i, length);
+
+        pstring_t chunk;
+        pstrwrap(&chunk, (char *)&src[i], end - i, end - i);
+
+        if (pstrvalid_utf8(&chunk)) {
+            count += width == 2 ? pstrlen_utf16(&chunk) : pstrlen_utf8(&chunk);
+            continue;
+        }
+
+        for (const char *chr = &src[i]; chr < &src[end]; count++) {
+            uint32_t c;
+            chr = pstr_read_utf8(chr, &src[end], &c);
+            if (width == 2)
+                count += utf16_units(c) - 1;
+        }
+    }
+
+    return count;
+}
+
+/* Decodes UTF-8 from `src` into at most `max` UTF-16 or UTF-32 code units,
+   stopping before the first character that doesn't fit. Returns the number
+   of code units written and stores the number of bytes read into `read`. */
+static size_t utf8_decode(
+    void *dst,
+    size_t max,
+    const char *src,
+    size_t length,
+    size_t width,
+    int swap,
+    size_t *read
+) {
+    char *out = dst;
+    size_t count = 0, i = 0, retry = 0;
+
+    while (i < length) {
+        size_t end = utf8_chunk(src, i, length);
+
+        pstring_t chunk;
+        pstrwrap(&chunk, (char *)&src[i], end - i, end - i);
+        int valid = pstrvalid_utf8(&chunk);
+
+        while (i < end) {
+            /* where vectors can't be decoded, the next few characters are
+               decoded one at a time before trying again */
+            if (valid && i >= retry) {
+                size_t units, room = MIN(end - i, max - count);
+                size_t bytes = pstr__decode_utf8(
+                    &out[count * width], &units, &src[i], room, width, swap
+                );
+
+                i += bytes;
+                count += units;
+                if (bytes > 0)
+                    continue;
+
+                retry = i + 16;
+            }
+
+            uint32_t c;
+            const char *next = valid ? read_valid_utf8(&src[i], &c)
+                                     : pstr_read_utf8(&src[i], &src[end], &c);
+
+            if (width == 2 && (c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)))
+                c = 0xFFFD;
+
+            size_t units = width == 2 ? utf16_units(c) : 1;
+            if (max - count < units) {
+                *read = i;
+                return count;
+            }
+
+            if (units == 2) {
+                c -= 0x10000;
+                store_unit(&out[count * width], 0xD800 | c >> 10, width, swap);
+                store_unit(
+                    &out[(count + 1) * width],
+                    0xDC00 | (c & 0x3FF),
+                    width,
+                    swap
+                );
+            } else {
+                store_unit(&out[count * width], c, width, swap);
+            }
+
+            count += units;
+            i = next - src;
+        }
+    }
+
+    *read = i;
+    return count;
+}
+
+static int utf8_decode_into(
+    void *dst, size_t *length, const pstring_t *src, size_t width, int swap
+) {
+    if (!length || !src)
         return PSTRING_EINVAL;
 
-    const char *chr = pstrbuf(src);
-    const char *end = pstrend(src);
-    size_t count = 0, max = *length;
+    if (!dst) {
+        *length = utf8_units(pstrbuf(src), pstrlen(src), width);
+        return PSTRING_OK;
+    }
 
-    for (; chr < end && count < max; count++)
-        chr = pstr_read_utf8(chr, end, &dst[count]);
+    size_t read;
+    *length = utf8_decode(
+        dst, *length, pstrbuf(src), pstrlen(src), width, swap, &read
+    );
+
+    if (read < pstrlen(src))
+        return PSTRING_ENOMEM;
+
+    return PSTRING_OK;
+}
+
+/* Reads a character from UTF-16 or UTF-32 code units, returning how many of
+   them it took. Unpaired surrogates in UTF-16 and code points past U+10FFFF
+   are read as U+FFFD. */
+static inline size_t read_units(
+    const char *src, size_t length, size_t width, int swap, uint32_t *out
+) {
+    uint32_t c = load_unit(src, width, swap);
+
+    if (width == 2 && c >= 0xD800 && c <= 0xDFFF) {
+        uint32_t low = length > 1 ? load_unit(src + 2, width, swap) : 0;
+        if (c <= 0xDBFF && low >= 0xDC00 && low <= 0xDFFF) {
+            *out = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+            return 2;
+        }
+
+        c = 0xFFFD;
+    }
+
+    *out = c > 0x10FFFF ? 0xFFFD : c;
+    return 1;
+}
+
+/* Counts the bytes needed to encode UTF-16 or UTF-32 code units as UTF-8.
+   Surrogates take three bytes each, as does the U+FFFD replacing unpaired
+   ones, so only two bytes need to be taken off for every pair. */
+static size_t utf8_size(
+    const void *src, size_t length, size_t width, int swap
+) {
+    const char *units = src;
+    size_t size = 0, i = 0;
+    int high = PSTRING_FALSE;
+
+    while (i < length) {
+        const char *unit = &units[i * width];
+        size_t bytes, read;
+
+        read = pstr__encode_utf8(NULL, &bytes, unit, length - i, width, swap);
+        i += read;
+        size += bytes;
+        if (read > 0)
+            high = PSTRING_FALSE;
+
+        for (size_t end = MIN(length, i + 64); i < end; i++) {
+            uint32_t c = load_unit(&units[i * width], width, swap);
+            size += 1 + (c >= 0x80) + (c >= 0x800);
+            size += c >= 0x10000 && c <= 0x10FFFF;
+
+            if (width == 2) {
+                size -= high && c >= 0xDC00 && c <= 0xDFFF ? 2 : 0;
+                high = c >= 0xD800 && c <= 0xDBFF;
+            }
+        }
+    }
+
+    return size;
+}
+
+/* Encodes `length` UTF-16 or UTF-32 code units from `src` as UTF-8 into
+   `out`, which needs to have room for all of them. */
+static void utf8_encode(
+    char *out, const void *src, size_t length, size_t width, int swap
+) {
+    const char *units = src;
+    size_t i = 0, retry = 0;
+
+    while (i < length) {
+        const char *unit = &units[i * width];
+
+        if (i >= retry) {
+            size_t bytes;
+            size_t read
+                = pstr__encode_utf8(out, &bytes, unit, length - i, width, swap);
+
+            i += read;
+            out += bytes;
+            if (read > 0)
+                continue;
+
+            retry = i + 16;
+        }
+
+        uint32_t c;
+        i += read_units(unit, length - i, width, swap, &c);
+        out = pstr_write_utf8(out, c);
+    }
+}
+
+static int utf8_encode_into(
+    pstring_t *dst, const void *src, size_t length, size_t width, int swap
+) {
+    if (!dst || !src)
+        return PSTRING_EINVAL;
 
-    *length = count;
-    if (chr < end)
+    size_t size = utf8_size(src, length, width, swap);
+    if (pstrreserve(dst, size))
         return PSTRING_ENOMEM;
 
+    utf8_encode(pstrend(dst), src, length, width, swap);
+    pstr__setlen(dst, pstrlen(dst) + size);
     return PSTRING_OK;
 }
 
+int pstrenc_utf8(pstring_t *dst, const uint32_t *src, size_t length) {
+    return utf8_encode_into(dst, src, length, 4, PSTRING_FALSE);
+}
+
+int pstrdec_utf8(uint32_t *dst, size_t *length, const pstring_t *src) {
+    return utf8_decode_into(dst, length, src, 4, PSTRING_FALSE);
+}
+
+int pstrenc_utf16le(uint16_t *dst, size_t *length, const pstring_t *src) {
+    return utf8_decode_into(dst, length, src, 2, HOST_BIG_ENDIAN);
+}
+
+int pstrenc_utf16be(uint16_t *dst, size_t *length, const pstring_t *src) {
+    return utf8_decode_into(dst, length, src, 2, !HOST_BIG_ENDIAN);
+}
+
+int pstrdec_utf16le(pstring_t *dst, const uint16_t *src, size_t length) {
+    return utf8_encode_into(dst, src, length, 2, HOST_BIG_ENDIAN);
+}
+
+int pstrdec_utf16be(pstring_t *dst, const uint16_t *src, size_t length) {
+    return utf8_encode_into(dst, src, length, 2, !HOST_BIG_ENDIAN);
+}
+
+/* Simple case mappings from the Unicode 14.0 character database. Each range
+   maps `count` code points, `stride` apart from each other starting with
+   `first`, by adding `delta` to them. */
+struct case_range {
+    uint32_t first;
+    uint16_t count;
+    uint16_t stride;
+    int32_t delta;
+};
+
+static const struct case_range lower_ranges[] = {
+    { 0x0041, 26, 1, 32 }, { 0x00C0, 23, 1, 32 }, { 0x00D8, 7, 1, 32 },
+    { 0x0100, 24, 2, 1 }, { 0x0132, 3, 2, 1 }, { 0x0139, 8, 2, 1 },
+    { 0x014A, 23, 2, 1 }, { 0x0178, 1, 1, -121 }, { 0x0179, 3, 2, 1 },
+    { 0x0181, 1, 1, 210 }, { 0x0182, 2, 2, 1 }, { 0x0186, 1, 1, 206 },
+    { 0x0187, 1, 1, 1 }, { 0x0189, 2, 1, 205 }, { 0x018B, 1, 1, 1 },
+    { 0x018E, 1, 1, 79 }, { 0x018F, 1, 1, 202 }, { 0x0190, 1, 1, 203 },
+    { 0x0191, 1, 1, 1 }, { 0x0193, 1, 1, 205 }, { 0x0194, 1, 1, 207 },
+    { 0x0196, 1, 1, 211 }, { 0x0197, 1, 1, 209 }, { 0x0198, 1, 1, 1 },
+    { 0x019C, 1, 1, 211 }, { 0x019D, 1, 1, 213 }, { 0x019F, 1, 1, 214 },
+    { 0x01A0, 3, 2, 1 }, { 0x01A6, 1, 1, 218 }, { 0x01A7, 1, 1, 1 },
+    { 0x01A9, 1, 1, 218 }, { 0x01AC, 1, 1, 1 }, { 0x01AE, 1, 1, 218 },
+    { 0x01AF, 1, 1, 1 }, { 0x01B1, 2, 1, 217 }, { 0x01B3, 2, 2, 1 },
+    { 0x01B7, 1, 1, 219 }, { 0x01B8, 1, 1, 1 }, { 0x01BC, 1, 1, 1 },
+    { 0x01C4, 1, 1, 2 }, { 0x01C5, 1, 1, 1 }, { 0x01C7, 1, 1, 2 },
+    { 0x01C8, 1, 1, 1 }, { 0x01CA, 1, 1, 2 }, { 0x01CB, 9, 2, 1 },
+    { 0x01DE, 9, 2, 1 }, { 0x01F1, 1, 1, 2 }, { 0x01F2, 2, 2, 1 },
+    { 0x01F6, 1, 1, -97 }, { 0x01F7, 1, 1, -56 }, { 0x01F8, 20, 2, 1 },
+    { 0x0220, 1, 1, -130 }, { 0x0222, 9, 2, 1 }, { 0x023A, 1, 1, 10795 },
+    { 0x023B, 1, 1, 1 }, { 0x023D, 1, 1, -163 }, { 0x023E, 1, 1, 10792 },
+    { 0x0241, 1, 1, 1 }, { 0x0243, 1, 1, -195 }, { 0x0244, 1, 1, 69 },
+    { 0x0245, 1, 1, 71 }, { 0x0246, 5, 2, 1 }, { 0x0370, 2, 2, 1 },
+    { 0x0376, 1, 1, 1 }, { 0x037F, 1, 1, 116 }, { 0x0386, 1, 1, 38 },
+    { 0x0388, 3, 1, 37 }, { 0x038C, 1, 1, 64 }, { 0x038E, 2, 1, 63 },
+    { 0x0391, 17, 1, 32 }, { 0x03A3, 9, 1, 32 }, { 0x03CF, 1, 1, 8 },
+    { 0x03D8, 12, 2, 1 }, { 0x03F4, 1, 1, -60 }, { 0x03F7, 1, 1, 1 },
+    { 0x03F9, 1, 1, -7 }, { 0x03FA, 1, 1, 1 }, { 0x03FD, 3, 1, -130 },
+    { 0x0400, 16, 1, 80 }, { 0x0410, 32, 1, 32 }, { 0x0460, 17, 2, 1 },
+    { 0x048A, 27, 2, 1 }, { 0x04C0, 1, 1, 15 }, { 0x04C1, 7, 2, 1 },
+    { 0x04D0, 48, 2, 1 }, { 0x0531, 38, 1, 48 }, { 0x10A0, 38, 1, 7264 },
+    { 0x10C7, 1, 1, 7264 }, { 0x10CD, 1, 1, 7264 }, { 0x13A0, 80, 1, 38864 },
+    { 0x13F0, 6, 1, 8 }, { 0x1C90, 43, 1, -3008 }, { 0x1CBD, 3, 1, -3008 },
+    { 0x1E00, 75, 2, 1 }, { 0x1E9E, 1, 1, -7615 }, { 0x1EA0, 48, 2, 1 },
+    { 0x1F08, 8, 1, -8 }, { 0x1F18, 6, 1, -8 }, { 0x1F28, 8, 1, -8 },
+    { 0x1F38, 8, 1, -8 }, { 0x1F48, 6, 1, -8 }, { 0x1F59, 4, 2, -8 },
+    { 0x1F68, 8, 1, -8 }, { 0x1F88, 8, 1, -8 }, { 0x1F98, 8, 1, -8 },
+    { 0x1FA8, 8, 1, -8 }, { 0x1FB8, 2, 1, -8 }, { 0x1FBA, 2, 1, -74 },
+    { 0x1FBC, 1, 1, -9 }, { 0x1FC8, 4, 1, -86 }, { 0x1FCC, 1, 1, -9 },
+    { 0x1FD8, 2, 1, -8 }, { 0x1FDA, 2, 1, -100 }, { 0x1FE8, 2, 1, -8 },
+    { 0x1FEA, 2, 1, -112 }, { 0x1FEC, 1, 1, -7 }, { 0x1FF8, 2, 1, -128 },
+    { 0x1FFA, 2, 1, -126 }, { 0x1FFC, 1, 1, -9 }, { 0x2126, 1, 1, -7517 },
+    { 0x212A, 1, 1, -8383 }, { 0x212B, 1, 1, -8262 }, { 0x2132, 1, 1, 28 },
+    { 0x2160, 16, 1, 16 }, { 0x2183, 1, 1, 1 }, { 0x24B6, 26, 1, 26 },
+    { 0x2C00, 48, 1, 48 }, { 0x2C60, 1, 1, 1 }, { 0x2C62, 1, 1, -10743 },
+    { 0x2C63, 1, 1, -3814 }, { 0x2C64, 1, 1, -10727 }, { 0x2C67, 3, 2, 1 },
+    { 0x2C6D, 1, 1, -10780 }, { 0x2C6E, 1, 1, -10749 },
+    { 0x2C6F, 1, 1, -10783 }, { 0x2C70, 1, 1, -10782 }, { 0x2C72, 1, 1, 1 },
+    { 0x2C75, 1, 1, 1 }, { 0x2C7E, 2, 1, -10815 }, { 0x2C80, 50, 2, 1 },
+    { 0x2CEB, 2, 2, 1 }, { 0x2CF2, 1, 1, 1 }, { 0xA640, 23, 2, 1 },
+    { 0xA680, 14, 2, 1 }, { 0xA722, 7, 2, 1 }, { 0xA732, 31, 2, 1 },
+    { 0xA779, 2, 2, 1 }, { 0xA77D, 1, 1, -35332 }, { 0xA77E, 5, 2, 1 },
+    { 0xA78B, 1, 1, 1 }, { 0xA78D, 1, 1, -42280 }, { 0xA790, 2, 2, 1 },
+    { 0xA796, 10, 2, 1 }, { 0xA7AA, 1, 1, -42308 }, { 0xA7AB, 1, 1, -42319 },
+    { 0xA7AC, 1, 1, -42315 }, { 0xA7AD, 1, 1, -42305 },
+    { 0xA7AE, 1, 1, -42308 }, { 0xA7B0, 1, 1, -42258 },
+    { 0xA7B1, 1, 1, -42282 }, { 0xA7B2, 1, 1, -42261 }, { 0xA7B3, 1, 1, 928 },
+    { 0xA7B4, 8, 2, 1 }, { 0xA7C4, 1, 1, -48 }, { 0xA7C5, 1, 1, -42307 },
+    { 0xA7C6, 1, 1, -35384 }, { 0xA7C7, 2, 2, 1 }, { 0xA7D0, 1, 1, 1 },
+    { 0xA7D6, 2, 2, 1 }, { 0xA7F5, 1, 1, 1 }, { 0xFF21, 26, 1, 32 },
+    { 0x10400, 40, 1, 40 }, { 0x104B0, 36, 1, 40 }, { 0x10570, 11, 1, 39 },
+    { 0x1057C, 15, 1, 39 }, { 0x1058C, 7, 1, 39 }, { 0x10594, 2, 1, 39 },
+    { 0x10C80, 51, 1, 64 }, { 0x118A0, 32, 1, 32 }, { 0x16E40, 32, 1, 32 },
+    { 0x1E900, 34, 1, 34 },
+};
+
+static const struct case_range upper_ranges[] = {
+    { 0x0061, 26, 1, -32 }, { 0x00B5, 1, 1, 743 }, { 0x00E0, 23, 1, -32 },
+    { 0x00F8, 7, 1, -32 }, { 0x00FF, 1, 1, 121 }, { 0x0101, 24, 2, -1 },
+    { 0x0131, 1, 1, -232 }, { 0x0133, 3, 2, -1 }, { 0x013A, 8, 2, -1 },
+    { 0x014B, 23, 2, -1 }, { 0x017A, 3, 2, -1 }, { 0x017F, 1, 1, -300 },
+    { 0x0180, 1, 1, 195 }, { 0x0183, 2, 2, -1 }, { 0x0188, 1, 1, -1 },
+    { 0x018C, 1, 1, -1 }, { 0x0192, 1, 1, -1 }, { 0x0195, 1, 1, 97 },
+    { 0x0199, 1, 1, -1 }, { 0x019A, 1, 1, 163 }, { 0x019E, 1, 1, 130 },
+    { 0x01A1, 3, 2, -1 }, { 0x01A8, 1, 1, -1 }, { 0x01AD, 1, 1, -1 },
+    { 0x01B0, 1, 1, -1 }, { 0x01B4, 2, 2, -1 }, { 0x01B9, 1, 1, -1 },
+    { 0x01BD, 1, 1, -1 }, { 0x01BF, 1, 1, 56 }, { 0x01C5, 1, 1, -1 },
+    { 0x01C6, 1, 1, -2 }, { 0x01C8, 1, 1, -1 }, { 0x01C9, 1, 1, -2 },
+    { 0x01CB, 1, 1, -1 }, { 0x01CC, 1, 1, -2 }, { 0x01CE, 8, 2, -1 },
+    { 0x01DD, 1, 1, -79 }, { 0x01DF, 9, 2, -1 }, { 0x01F2, 1, 1, -1 },
+    { 0x01F3, 1, 1, -2 }, { 0x01F5, 1, 1, -1 }, { 0x01F9, 20, 2, -1 },
+    { 0x0223, 9, 2, -1 }, { 0x023C, 1, 1, -1 }, { 0x023F, 2, 1, 10815 },
+    { 0x0242, 1, 1, -1 }, { 0x0247, 5, 2, -1 }, { 0x0250, 1, 1, 10783 },
+    { 0x0251, 1, 1, 10780 }, { 0x0252, 1, 1, 10782 }, { 0x0253, 1, 1, -210 },
+    { 0x0254, 1, 1, -206 }, { 0x0256, 2, 1, -205 }, { 0x0259, 1, 1, -202 },
+    { 0x025B, 1, 1, -203 }, { 0x025C, 1, 1, 42319 }, { 0x0260, 1, 1, -205 },
+    { 0x0261, 1, 1, 42315 }, { 0x0263, 1, 1, -207 }, { 0x0265, 1, 1, 42280 },
+    { 0x0266, 1, 1, 42308 }, { 0x0268, 1, 1, -209 }, { 0x0269, 1, 1, -211 },
+    { 0x026A, 1, 1, 42308 }, { 0x026B, 1, 1, 10743 }, { 0x026C, 1, 1, 42305 },
+    { 0x026F, 1, 1, -211 }, { 0x0271, 1, 1, 10749 }, { 0x0272, 1, 1, -213 },
+    { 0x0275, 1, 1, -214 }, { 0x027D, 1, 1, 10727 }, { 0x0280, 1, 1, -218 },
+    { 0x0282, 1, 1, 42307 }, { 0x0283, 1, 1, -218 }, { 0x0287, 1, 1, 42282 },
+    { 0x0288, 1, 1, -218 }, { 0x0289, 1, 1, -69 }, { 0x028A, 2, 1, -217 },
+    { 0x028C, 1, 1, -71 }, { 0x0292, 1, 1, -219 }, { 0x029D, 1, 1, 42261 },
+    { 0x029E, 1, 1, 42258 }, { 0x0345, 1, 1, 84 }, { 0x0371, 2, 2, -1 },
+    { 0x0377, 1, 1, -1 }, { 0x037B, 3, 1, 130 }, { 0x03AC, 1, 1, -38 },
+    { 0x03AD, 3, 1, -37 }, { 0x03B1, 17, 1, -32 }, { 0x03C2, 1, 1, -31 },
+    { 0x03C3, 9, 1, -32 }, { 0x03CC, 1, 1, -64 }, { 0x03CD, 2, 1, -63 },
+    { 0x03D0, 1, 1, -62 }, { 0x03D1, 1, 1, -57 }, { 0x03D5, 1, 1, -47 },
+    { 0x03D6, 1, 1, -54 }, { 0x03D7, 1, 1, -8 }, { 0x03D9, 12, 2, -1 },
+    { 0x03F0, 1, 1, -86 }, { 0x03F1, 1, 1, -80 }, { 0x03F2, 1, 1, 7 },
+    { 0x03F3, 1, 1, -116 }, { 0x03F5, 1, 1, -96 }, { 0x03F8, 1, 1, -1 },
+    { 0x03FB, 1, 1, -1 }, { 0x0430, 32, 1, -32 }, { 0x0450, 16, 1, -80 },
+    { 0x0461, 17, 2, -1 }, { 0x048B, 27, 2, -1 }, { 0x04C2, 7, 2, -1 },
+    { 0x04CF, 1, 1, -15 }, { 0x04D1, 48, 2, -1 }, { 0x0561, 38, 1, -48 },
+    { 0x10D0, 43, 1, 3008 }, { 0x10FD, 3, 1, 3008 }, { 0x13F8, 6, 1, -8 },
+    { 0x1C80, 1, 1, -6254 }, { 0x1C81, 1, 1, -6253 }, { 0x1C82, 1, 1, -6244 },
+    { 0x1C83, 2, 1, -6242 }, { 0x1C85, 1, 1, -6243 }, { 0x1C86, 1, 1, -6236 },
+    { 0x1C87, 1, 1, -6181 }, { 0x1C88, 1, 1, 35266 }, { 0x1D79, 1, 1, 35332 },
+    { 0x1D7D, 1, 1, 3814 }, { 0x1D8E, 1, 1, 35384 }, { 0x1E01, 75, 2, -1 },
+    { 0x1E9B, 1, 1, -59 }, { 0x1EA1, 48, 2, -1 }, { 0x1F00, 8, 1, 8 },
+    { 0x1F10, 6, 1, 8 }, { 0x1F20, 8, 1, 8 }, { 0x1F30, 8, 1, 8 },
+    { 0x1F40, 6, 1, 8 }, { 0x1F51, 4, 2, 8 }, { 0x1F60, 8, 1, 8 },
+    { 0x1F70, 2, 1, 74 }, { 0x1F72, 4, 1, 86 }, { 0x1F76, 2, 1, 100 },
+    { 0x1F78, 2, 1, 128 }, { 0x1F7A, 2, 1, 112 }, { 0x1F7C, 2, 1, 126 },
+    { 0x1FB0, 2, 1, 8 }, { 0x1FBE, 1, 1, -7205 }, { 0x1FD0, 2, 1, 8 },
+    { 0x1FE0, 2, 1, 8 }, { 0x1FE5, 1, 1, 7 }, { 0x214E, 1, 1, -28 },
+    { 0x2170, 16, 1, -16 }, { 0x2184, 1, 1, -1 }, { 0x24D0, 26, 1, -26 },
+    { 0x2C30, 48, 1, -48 }, { 0x2C61, 1, 1, -1 }, { 0x2C65, 1, 1, -10795 },
+    { 0x2C66, 1, 1, -10792 }, { 0x2C68, 3, 2, -1 }, { 0x2C73, 1, 1, -1 },
+    { 0x2C76, 1, 1, -1 }, { 0x2C81, 50, 2, -1 }, { 0x2CEC, 2, 2, -1 },
+    { 0x2CF3, 1, 1, -1 }, { 0x2D00, 38, 1, -7264 }, { 0x2D27, 1, 1, -7264 },
+    { 0x2D2D, 1, 1, -7264 }, { 0xA641, 23, 2, -1 }, { 0xA681, 14, 2, -1 },
+    { 0xA723, 7, 2, -1 }, { 0xA733, 31, 2, -1 }, { 0xA77A, 2, 2, -1 },
+    { 0xA77F, 5, 2, -1 }, { 0xA78C, 1, 1, -1 }, { 0xA791, 2, 2, -1 },
+    { 0xA794, 1, 1, 48 }, { 0xA797, 10, 2, -1 }, { 0xA7B5, 8, 2, -1 },
+    { 0xA7C8, 2, 2, -1 }, { 0xA7D1, 1, 1, -1 }, { 0xA7D7, 2, 2, -1 },
+    { 0xA7F6, 1, 1, -1 }, { 0xAB53, 1, 1, -928 }, { 0xAB70, 80, 1, -38864 },
+    { 0xFF41, 26, 1, -32 }, { 0x10428, 40, 1, -40 }, { 0x104D8, 36, 1, -40 },
+    { 0x10597, 11, 1, -39 }, { 0x105A3, 15, 1, -39 }, { 0x105B3, 7, 1, -39 },
+    { 0x105BB, 2, 1, -39 }, { 0x10CC0, 51, 1, -64 }, { 0x118C0, 32, 1, -32 },
+    { 0x16E60, 32, 1, -32 }, { 0x1E922, 34, 1, -34 },
+};
+
+static uint32_t map_case(
+    const struct case_range *ranges, size_t count, uint32_t c
+) {
+    size_t low = 0, high = count;
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (ranges[mid].first <= c)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if (low == 0)
+        return c;
+
+    const struct case_range *range = &ranges[low - 1];
+    uint32_t offset = c - range->first;
+
+    if (offset % range->stride || offset / range->stride >= range->count)
+        return c;
+
+    return c + range->delta;
+}
+
+uint32_t pstr_tolower(uint32_t c) {
+    size_t count = sizeof(lower_ranges) / sizeof(*lower_ranges);
+    return map_case(lower_ranges, count, c);
+}
+
+uint32_t pstr_toupper(uint32_t c) {
+    size_t count = sizeof(upper_ranges) / sizeof(*upper_ranges);
+    return map_case(upper_ranges, count, c);
+}
+
 static inline int is_json_esc(char c) {
     return c < 0x20 || c == '/' || c == '\\' || c == '"';
 }
@@ -0,0 +1,311 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <pstring/fuzzy.h>
+#include <pstring/pstring.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "allocator_std.h"
+
+#define NONE SIZE_MAX
+#define ROOT 0
+
+/* Entries are stored in a BK-tree over Levenshtein distance. The optimal
+   string alignment distance used by `pstrdistance` is not a metric, but it
+   is never larger than the Levenshtein distance and never less than half of
+   it, so an entry within `k` of the query is always within `2k` in the
+   tree. Those candidates are then checked using the real distance. */
+#define RADIUS(k) ((k) > SIZE_MAX / 2 ? SIZE_MAX : (k) * 2)
+#define SATURATE(x, y) ((x) > SIZE_MAX - (y) ? SIZE_MAX : (x) + (y))
+
+struct node {
+    size_t offset;  /* position of the entry in `text` */
+    size_t length;  /* length of the entry */
+    size_t child;   /* first child */
+    size_t sibling; /* next child of the same parent */
+    size_t edge;    /* distance to the parent */
+    size_t reach;   /* largest distance to a child */
+};
+
+typedef struct pstrfuzzy_t {
+    allocator_t *allocator;
+    size_t count;
+    struct node *nodes;
+    pstring_t text;
+} pstrfuzzy_t;
+
+struct stack {
+    size_t *items;
+    size_t length;
+    size_t capacity;
+};
+
+static void entry_at(const pstrfuzzy_t *fuzzy, size_t id, pstring_t *out) {
+    const struct node *node = &fuzzy->nodes[id];
+    const char *start = &pstrbuf(&fuzzy->text)[node->offset];
+    pstrrange(out, NULL, start, &start[node->length]);
+}
+
+static int insert(pstrfuzzy_t *fuzzy, size_t id) {
+    pstring_t entry, other;
+    entry_at(fuzzy, id, &entry);
+
+    for (size_t parent = ROOT;;) {
+        entry_at(fuzzy, parent, &other);
+
+        int distance = pstr__distance(&entry, &other, SIZE_MAX, 0);
+        if (distance < 0)
+            return distance;
+
+        size_t child = fuzzy->nodes[parent].child;
+        while (child != NONE && fuzzy->nodes[child].edge != (size_t)distance)
+            child = fuzzy->nodes[child].sibling;
+
+        if (child == NONE) {
+            struct node *node = &fuzzy->nodes[parent];
+            fuzzy->nodes[id].edge = distance;
+            fuzzy->nodes[id].sibling = node->child;
+            node->child = id;
+            if (node->reach < (size_t)distance)
+                node->reach = distance;
+            return PSTRING_OK;
+        }
+
+        parent = child;
+    }
+}
+
+pstrfuzzy_t *pstrfuzzy_new(
+    const pstring_t *entries, size_t count, allocator_t *allocator
+) {
+    if (!entries || count == 0 || count > SIZE_MAX / sizeof(struct node))
+        return NULL;
+
+    if (!allocator)
+        allocator = &standard_allocator;
+
+    pstrfuzzy_t *fuzzy = zallocate(allocator, sizeof(*fuzzy));
+    if (!fuzzy)
+        return NULL;
+
+    fuzzy->allocator = allocator;
+    fuzzy->count = count;
+    fuzzy->nodes = allocate(allocator, count * sizeof(struct node));
+
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++)
+        total += pstrlen(&entries[i]);
+
+    int error = !fuzzy->nodes || pstralloc(&fuzzy->text, total, allocator);
+
+    for (size_t i = 0; !error && i < count; i++) {
+        fuzzy->nodes[i] = (struct node) {
+            .offset = pstrlen(&fuzzy->text),
+            .length = pstrlen(&entries[i]),
+            .child = NONE,
+            .sibling = NONE,
+        };
+
+        error = pstrcat(&fuzzy->text, &entries[i]);
+    }
+
+    for (size_t i = 1; !error && i < count; i++)
+        error = insert(fuzzy, i);
+
+    if (error) {
+        pstrfuzzy_free(fuzzy);
+        return NULL;
+    }
+
+    return fuzzy;
+}
+
+void pstrfuzzy_free(pstrfuzzy_t *fuzzy) {
+    if (!fuzzy)
+        return;
+
+    if (fuzzy->nodes)
+        deallocate(
+            fuzzy->allocator, fuzzy->nodes, fuzzy->count * sizeof(struct node)
+        );
+
+    pstrfree(&fuzzy->text);
+    deallocate(fuzzy->allocator, fuzzy, sizeof(*fuzzy));
+}
+
+size_t pstrfuzzy_count(const pstrfuzzy_t *fuzzy) {
+    return fuzzy ? fuzzy->count : 0;
+}
+
+static int push(const pstrfuzzy_t *fuzzy, struct stack *stack, size_t id) {
+    if (stack->length == stack->capacity) {
+        size_t capacity = stack->capacity ? stack->capacity * 2 : 64;
+        size_t *items = reallocate(
+            fuzzy->allocator,
+            stack->items,
+            stack->capacity * sizeof(size_t),
+            capacity * sizeof(size_t)
+        );
+
+        if (!items)
+            return PSTRING_ENOMEM;
+
+        stack->items = items;
+        stack->capacity = capacity;
+    }
+
+    stack->items[stack->length++] = id;
+    return PSTRING_OK;
+}
+
+typedef int(found_fn)(void *ctx, size_t id, size_t distance);
+
+/* Calls `found` for every entry within distance `*k` of `query`,
+   which the callback may lower during the search. */
+static int walk(
+    const pstrfuzzy_t *fuzzy,
+    const pstring_t *query,
+    size_t *k,
+    found_fn *found,
+    void *ctx
+) {
+    struct stack stack = { 0 };
+    int error = push(fuzzy, &stack, ROOT);
+
+    while (!error && stack.length > 0) {
+        const struct node *node = &fuzzy->nodes[stack.items[--stack.length]];
+        size_t radius = RADIUS(*k);
+        pstring_t entry;
+
+        entry_at(fuzzy, node - fuzzy->nodes, &entry);
+
+        /* past `radius + reach`, neither the node nor its children match */
+        size_t bound = SATURATE(radius, node->reach);
+        int distance = pstr__distance(query, &entry, bound, 0);
+        if (distance < 0) {
+            error = distance;
+            break;
+        }
+
+        if ((size_t)distance <= radius) {
+            int exact = pstr__distance(query, &entry, *k, 1);
+            if (exact < 0)
+                error = exact;
+            else if ((size_t)exact <= *k)
+                error = found(ctx, node - fuzzy->nodes, exact);
+        }
+
+        size_t low = (size_t)distance > radius ? distance - radius : 0;
+        size_t high = SATURATE((size_t)distance, radius);
+
+        for (size_t child = node->child; !error && child != NONE;
+             child = fuzzy->nodes[child].sibling) {
+            size_t edge = fuzzy->nodes[child].edge;
+            if (edge >= low && edge <= high)
+                error = push(fuzzy, &stack, child);
+        }
+    }
+
+    deallocate(fuzzy->allocator, stack.items, stack.capacity * sizeof(size_t));
+    return error;
+}
+
+struct each_ctx {
+    pstrfuzzy_fn *fn;
+    void *user;
+};
+
+static int found_each(void *ctx, size_t id, size_t distance) {
+    struct each_ctx *each = ctx;
+    return each->fn(each->user, id, distance) ? PSTRING_EINTR : PSTRING_OK;
+}
+
+int pstrfuzzy_each(
+    const pstrfuzzy_t *fuzzy,
+    const pstring_t *query,
+    size_t k,
+    pstrfuzzy_fn *fn,
+    void *user
+) {
+    if (!fuzzy || !query || !fn)
+        return PSTRING_EINVAL;
+
+    struct each_ctx ctx = { fn, user };
+    return walk(fuzzy, query, &k, found_each, &ctx);
+}
+
+struct nearest_ctx {
+    pstrfuzzy_match_t *out;
+    size_t length;
+    size_t capacity;
+    size_t *k;
+};
+
+static int found_nearest(void *ctx, size_t id, size_t distance) {
+    struct nearest_ctx *nearest = ctx;
+    pstrfuzzy_match_t *out = nearest->out;
+    size_t i = nearest->length;
+
+    if (i == nearest->capacity) {
+        const pstrfuzzy_match_t *last = &out[i - 1];
+        if (distance == last->distance && id > last->index)
+            return PSTRING_OK;
+        i--;
+    } else {
+        nearest->length++;
+    }
+
+    /* keep the matches sorted, shifting out the worst one if full */
+    for (; i > 0; i--) {
+        const pstrfuzzy_match_t *prev = &out[i - 1];
+        if (prev->distance < distance
+            || (prev->distance == distance && prev->index < id))
+            break;
+        out[i] = *prev;
+    }
+
+    out[i].index = id;
+    out[i].distance = distance;
+
+    /* once full, only matches at least as close as the last one can help */
+    if (nearest->length == nearest->capacity)
+        *nearest->k = out[nearest->length - 1].distance;
+    return PSTRING_OK;
+}
+
+int pstrfuzzy_nearest(
+    const pstrfuzzy_t *fuzzy,
+    const pstring_t *query,
+    size_t k,
+    pstrfuzzy_match_t *out,
+    size_t n
+) {
+    if (!fuzzy || !query || (!out && n > 0))
+        return PSTRING_EINVAL;
+
+    if (n == 0)
+        return 0;
+
+    struct nearest_ctx ctx = { out, 0, n, &k };
+    int error = walk(fuzzy, query, &k, found_nearest, &ctx);
+    return error ? error : (int)ctx.length;
+}
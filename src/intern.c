@@ -0,0 +1,194 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <pstring/allocators.h>
+#include <pstring/dictionary.h>
+#include <pstring/intern.h>
+#include <pstring/pstring.h>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "allocator_std.h"
+#include "internal.h"
+
+struct shard {
+    pthread_mutex_t lock;
+    pstrdict_t *dict;
+    pstrarena_t *arena;
+};
+
+typedef struct pstrintern_t {
+    allocator_t *allocator;
+    size_t size;  /* size of the allocation */
+    size_t count; /* number of initialized shards */
+    int locked;   /* whether shards are protected by their locks */
+    struct shard shards[];
+} pstrintern_t;
+
+/* All shards hash keys with the same seed, so a key is hashed once, for its
+   shard and its dictionary. Dictionaries index buckets using the low bits of
+   the hash, so the shard is chosen by the high bits after mixing. */
+static struct shard *shard_of(pstrintern_t *intern, const pstrkey_t *key) {
+    if (intern->count == 1)
+        return intern->shards;
+
+    uint64_t hash = (uint64_t)key->hash * 0x9E3779B97F4A7C15ull;
+    return &intern->shards[(hash >> 32) % intern->count];
+}
+
+/* Canonical strings are stored as a `pstring_t` followed by its contents,
+   so both are usually found in the same cache line. */
+static const pstring_t *insert(struct shard *shard, const pstrkey_t *key) {
+    allocator_t *arena = pstrarena_allocator(shard->arena);
+    const pstring_t *str = key->str;
+    size_t length = pstrlen(str);
+    pstring_t *out = allocate_aligned(
+        arena, sizeof(pstring_t) + length + 1, _Alignof(pstring_t)
+    );
+    if (!out)
+        return NULL;
+
+    char *buffer = (char *)&out[1];
+    memcpy(buffer, pstrbuf(str), length);
+    buffer[length] = '\0';
+
+    out->buffer = buffer;
+    out->base.length = length;
+    out->base.capacity = length;
+    out->base.allocator = NULL;
+
+    pstrkey_t stored = *key;
+    stored.str = out;
+    if (pstrdict_finsert_hashed(shard->dict, &stored, out)) {
+        deallocate(arena, out, sizeof(pstring_t) + length + 1);
+        return NULL;
+    }
+
+    return out;
+}
+
+pstrintern_t *pstrintern_new(size_t shards, allocator_t *allocator) {
+    if (!allocator)
+        allocator = &standard_allocator;
+
+    size_t count = shards ? shards : 1;
+    if (count > (SIZE_MAX - sizeof(pstrintern_t)) / sizeof(struct shard))
+        return NULL;
+
+    size_t size = sizeof(pstrintern_t) + count * sizeof(struct shard);
+    pstrintern_t *intern = zallocate(allocator, size);
+    if (!intern)
+        return NULL;
+
+    intern->allocator = allocator;
+    intern->size = size;
+    intern->count = count;
+    intern->locked = shards > 0;
+
+    size_t seed = pstr__random_seed(intern);
+    for (size_t i = 0; i < count; i++) {
+        struct shard *shard = &intern->shards[i];
+        shard->dict = pstrdict_new_seeded(seed, allocator);
+        shard->arena = pstrarena_new(0, allocator);
+        if (!shard->dict || !shard->arena
+            || pthread_mutex_init(&shard->lock, NULL)) {
+            pstrdict_free(shard->dict);
+            pstrarena_free(shard->arena);
+            intern->count = i;
+            pstrintern_free(intern);
+            return NULL;
+        }
+    }
+
+    return intern;
+}
+
+void pstrintern_free(pstrintern_t *intern) {
+    if (!intern)
+        return;
+
+    for (size_t i = 0; i < intern->count; i++) {
+        struct shard *shard = &intern->shards[i];
+        pthread_mutex_destroy(&shard->lock);
+        pstrdict_free(shard->dict);
+        pstrarena_free(shard->arena);
+    }
+
+    deallocate(intern->allocator, intern, intern->size);
+}
+
+size_t pstrintern_count(pstrintern_t *intern) {
+    if (!intern)
+        return 0;
+
+    size_t count = 0;
+    for (size_t i = 0; i < intern->count; i++) {
+        struct shard *shard = &intern->shards[i];
+        if (intern->locked)
+            pthread_mutex_lock(&shard->lock);
+
+        count += pstrdict_count(shard->dict);
+
+        if (intern->locked)
+            pthread_mutex_unlock(&shard->lock);
+    }
+
+    return count;
+}
+
+const pstring_t *pstrintern(pstrintern_t *intern, const pstring_t *str) {
+    if (!intern || !str)
+        return NULL;
+
+    pstrkey_t key;
+    pstrdict_key(intern->shards[0].dict, &key, str);
+    struct shard *shard = shard_of(intern, &key);
+    if (intern->locked)
+        pthread_mutex_lock(&shard->lock);
+
+    const pstring_t *out = pstrdict_get_hashed(shard->dict, &key);
+    if (!out)
+        out = insert(shard, &key);
+
+    if (intern->locked)
+        pthread_mutex_unlock(&shard->lock);
+
+    return out;
+}
+
+const pstring_t *pstrintern_find(pstrintern_t *intern, const pstring_t *str) {
+    if (!intern || !str)
+        return NULL;
+
+    pstrkey_t key;
+    pstrdict_key(intern->shards[0].dict, &key, str);
+    struct shard *shard = shard_of(intern, &key);
+    if (intern->locked)
+        pthread_mutex_lock(&shard->lock);
+
+    const pstring_t *out = pstrdict_get_hashed(shard->dict, &key);
+
+    if (intern->locked)
+        pthread_mutex_unlock(&shard->lock);
+
+    return out;
+}
@@ -0,0 +1,63 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/* Declarations shared between the sources of the library, which are not part
+   of its public interface. */
+
+#ifndef PSTRING_INTERNAL_H
+#define PSTRING_INTERNAL_H
+
+#include <stddef.h>
+
+/* Returns a seed for a hash table, read from the OS where it has a random
+   source, otherwise mixed from the time, a counter and the address of `salt`,
+   randomized by ASLR. */
+size_t pstr__random_seed(const void *salt);
+
+/* Decodes the whole vectors of valid UTF-8 at the start of `src` into UTF-16
+   or UTF-32 code units `width` bytes wide, with their bytes swapped if `swap`
+   is set. Writes at most `length` code units, storing their count in `units`,
+   and returns the number of bytes decoded. Characters of up to three bytes
+   are decoded where bytes can be shuffled, and those of four bytes only by
+   the AVX-512 kernel into UTF-32; the SSE2 kernel only decodes ASCII. */
+size_t pstr__decode_utf8(
+    void *dst,
+    size_t *units,
+    const char *src,
+    size_t length,
+    size_t width,
+    int swap
+);
+
+/* Encodes the whole vectors of UTF-16 or UTF-32 code units at the start of
+   `src` as UTF-8, storing the number of bytes in `bytes`, or only counting
+   them if `dst` is `NULL`, and returns the number of code units encoded.
+   Stops before surrogates and characters past the BMP, and the SSE2 kernel
+   only encodes ASCII. */
+size_t pstr__encode_utf8(
+    char *dst,
+    size_t *bytes,
+    const void *src,
+    size_t length,
+    size_t width,
+    int swap
+);
+
+#endif
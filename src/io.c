@@ -635,6 +635,9 @@ static size_t str_write(pstream_t *stream, const void *buffer, size_t size) {
     size_t index = (uintptr_t)stream->state.ptr[1];
     size_t left = pstrcap(str) - index;
 
+    if (pstr__writable(str))
+        return 0;
+
     if (size > left && pstrreserve(str, size))
         size = left;
 
@@ -838,6 +841,83 @@ int pstream_json(pstream_t *out, pstream_t *base) {
     return PSTRING_OK;
 }
 
+#define HASH_STREAM(x) ((struct hash_stream *)&(x)->state._size)
+
+struct hash_stream {
+    pstream_t *base;
+    pstrhash_state_t *state;
+};
+
+static size_t hash_read(pstream_t *stream, void *buffer, size_t size) {
+    struct hash_stream *hash = HASH_STREAM(stream);
+    size_t read = pstream_read(hash->base, buffer, size);
+
+    pstrhash_updates(hash->state, buffer, read);
+    return read;
+}
+
+static size_t hash_write(pstream_t *stream, const void *buffer, size_t size) {
+    struct hash_stream *hash = HASH_STREAM(stream);
+    size_t written = pstream_write(hash->base, buffer, size);
+
+    pstrhash_updates(hash->state, buffer, written);
+    return written;
+}
+
+static size_t hash_tell(pstream_t *stream) {
+    struct hash_stream *hash = HASH_STREAM(stream);
+    return pstream_tell(hash->base);
+}
+
+static int hash_seek(pstream_t *stream, long offset, int origin) {
+    return PSTRING_ENOSYS;
+}
+
+static void hash_flush(pstream_t *stream) {
+    struct hash_stream *hash = HASH_STREAM(stream);
+    return pstream_flush(hash->base);
+}
+
+static void hash_close(pstream_t *stream) {
+    struct hash_stream *hash = HASH_STREAM(stream);
+    return pstream_close(hash->base);
+}
+
+static int hash_serialize(pstream_t *stream, int type, const void *item) {
+    return srlz_text(stream, type, item);
+}
+
+static int hash_deserialize(pstream_t *stream, int type, void *item) {
+    return PSTRING_ENOSYS;
+}
+
+int pstream_hash(pstream_t *out, pstream_t *base, pstrhash_state_t *state) {
+    if (!out || !base || !state)
+        return PSTRING_EINVAL;
+
+    if (sizeof(struct hash_stream) > PSTREAM_STATE_SIZE)
+        return PSTRING_ENOSYS;
+    if (_Alignof(struct hash_stream) > _Alignof(void *))
+        return PSTRING_ENOSYS;
+
+    static const struct pstream_vt vtable = {
+        .read = hash_read,
+        .write = hash_write,
+        .tell = hash_tell,
+        .seek = hash_seek,
+        .flush = hash_flush,
+        .close = hash_close,
+        .serialize = hash_serialize,
+        .deserialize = hash_deserialize,
+    };
+
+    struct hash_stream *hash = HASH_STREAM(out);
+    out->vtable = &vtable;
+    hash->base = base;
+    hash->state = state;
+    return PSTRING_OK;
+}
+
 static int save_member(
     pstream_t *stream, const void *obj, const struct pstrmodel_member *member
 ) {
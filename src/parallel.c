@@ -0,0 +1,454 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <pstring/parallel.h>
+#include <pstring/pstring.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+#define MAX(x, y) ((x) > (y) ? (x) : (y))
+
+#define MAX_THREADS 64
+#define DEFAULT_THRESHOLD (1024 * 1024)
+
+/* Strings are split into a few chunks per thread, so threads finishing early
+   have something to steal, but not into chunks so small that handing them
+   out costs more than scanning them. */
+#define CHUNKS_PER_THREAD 4
+#define MAX_CHUNKS (MAX_THREADS * CHUNKS_PER_THREAD)
+#define MIN_CHUNK (64 * 1024)
+
+/* Chunk indices a thread has yet to run. Threads take chunks from the front
+   of their own range, and once it's empty, steal the back half of another
+   thread's range. */
+struct range {
+    pthread_mutex_t lock;
+    size_t next, end;
+    uint64_t seen; /* generation of the last job its worker woke up for */
+    pthread_t thread;
+};
+
+static struct pool {
+    pthread_once_t once;
+    pthread_mutex_t busy; /* held while a job is running */
+    pthread_mutex_t lock; /* protects the fields below */
+    pthread_cond_t wake, idle;
+    size_t workers; /* started worker threads, added as jobs ask for more */
+    size_t active;  /* workers still running the current job */
+    uint64_t generation;
+    int stopping; /* set while `pstrpar_shutdown` joins the workers */
+
+    void (*run)(void *ctx, size_t chunk);
+    void *ctx;
+    size_t threads; /* threads running the current job, including the caller */
+    struct range ranges[MAX_THREADS];
+} g_pool = {
+    .once = PTHREAD_ONCE_INIT,
+    .busy = PTHREAD_MUTEX_INITIALIZER,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .idle = PTHREAD_COND_INITIALIZER,
+};
+
+static size_t cpu_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t)count : 1;
+}
+
+static int take(size_t self, size_t *chunk) {
+    struct range *range = &g_pool.ranges[self];
+    int found = PSTRING_FALSE;
+
+    pthread_mutex_lock(&range->lock);
+    if (range->next < range->end) {
+        *chunk = range->next++;
+        found = PSTRING_TRUE;
+    }
+    pthread_mutex_unlock(&range->lock);
+
+    return found;
+}
+
+static int steal(size_t self, size_t *chunk) {
+    for (size_t i = 1; i < g_pool.threads; i++) {
+        struct range *victim = &g_pool.ranges[(self + i) % g_pool.threads];
+        size_t from, to;
+
+        pthread_mutex_lock(&victim->lock);
+        to = victim->end;
+        from = to - (to - victim->next) / 2;
+        if (from == to && victim->next < to)
+            from = to - 1;
+        victim->end = from;
+        pthread_mutex_unlock(&victim->lock);
+
+        if (from == to)
+            continue;
+
+        struct range *range = &g_pool.ranges[self];
+        pthread_mutex_lock(&range->lock);
+        range->next = from + 1;
+        range->end = to;
+        pthread_mutex_unlock(&range->lock);
+
+        *chunk = from;
+        return PSTRING_TRUE;
+    }
+
+    return PSTRING_FALSE;
+}
+
+static void work(size_t self) {
+    size_t chunk;
+
+    while (take(self, &chunk) || steal(self, &chunk))
+        g_pool.run(g_pool.ctx, chunk);
+}
+
+static void *worker(void *arg) {
+    size_t self = (size_t)(uintptr_t)arg;
+    uint64_t *seen = &g_pool.ranges[self].seen;
+
+    pthread_mutex_lock(&g_pool.lock);
+    for (;;) {
+        while (g_pool.generation == *seen && !g_pool.stopping)
+            pthread_cond_wait(&g_pool.wake, &g_pool.lock);
+
+        if (g_pool.stopping)
+            break;
+
+        *seen = g_pool.generation;
+        if (self >= g_pool.threads)
+            continue;
+
+        pthread_mutex_unlock(&g_pool.lock);
+        work(self);
+        pthread_mutex_lock(&g_pool.lock);
+
+        if (--g_pool.active == 0)
+            pthread_cond_signal(&g_pool.idle);
+    }
+    pthread_mutex_unlock(&g_pool.lock);
+
+    return NULL;
+}
+
+static void pool_init(void) {
+    for (size_t i = 0; i < MAX_THREADS; i++)
+        pthread_mutex_init(&g_pool.ranges[i].lock, NULL);
+}
+
+/* Starts workers until there are `workers` of them, which must be done while
+   holding `busy` so that none of them miss the next job. */
+static void pool_grow(size_t workers) {
+    pthread_mutex_lock(&g_pool.lock);
+    while (g_pool.workers < workers) {
+        size_t self = g_pool.workers + 1;
+        struct range *range = &g_pool.ranges[self];
+        void *arg = (void *)(uintptr_t)self;
+
+        range->seen = g_pool.generation;
+        if (pthread_create(&range->thread, NULL, &worker, arg))
+            break;
+
+        g_pool.workers = self;
+    }
+    pthread_mutex_unlock(&g_pool.lock);
+}
+
+/* Runs `run` for every chunk below `chunks` on at most `threads` threads,
+   starting more workers if needed. The calling thread runs all of them
+   itself if the pool is busy. */
+static void pool_run(
+    size_t threads, size_t chunks, void (*run)(void *, size_t), void *ctx
+) {
+    pthread_once(&g_pool.once, &pool_init);
+    threads = MIN(threads, chunks);
+
+    if (threads < 2 || pthread_mutex_trylock(&g_pool.busy)) {
+        for (size_t i = 0; i < chunks; i++)
+            run(ctx, i);
+        return;
+    }
+
+    pool_grow(threads - 1);
+    threads = MIN(threads, g_pool.workers + 1);
+
+    for (size_t i = 0; i < threads; i++) {
+        g_pool.ranges[i].next = chunks * i / threads;
+        g_pool.ranges[i].end = chunks * (i + 1) / threads;
+    }
+
+    pthread_mutex_lock(&g_pool.lock);
+    g_pool.run = run;
+    g_pool.ctx = ctx;
+    g_pool.threads = threads;
+    g_pool.active = threads - 1;
+    g_pool.generation++;
+    pthread_cond_broadcast(&g_pool.wake);
+    pthread_mutex_unlock(&g_pool.lock);
+
+    work(0);
+
+    pthread_mutex_lock(&g_pool.lock);
+    while (g_pool.active > 0)
+        pthread_cond_wait(&g_pool.idle, &g_pool.lock);
+    pthread_mutex_unlock(&g_pool.lock);
+
+    pthread_mutex_unlock(&g_pool.busy);
+}
+
+void pstrpar_shutdown(void) {
+    pthread_once(&g_pool.once, &pool_init);
+    pthread_mutex_lock(&g_pool.busy);
+
+    pthread_mutex_lock(&g_pool.lock);
+    g_pool.stopping = PSTRING_TRUE;
+    pthread_cond_broadcast(&g_pool.wake);
+    pthread_mutex_unlock(&g_pool.lock);
+
+    for (size_t i = 1; i <= g_pool.workers; i++)
+        pthread_join(g_pool.ranges[i].thread, NULL);
+
+    g_pool.workers = 0;
+    g_pool.stopping = PSTRING_FALSE;
+    pthread_mutex_unlock(&g_pool.busy);
+}
+
+/* A string split into chunks, each extended by `overlap` bytes. */
+struct split {
+    const char *buffer;
+    size_t length, size, chunks, overlap;
+};
+
+/* Splits `str` for `par`, returning the number of threads to use, or zero if
+   it's too short to be worth splitting. */
+static size_t split(
+    struct split *out,
+    const pstring_t *str,
+    size_t overlap,
+    const pstrpar_t *par
+) {
+    size_t threads = par && par->threads ? par->threads : cpu_count();
+    size_t threshold = par && par->threshold ? par->threshold
+                                             : DEFAULT_THRESHOLD;
+
+    out->buffer = pstrbuf(str);
+    out->length = pstrlen(str);
+    out->overlap = overlap;
+
+    threads = MIN(threads, MAX_THREADS);
+    if (threads < 2 || out->length < MAX(threshold, 2 * MIN_CHUNK))
+        return 0;
+
+    out->chunks = MIN(out->length / MIN_CHUNK, threads * CHUNKS_PER_THREAD);
+    out->size = (out->length + out->chunks - 1) / out->chunks;
+    out->chunks = (out->length + out->size - 1) / out->size;
+    return threads;
+}
+
+/* Slices chunk `index` of `split`, including the overlap after it. */
+static void chunk_at(
+    pstring_t *out, const struct split *split, size_t index
+) {
+    size_t from = index * split->size;
+    size_t to = MIN(from + split->size + split->overlap, split->length);
+
+    pstrwrap(out, (char *)&split->buffer[from], to - from, to - from);
+}
+
+struct search {
+    struct split split;
+    const pstring_t *sub;
+    int ch;
+    atomic_size_t first; /* offset of the first match found so far */
+};
+
+static void search_chunk(void *ctx, size_t index) {
+    struct search *search = ctx;
+    pstring_t window;
+    size_t from = index * search->split.size;
+
+    /* chunks are taken in order, so most after a match are skipped */
+    if (from >= atomic_load_explicit(&search->first, memory_order_relaxed))
+        return;
+
+    chunk_at(&window, &search->split, index);
+    if (pstrlen(&window) == 0)
+        return;
+
+    char *match = search->sub ? pstrstr(&window, search->sub)
+                              : pstrchr(&window, search->ch);
+    if (!match)
+        return;
+
+    size_t offset = match - search->split.buffer;
+    size_t first = atomic_load_explicit(&search->first, memory_order_relaxed);
+    while (offset < first
+           && !atomic_compare_exchange_weak(&search->first, &first, offset))
+        ;
+}
+
+static char *search_par(
+    const pstring_t *str, const pstring_t *sub, int ch, const pstrpar_t *par
+) {
+    struct search search = { .sub = sub, .ch = ch };
+    size_t overlap = sub ? pstrlen(sub) - 1 : 0;
+    size_t threads = split(&search.split, str, overlap, par);
+
+    if (!threads)
+        return sub ? pstrstr(str, sub) : pstrchr(str, ch);
+
+    atomic_init(&search.first, SIZE_MAX);
+    pool_run(threads, search.split.chunks, &search_chunk, &search);
+
+    size_t first = atomic_load(&search.first);
+    return first == SIZE_MAX ? NULL : (char *)&search.split.buffer[first];
+}
+
+char *pstrchr_par(const pstring_t *str, int ch, const pstrpar_t *par) {
+    if (!str)
+        return NULL;
+
+    return search_par(str, NULL, ch, par);
+}
+
+char *pstrstr_par(
+    const pstring_t *str, const pstring_t *sub, const pstrpar_t *par
+) {
+    if (!str || !sub || pstrlen(sub) == 0 || pstrlen(sub) > pstrlen(str))
+        return pstrstr(str, sub);
+
+    return search_par(str, sub, 0, par);
+}
+
+struct count {
+    struct split split;
+    const pstring_t *sub;
+    size_t counts[MAX_CHUNKS];
+    size_t ends[MAX_CHUNKS]; /* end of the last match counted */
+};
+
+/* Counts the matches starting between `from` and the end of chunk `index`,
+   the same way `pstrcount` does, storing the end of the last one. */
+static size_t count_from(struct count *count, size_t index, size_t from) {
+    const char *buffer = count->split.buffer;
+    size_t length = pstrlen(count->sub), matches = 0;
+    size_t to = MIN((index + 1) * count->split.size, count->split.length);
+    size_t end = MIN(to + length - 1, count->split.length);
+    pstring_t search;
+    char *match;
+
+    count->ends[index] = 0;
+    pstrrange(&search, NULL, &buffer[from], &buffer[end]);
+
+    while ((match = pstrstr(&search, count->sub))) {
+        if ((size_t)(match - buffer) >= to)
+            break;
+
+        matches++;
+        count->ends[index] = match - buffer + length;
+        pstrrange(&search, NULL, match + length, &buffer[end]);
+    }
+
+    return matches;
+}
+
+static void count_chunk(void *ctx, size_t index) {
+    struct count *count = ctx;
+    count->counts[index] = count_from(count, index, index * count->split.size);
+}
+
+size_t pstrcount_par(
+    const pstring_t *str, const pstring_t *sub, const pstrpar_t *par
+) {
+    if (!str || !sub || pstrlen(sub) == 0)
+        return 0;
+
+    struct count count = { .sub = sub };
+    size_t threads = split(&count.split, str, pstrlen(sub) - 1, par);
+
+    if (!threads)
+        return pstrcount(str, sub);
+
+    pool_run(threads, count.split.chunks, &count_chunk, &count);
+
+    /* a match crossing into the next chunk hides the matches it overlaps,
+       which are only known once all chunks before it are counted */
+    size_t total = 0, prev = 0;
+    for (size_t i = 0; i < count.split.chunks; i++) {
+        size_t from = i * count.split.size;
+
+        if (prev > from) {
+            size_t to = MIN(from + count.split.size, count.split.length);
+            count.counts[i] = prev < to ? count_from(&count, i, prev) : 0;
+            if (prev >= to)
+                count.ends[i] = 0;
+        }
+
+        total += count.counts[i];
+        prev = MAX(prev, count.ends[i]);
+    }
+
+    return total;
+}
+
+struct replace {
+    struct split split;
+    char src, dst;
+};
+
+static void replace_chunk(void *ctx, size_t index) {
+    struct replace *replace = ctx;
+    pstring_t search;
+    char *match, *end;
+
+    chunk_at(&search, &replace->split, index);
+    end = pstrend(&search);
+
+    while ((match = pstrchr(&search, replace->src))) {
+        *match = replace->dst;
+        pstrrange(&search, NULL, match + 1, end);
+    }
+}
+
+int pstrreplc_par(
+    pstring_t *str, char src, char dst, size_t max, const pstrpar_t *par
+) {
+    struct replace replace = { .src = src, .dst = dst };
+    size_t threads;
+
+    if (!str || src == dst || max > 0)
+        return pstrreplc(str, src, dst, max);
+
+    if (pstr__writable(str))
+        return PSTRING_ENOMEM;
+
+    threads = split(&replace.split, str, 0, par);
+    if (!threads)
+        return pstrreplc(str, src, dst, max);
+
+    pool_run(threads, replace.split.chunks, &replace_chunk, &replace);
+    return PSTRING_OK;
+}
@@ -18,7 +18,10 @@
     limitations under the License.
 */
 
+#include <pstring/encoding.h>
 #include <pstring/pstring.h>
+#include <stdatomic.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 #include <time.h>
@@ -29,20 +32,66 @@
 #include <allocator.h>
 #include <allocator_std.h>
 
-#if !defined(PSTRING_NO_AVX) && defined(__AVX__)
+#include "internal.h"
+
+/* With GCC and Clang on x86, kernels for newer instruction sets are built
+   using target attributes and selected when the library is loaded, so the
+   same binary runs at full speed on any CPU. */
+#if !defined(PSTRING_NO_DISPATCH) && defined(__GNUC__) \
+    && (defined(__x86_64__) || defined(__i386__))
+    #define PSTRING_DISPATCH
+    #define PSTRING_TARGET(isa) __attribute__((target(isa)))
+#else
+    #define PSTRING_TARGET(isa)
+#endif
+
+#if !defined(PSTRING_NO_AVX) \
+    && (defined(__AVX2__) || defined(PSTRING_DISPATCH))
     #include <immintrin.h>
     #define PSTRING_AVX
 #endif
 
-#if !defined(PSTRING_NO_SSE) && defined(__SSE2__)
+#if !defined(PSTRING_NO_AVX512) && defined(PSTRING_AVX) \
+    && (defined(__AVX512BW__) || defined(PSTRING_DISPATCH))
+    #define PSTRING_AVX512
+#endif
+
+#if !defined(PSTRING_NO_SSE) \
+    && (defined(__SSE2__) || defined(PSTRING_DISPATCH))
     #include <emmintrin.h>
     #define PSTRING_SSE
 #endif
 
+#if defined(PSTRING_SSE) && (defined(__SSSE3__) || defined(PSTRING_DISPATCH))
+    #include <tmmintrin.h>
+    #define PSTRING_SSSE3
+#endif
+
+#if !defined(PSTRING_NO_NEON) && defined(__ARM_NEON) && defined(__aarch64__)
+    #include <arm_neon.h>
+    #define PSTRING_NEON
+#endif
+
+/* Without dispatch, only the kernels of the best instruction set enabled by
+   the compiler flags can be selected, so the older ones aren't built. */
+#if defined(PSTRING_DISPATCH) || !defined(PSTRING_AVX512)
+    #define PSTRING_AVX_KERNELS
+#endif
+
+#if defined(PSTRING_DISPATCH) || !defined(PSTRING_AVX)
+    #define PSTRING_SSE_KERNELS
+#endif
+
+#if defined(PSTRING_DISPATCH) || !defined(PSTRING_SSSE3)
+    #define PSTRING_SSE2_KERNELS
+#endif
+
 #ifdef PSTRING_AVX
     #define ALIGNMENT (_Alignof(__m256i))
 #elif defined(PSTRING_SSE)
     #define ALIGNMENT (_Alignof(__m128i))
+#elif defined(PSTRING_NEON)
+    #define ALIGNMENT (_Alignof(uint8x16_t))
 #else
     #define ALIGNMENT (_Alignof(char))
 #endif
@@ -56,7 +105,824 @@
 #define GROWTH(old, req) (((old) + (req)) * 2 - (old))
 #define PSTRING_MAX_SET 256
 
-#ifdef PSTRING_AVX
+/* Shared buffers are preceded by a header holding their reference count and
+   the allocator of the whole block, padded so the buffer keeps at least the
+   alignment a plain malloc() would have given it. */
+#define SHARE_ALIGN MAX(ALIGNMENT, _Alignof(max_align_t))
+#define SHARE_HEADER ALIGN(sizeof(struct share), SHARE_ALIGN)
+
+/* bytes a substring search may spend verifying false positives
+   before it switches to the linear time Two-Way algorithm */
+#define SEARCH_BUDGET(scanned) ((scanned) * 4 + 4096)
+
+/* UTF-16 code units a byte of valid UTF-8 adds: one for every lead byte,
+   plus one for the low surrogate of four byte characters if requested */
+static inline size_t pstr__utf8_units(char byte, int surrogates) {
+    return ((byte & 0xC0) != 0x80) + (surrogates && (byte & 0xF0) == 0xF0);
+}
+
+#if defined(PSTRING_SSSE3) || defined(PSTRING_AVX) || defined(PSTRING_NEON)
+/* Keiser and Lemire's UTF-8 validation looks up each byte's high nibble and
+   low nibble, and the high nibble of the following byte, in three tables.
+   Each bit stands for a kind of error, which is found when all three
+   lookups have it set. Two continuation bytes are only allowed after a
+   three or four byte lead, which is checked separately. */
+    #define UTF8_TOO_SHORT (1 << 0)
+    #define UTF8_TOO_LONG (1 << 1)
+    #define UTF8_OVERLONG_3 (1 << 2)
+    #define UTF8_TOO_LARGE (1 << 3)
+    #define UTF8_SURROGATE (1 << 4)
+    #define UTF8_OVERLONG_2 (1 << 5)
+    #define UTF8_OVERLONG_4 (1 << 6)
+    #define UTF8_TOO_LARGE_1000 (1 << 6)
+    #define UTF8_TWO_CONTS (1 << 7)
+    #define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+static const uint8_t utf8_high[16] = {
+    UTF8_TOO_LONG,
+    UTF8_TOO_LONG,
+    UTF8_TOO_LONG,
+    UTF8_TOO_LONG,
+    UTF8_TOO_LONG,
+    UTF8_TOO_LONG,
+    UTF8_TOO_LONG,
+    UTF8_TOO_LONG,
+    UTF8_TWO_CONTS,
+    UTF8_TWO_CONTS,
+    UTF8_TWO_CONTS,
+    UTF8_TWO_CONTS,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+    UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+};
+
+static const uint8_t utf8_low[16] = {
+    UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+    UTF8_CARRY | UTF8_OVERLONG_2,
+    UTF8_CARRY,
+    UTF8_CARRY,
+    UTF8_CARRY | UTF8_TOO_LARGE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+};
+
+static const uint8_t utf8_next[16] = {
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3
+        | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3
+        | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE
+        | UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE
+        | UTF8_TOO_LARGE,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT,
+};
+
+/* the last three bytes of a block can't be leads of characters that
+   continue past it, subtracting these leaves only those that do */
+static const uint8_t utf8_incomplete[16] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xf0 - 1, 0xe0 - 1, 0xc0 - 1,
+};
+
+/* Number of bits set in the byte `x`, looked up a nibble at a time. */
+static inline size_t pstr__bits8(unsigned x) {
+    const uint64_t bits = 0x4332322132212110;
+    return (bits >> (x & 0xF) * 4 & 0xF) + (bits >> (x >> 4 & 0xF) * 4 & 0xF);
+}
+#endif
+
+#if (defined(PSTRING_SSSE3) && defined(PSTRING_SSE_KERNELS)) \
+    || (defined(PSTRING_AVX) && defined(PSTRING_AVX_KERNELS)) \
+    || defined(PSTRING_NEON)
+/* Rows of pshufb shuffles packed into nibbles, expanded by the kernels. This
+   one keeps the 16-bit lanes whose bit is set, packed at the start. */
+static const uint64_t utf8_compress[256] = {
+    0x0000000000000000, 0x0000000000000010, 0x0000000000000032,
+    0x0000000000003210, 0x0000000000000054, 0x0000000000005410,
+    0x0000000000005432, 0x0000000000543210, 0x0000000000000076,
+    0x0000000000007610, 0x0000000000007632, 0x0000000000763210,
+    0x0000000000007654, 0x0000000000765410, 0x0000000000765432,
+    0x0000000076543210, 0x0000000000000098, 0x0000000000009810,
+    0x0000000000009832, 0x0000000000983210, 0x0000000000009854,
+    0x0000000000985410, 0x0000000000985432, 0x0000000098543210,
+    0x0000000000009876, 0x0000000000987610, 0x0000000000987632,
+    0x0000000098763210, 0x0000000000987654, 0x0000000098765410,
+    0x0000000098765432, 0x0000009876543210, 0x00000000000000ba,
+    0x000000000000ba10, 0x000000000000ba32, 0x0000000000ba3210,
+    0x000000000000ba54, 0x0000000000ba5410, 0x0000000000ba5432,
+    0x00000000ba543210, 0x000000000000ba76, 0x0000000000ba7610,
+    0x0000000000ba7632, 0x00000000ba763210, 0x0000000000ba7654,
+    0x00000000ba765410, 0x00000000ba765432, 0x000000ba76543210,
+    0x000000000000ba98, 0x0000000000ba9810, 0x0000000000ba9832,
+    0x00000000ba983210, 0x0000000000ba9854, 0x00000000ba985410,
+    0x00000000ba985432, 0x000000ba98543210, 0x0000000000ba9876,
+    0x00000000ba987610, 0x00000000ba987632, 0x000000ba98763210,
+    0x00000000ba987654, 0x000000ba98765410, 0x000000ba98765432,
+    0x0000ba9876543210, 0x00000000000000dc, 0x000000000000dc10,
+    0x000000000000dc32, 0x0000000000dc3210, 0x000000000000dc54,
+    0x0000000000dc5410, 0x0000000000dc5432, 0x00000000dc543210,
+    0x000000000000dc76, 0x0000000000dc7610, 0x0000000000dc7632,
+    0x00000000dc763210, 0x0000000000dc7654, 0x00000000dc765410,
+    0x00000000dc765432, 0x000000dc76543210, 0x000000000000dc98,
+    0x0000000000dc9810, 0x0000000000dc9832, 0x00000000dc983210,
+    0x0000000000dc9854, 0x00000000dc985410, 0x00000000dc985432,
+    0x000000dc98543210, 0x0000000000dc9876, 0x00000000dc987610,
+    0x00000000dc987632, 0x000000dc98763210, 0x00000000dc987654,
+    0x000000dc98765410, 0x000000dc98765432, 0x0000dc9876543210,
+    0x000000000000dcba, 0x0000000000dcba10, 0x0000000000dcba32,
+    0x00000000dcba3210, 0x0000000000dcba54, 0x00000000dcba5410,
+    0x00000000dcba5432, 0x000000dcba543210, 0x0000000000dcba76,
+    0x00000000dcba7610, 0x00000000dcba7632, 0x000000dcba763210,
+    0x00000000dcba7654, 0x000000dcba765410, 0x000000dcba765432,
+    0x0000dcba76543210, 0x0000000000dcba98, 0x00000000dcba9810,
+    0x00000000dcba9832, 0x000000dcba983210, 0x00000000dcba9854,
+    0x000000dcba985410, 0x000000dcba985432, 0x0000dcba98543210,
+    0x00000000dcba9876, 0x000000dcba987610, 0x000000dcba987632,
+    0x0000dcba98763210, 0x000000dcba987654, 0x0000dcba98765410,
+    0x0000dcba98765432, 0x00dcba9876543210, 0x00000000000000fe,
+    0x000000000000fe10, 0x000000000000fe32, 0x0000000000fe3210,
+    0x000000000000fe54, 0x0000000000fe5410, 0x0000000000fe5432,
+    0x00000000fe543210, 0x000000000000fe76, 0x0000000000fe7610,
+    0x0000000000fe7632, 0x00000000fe763210, 0x0000000000fe7654,
+    0x00000000fe765410, 0x00000000fe765432, 0x000000fe76543210,
+    0x000000000000fe98, 0x0000000000fe9810, 0x0000000000fe9832,
+    0x00000000fe983210, 0x0000000000fe9854, 0x00000000fe985410,
+    0x00000000fe985432, 0x000000fe98543210, 0x0000000000fe9876,
+    0x00000000fe987610, 0x00000000fe987632, 0x000000fe98763210,
+    0x00000000fe987654, 0x000000fe98765410, 0x000000fe98765432,
+    0x0000fe9876543210, 0x000000000000feba, 0x0000000000feba10,
+    0x0000000000feba32, 0x00000000feba3210, 0x0000000000feba54,
+    0x00000000feba5410, 0x00000000feba5432, 0x000000feba543210,
+    0x0000000000feba76, 0x00000000feba7610, 0x00000000feba7632,
+    0x000000feba763210, 0x00000000feba7654, 0x000000feba765410,
+    0x000000feba765432, 0x0000feba76543210, 0x0000000000feba98,
+    0x00000000feba9810, 0x00000000feba9832, 0x000000feba983210,
+    0x00000000feba9854, 0x000000feba985410, 0x000000feba985432,
+    0x0000feba98543210, 0x00000000feba9876, 0x000000feba987610,
+    0x000000feba987632, 0x0000feba98763210, 0x000000feba987654,
+    0x0000feba98765410, 0x0000feba98765432, 0x00feba9876543210,
+    0x000000000000fedc, 0x0000000000fedc10, 0x0000000000fedc32,
+    0x00000000fedc3210, 0x0000000000fedc54, 0x00000000fedc5410,
+    0x00000000fedc5432, 0x000000fedc543210, 0x0000000000fedc76,
+    0x00000000fedc7610, 0x00000000fedc7632, 0x000000fedc763210,
+    0x00000000fedc7654, 0x000000fedc765410, 0x000000fedc765432,
+    0x0000fedc76543210, 0x0000000000fedc98, 0x00000000fedc9810,
+    0x00000000fedc9832, 0x000000fedc983210, 0x00000000fedc9854,
+    0x000000fedc985410, 0x000000fedc985432, 0x0000fedc98543210,
+    0x00000000fedc9876, 0x000000fedc987610, 0x000000fedc987632,
+    0x0000fedc98763210, 0x000000fedc987654, 0x0000fedc98765410,
+    0x0000fedc98765432, 0x00fedc9876543210, 0x0000000000fedcba,
+    0x00000000fedcba10, 0x00000000fedcba32, 0x000000fedcba3210,
+    0x00000000fedcba54, 0x000000fedcba5410, 0x000000fedcba5432,
+    0x0000fedcba543210, 0x00000000fedcba76, 0x000000fedcba7610,
+    0x000000fedcba7632, 0x0000fedcba763210, 0x000000fedcba7654,
+    0x0000fedcba765410, 0x0000fedcba765432, 0x00fedcba76543210,
+    0x00000000fedcba98, 0x000000fedcba9810, 0x000000fedcba9832,
+    0x0000fedcba983210, 0x000000fedcba9854, 0x0000fedcba985410,
+    0x0000fedcba985432, 0x00fedcba98543210, 0x000000fedcba9876,
+    0x0000fedcba987610, 0x0000fedcba987632, 0x00fedcba98763210,
+    0x0000fedcba987654, 0x00fedcba98765410, 0x00fedcba98765432,
+    0xfedcba9876543210,
+};
+
+/* Packs 16-bit lanes holding the one or two bytes of a UTF-8 character,
+   keeping the second byte of those whose bit is set. */
+static const uint64_t utf8_pack2[256] = {
+    0x00000000eca86420, 0x0000000eca864210, 0x0000000eca864320,
+    0x000000eca8643210, 0x0000000eca865420, 0x000000eca8654210,
+    0x000000eca8654320, 0x00000eca86543210, 0x0000000eca876420,
+    0x000000eca8764210, 0x000000eca8764320, 0x00000eca87643210,
+    0x000000eca8765420, 0x00000eca87654210, 0x00000eca87654320,
+    0x0000eca876543210, 0x0000000eca986420, 0x000000eca9864210,
+    0x000000eca9864320, 0x00000eca98643210, 0x000000eca9865420,
+    0x00000eca98654210, 0x00000eca98654320, 0x0000eca986543210,
+    0x000000eca9876420, 0x00000eca98764210, 0x00000eca98764320,
+    0x0000eca987643210, 0x00000eca98765420, 0x0000eca987654210,
+    0x0000eca987654320, 0x000eca9876543210, 0x0000000ecba86420,
+    0x000000ecba864210, 0x000000ecba864320, 0x00000ecba8643210,
+    0x000000ecba865420, 0x00000ecba8654210, 0x00000ecba8654320,
+    0x0000ecba86543210, 0x000000ecba876420, 0x00000ecba8764210,
+    0x00000ecba8764320, 0x0000ecba87643210, 0x00000ecba8765420,
+    0x0000ecba87654210, 0x0000ecba87654320, 0x000ecba876543210,
+    0x000000ecba986420, 0x00000ecba9864210, 0x00000ecba9864320,
+    0x0000ecba98643210, 0x00000ecba9865420, 0x0000ecba98654210,
+    0x0000ecba98654320, 0x000ecba986543210, 0x00000ecba9876420,
+    0x0000ecba98764210, 0x0000ecba98764320, 0x000ecba987643210,
+    0x0000ecba98765420, 0x000ecba987654210, 0x000ecba987654320,
+    0x00ecba9876543210, 0x0000000edca86420, 0x000000edca864210,
+    0x000000edca864320, 0x00000edca8643210, 0x000000edca865420,
+    0x00000edca8654210, 0x00000edca8654320, 0x0000edca86543210,
+    0x000000edca876420, 0x00000edca8764210, 0x00000edca8764320,
+    0x0000edca87643210, 0x00000edca8765420, 0x0000edca87654210,
+    0x0000edca87654320, 0x000edca876543210, 0x000000edca986420,
+    0x00000edca9864210, 0x00000edca9864320, 0x0000edca98643210,
+    0x00000edca9865420, 0x0000edca98654210, 0x0000edca98654320,
+    0x000edca986543210, 0x00000edca9876420, 0x0000edca98764210,
+    0x0000edca98764320, 0x000edca987643210, 0x0000edca98765420,
+    0x000edca987654210, 0x000edca987654320, 0x00edca9876543210,
+    0x000000edcba86420, 0x00000edcba864210, 0x00000edcba864320,
+    0x0000edcba8643210, 0x00000edcba865420, 0x0000edcba8654210,
+    0x0000edcba8654320, 0x000edcba86543210, 0x00000edcba876420,
+    0x0000edcba8764210, 0x0000edcba8764320, 0x000edcba87643210,
+    0x0000edcba8765420, 0x000edcba87654210, 0x000edcba87654320,
+    0x00edcba876543210, 0x00000edcba986420, 0x0000edcba9864210,
+    0x0000edcba9864320, 0x000edcba98643210, 0x0000edcba9865420,
+    0x000edcba98654210, 0x000edcba98654320, 0x00edcba986543210,
+    0x0000edcba9876420, 0x000edcba98764210, 0x000edcba98764320,
+    0x00edcba987643210, 0x000edcba98765420, 0x00edcba987654210,
+    0x00edcba987654320, 0x0edcba9876543210, 0x0000000feca86420,
+    0x000000feca864210, 0x000000feca864320, 0x00000feca8643210,
+    0x000000feca865420, 0x00000feca8654210, 0x00000feca8654320,
+    0x0000feca86543210, 0x000000feca876420, 0x00000feca8764210,
+    0x00000feca8764320, 0x0000feca87643210, 0x00000feca8765420,
+    0x0000feca87654210, 0x0000feca87654320, 0x000feca876543210,
+    0x000000feca986420, 0x00000feca9864210, 0x00000feca9864320,
+    0x0000feca98643210, 0x00000feca9865420, 0x0000feca98654210,
+    0x0000feca98654320, 0x000feca986543210, 0x00000feca9876420,
+    0x0000feca98764210, 0x0000feca98764320, 0x000feca987643210,
+    0x0000feca98765420, 0x000feca987654210, 0x000feca987654320,
+    0x00feca9876543210, 0x000000fecba86420, 0x00000fecba864210,
+    0x00000fecba864320, 0x0000fecba8643210, 0x00000fecba865420,
+    0x0000fecba8654210, 0x0000fecba8654320, 0x000fecba86543210,
+    0x00000fecba876420, 0x0000fecba8764210, 0x0000fecba8764320,
+    0x000fecba87643210, 0x0000fecba8765420, 0x000fecba87654210,
+    0x000fecba87654320, 0x00fecba876543210, 0x00000fecba986420,
+    0x0000fecba9864210, 0x0000fecba9864320, 0x000fecba98643210,
+    0x0000fecba9865420, 0x000fecba98654210, 0x000fecba98654320,
+    0x00fecba986543210, 0x0000fecba9876420, 0x000fecba98764210,
+    0x000fecba98764320, 0x00fecba987643210, 0x000fecba98765420,
+    0x00fecba987654210, 0x00fecba987654320, 0x0fecba9876543210,
+    0x000000fedca86420, 0x00000fedca864210, 0x00000fedca864320,
+    0x0000fedca8643210, 0x00000fedca865420, 0x0000fedca8654210,
+    0x0000fedca8654320, 0x000fedca86543210, 0x00000fedca876420,
+    0x0000fedca8764210, 0x0000fedca8764320, 0x000fedca87643210,
+    0x0000fedca8765420, 0x000fedca87654210, 0x000fedca87654320,
+    0x00fedca876543210, 0x00000fedca986420, 0x0000fedca9864210,
+    0x0000fedca9864320, 0x000fedca98643210, 0x0000fedca9865420,
+    0x000fedca98654210, 0x000fedca98654320, 0x00fedca986543210,
+    0x0000fedca9876420, 0x000fedca98764210, 0x000fedca98764320,
+    0x00fedca987643210, 0x000fedca98765420, 0x00fedca987654210,
+    0x00fedca987654320, 0x0fedca9876543210, 0x00000fedcba86420,
+    0x0000fedcba864210, 0x0000fedcba864320, 0x000fedcba8643210,
+    0x0000fedcba865420, 0x000fedcba8654210, 0x000fedcba8654320,
+    0x00fedcba86543210, 0x0000fedcba876420, 0x000fedcba8764210,
+    0x000fedcba8764320, 0x00fedcba87643210, 0x000fedcba8765420,
+    0x00fedcba87654210, 0x00fedcba87654320, 0x0fedcba876543210,
+    0x0000fedcba986420, 0x000fedcba9864210, 0x000fedcba9864320,
+    0x00fedcba98643210, 0x000fedcba9865420, 0x00fedcba98654210,
+    0x00fedcba98654320, 0x0fedcba986543210, 0x000fedcba9876420,
+    0x00fedcba98764210, 0x00fedcba98764320, 0x0fedcba987643210,
+    0x00fedcba98765420, 0x0fedcba987654210, 0x0fedcba987654320,
+    0xfedcba9876543210,
+};
+
+/* Packs 32-bit lanes holding the one to three bytes of a UTF-8 character,
+   indexed by a nibble of those with two bytes or more, followed by a nibble
+   of those with three. */
+static const uint64_t utf8_pack3[256] = {
+    0x000000000000c840, 0x00000000000c8410, 0x00000000000c8540,
+    0x0000000000c85410, 0x00000000000c9840, 0x0000000000c98410,
+    0x0000000000c98540, 0x000000000c985410, 0x00000000000dc840,
+    0x0000000000dc8410, 0x0000000000dc8540, 0x000000000dc85410,
+    0x0000000000dc9840, 0x000000000dc98410, 0x000000000dc98540,
+    0x00000000dc985410, 0x0000000000000000, 0x0000000000c84210,
+    0x0000000000000000, 0x000000000c854210, 0x0000000000000000,
+    0x000000000c984210, 0x0000000000000000, 0x00000000c9854210,
+    0x0000000000000000, 0x000000000dc84210, 0x0000000000000000,
+    0x00000000dc854210, 0x0000000000000000, 0x00000000dc984210,
+    0x0000000000000000, 0x0000000dc9854210, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000c86540, 0x000000000c865410,
+    0x0000000000000000, 0x0000000000000000, 0x000000000c986540,
+    0x00000000c9865410, 0x0000000000000000, 0x0000000000000000,
+    0x000000000dc86540, 0x00000000dc865410, 0x0000000000000000,
+    0x0000000000000000, 0x00000000dc986540, 0x0000000dc9865410,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x00000000c8654210, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000c98654210, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000dc8654210,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x000000dc98654210, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000ca9840,
+    0x000000000ca98410, 0x000000000ca98540, 0x00000000ca985410,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x000000000dca9840, 0x00000000dca98410,
+    0x00000000dca98540, 0x0000000dca985410, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x00000000ca984210, 0x0000000000000000,
+    0x0000000ca9854210, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000dca984210, 0x0000000000000000, 0x000000dca9854210,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x00000000ca986540, 0x0000000ca9865410, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000dca986540,
+    0x000000dca9865410, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x000000ca98654210,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x00000dca98654210, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000edc840, 0x000000000edc8410,
+    0x000000000edc8540, 0x00000000edc85410, 0x000000000edc9840,
+    0x00000000edc98410, 0x00000000edc98540, 0x0000000edc985410,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x00000000edc84210, 0x0000000000000000, 0x0000000edc854210,
+    0x0000000000000000, 0x0000000edc984210, 0x0000000000000000,
+    0x000000edc9854210, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x00000000edc86540,
+    0x0000000edc865410, 0x0000000000000000, 0x0000000000000000,
+    0x0000000edc986540, 0x000000edc9865410, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x000000edc8654210, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x00000edc98654210,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x00000000edca9840, 0x0000000edca98410, 0x0000000edca98540,
+    0x000000edca985410, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x000000edca984210,
+    0x0000000000000000, 0x00000edca9854210, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x000000edca986540, 0x00000edca9865410,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000000000000000, 0x0000000000000000, 0x0000000000000000,
+    0x0000edca98654210,
+};
+#endif
+
+#ifdef PSTRING_AVX512
+PSTRING_TARGET("avx512bw")
+static uint64_t pstr__match_set_avx512(
+    const char *buffer, const char *set, size_t length
+) {
+    __m512i vec = _mm512_loadu_si512((const void *)buffer);
+    uint64_t result = 0;
+
+    for (size_t ch = 0; ch < length; ch++)
+        result |= _mm512_cmpeq_epi8_mask(vec, _mm512_set1_epi8(set[ch]));
+
+    return result;
+}
+
+PSTRING_TARGET("avx512bw")
+static uint64_t pstr__match_chr_avx512(const char *buffer, int ch) {
+    __m512i vec = _mm512_set1_epi8((char)ch);
+    __m512i chars = _mm512_loadu_si512((const void *)buffer);
+    return _mm512_cmpeq_epi8_mask(vec, chars);
+}
+
+PSTRING_TARGET("avx512bw")
+static uint64_t pstr__compare_avx512(const char *left, const char *right) {
+    __m512i leftVec = _mm512_loadu_si512((const void *)left);
+    __m512i rightVec = _mm512_loadu_si512((const void *)right);
+    return _mm512_cmpeq_epi8_mask(leftVec, rightVec);
+}
+
+PSTRING_TARGET("avx512bw")
+static uint64_t pstr__match_pair_avx512(
+    const char *buffer, int first, int last, size_t distance
+) {
+    __m512i head = _mm512_loadu_si512((const void *)buffer);
+    __m512i tail = _mm512_loadu_si512((const void *)&buffer[distance]);
+    __mmask64 result
+        = _mm512_cmpeq_epi8_mask(head, _mm512_set1_epi8((char)first));
+    return _mm512_mask_cmpeq_epi8_mask(
+        result, tail, _mm512_set1_epi8((char)last)
+    );
+}
+
+PSTRING_TARGET("avx512bw")
+static uint64_t pstr__match_class_avx512(
+    const char *buffer, const pstrset_t *set
+) {
+    const __m512i bits = _mm512_broadcast_i32x4(_mm_setr_epi8(
+        1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128
+    ));
+    const __m512i nibble = _mm512_set1_epi8((char)0x8f);
+    __m512i low = _mm512_broadcast_i32x4(
+        _mm_loadu_si128((const __m128i *)set->low)
+    );
+    __m512i high = _mm512_broadcast_i32x4(
+        _mm_loadu_si128((const __m128i *)set->high)
+    );
+    __m512i vec = _mm512_loadu_si512((const void *)buffer);
+    __m512i flip = _mm512_xor_si512(vec, _mm512_set1_epi8((char)0x80));
+
+    __m512i rows = _mm512_or_si512(
+        _mm512_shuffle_epi8(low, _mm512_and_si512(vec, nibble)),
+        _mm512_shuffle_epi8(high, _mm512_and_si512(flip, nibble))
+    );
+    __m512i shift = _mm512_and_si512(
+        _mm512_srli_epi16(vec, 4), _mm512_set1_epi8(0x0f)
+    );
+    return _mm512_test_epi8_mask(rows, _mm512_shuffle_epi8(bits, shift));
+}
+
+/* flips the case bit of ASCII letters in the case starting with `from` */
+PSTRING_TARGET("avx512bw")
+static inline __m512i pstr__case_avx512(__m512i vec, char from) {
+    __m512i offset = _mm512_sub_epi8(vec, _mm512_set1_epi8(from));
+    __mmask64 letters = _mm512_cmplt_epu8_mask(offset, _mm512_set1_epi8(26));
+    __m512i flipped = _mm512_xor_si512(vec, _mm512_set1_epi8(0x20));
+    return _mm512_mask_mov_epi8(vec, letters, flipped);
+}
+
+PSTRING_TARGET("avx512bw")
+static uint64_t pstr__change_case_avx512(
+    char *dst, const char *src, int upper
+) {
+    __m512i vec = _mm512_loadu_si512((const void *)src);
+    _mm512_storeu_si512((void *)dst, pstr__case_avx512(vec, upper ? 'a' : 'A'));
+    return _mm512_movepi8_mask(vec);
+}
+
+PSTRING_TARGET("avx512bw")
+static uint64_t pstr__compare_case_avx512(const char *left, const char *right) {
+    __m512i leftVec = _mm512_loadu_si512((const void *)left);
+    __m512i rightVec = _mm512_loadu_si512((const void *)right);
+    return _mm512_mask_cmpeq_epi8_mask(
+        ~_mm512_movepi8_mask(leftVec),
+        pstr__case_avx512(leftVec, 'A'),
+        pstr__case_avx512(rightVec, 'A')
+    );
+}
+
+PSTRING_TARGET("avx512bw")
+static uint64_t pstr__match_case_avx512(const char *buffer, int ch) {
+    __m512i vec = _mm512_loadu_si512((const void *)buffer);
+    __m512i lower = pstr__case_avx512(vec, 'A');
+    return _mm512_cmpeq_epi8_mask(lower, _mm512_set1_epi8((char)ch))
+         | _mm512_movepi8_mask(vec);
+}
+
+PSTRING_TARGET("avx512bw")
+static inline __m512i pstr__utf8_errors_avx512(__m512i input, __m512i prev) {
+    const __m512i nibble = _mm512_set1_epi8(0x0f);
+    __m512i high = _mm512_broadcast_i32x4(
+        _mm_loadu_si128((const __m128i *)utf8_high)
+    );
+    __m512i low = _mm512_broadcast_i32x4(
+        _mm_loadu_si128((const __m128i *)utf8_low)
+    );
+    __m512i next = _mm512_broadcast_i32x4(
+        _mm_loadu_si128((const __m128i *)utf8_next)
+    );
+
+    /* the previous 16 bytes of every lane, for `alignr` to shift in */
+    __m512i shifted = _mm512_permutex2var_epi64(
+        prev, _mm512_setr_epi64(6, 7, 8, 9, 10, 11, 12, 13), input
+    );
+    __m512i prev1 = _mm512_alignr_epi8(input, shifted, 15);
+    __m512i prev2 = _mm512_alignr_epi8(input, shifted, 14);
+    __m512i prev3 = _mm512_alignr_epi8(input, shifted, 13);
+
+    __m512i errors = _mm512_and_si512(
+        _mm512_and_si512(
+            _mm512_shuffle_epi8(
+                high, _mm512_and_si512(_mm512_srli_epi16(prev1, 4), nibble)
+            ),
+            _mm512_shuffle_epi8(low, _mm512_and_si512(prev1, nibble))
+        ),
+        _mm512_shuffle_epi8(
+            next, _mm512_and_si512(_mm512_srli_epi16(input, 4), nibble)
+        )
+    );
+    __m512i third = _mm512_subs_epu8(prev2, _mm512_set1_epi8(0xe0 - 0x80));
+    __m512i fourth = _mm512_subs_epu8(prev3, _mm512_set1_epi8(0xf0 - 0x80));
+    __m512i conts = _mm512_and_si512(
+        _mm512_or_si512(third, fourth), _mm512_set1_epi8((char)0x80)
+    );
+    return _mm512_xor_si512(conts, errors);
+}
+
+PSTRING_TARGET("avx512bw")
+static int pstr__valid_utf8_avx512(const char *buffer, size_t length) {
+    const __m512i limit = _mm512_inserti32x4(
+        _mm512_set1_epi8(-1),
+        _mm_loadu_si128((const __m128i *)utf8_incomplete),
+        3
+    );
+    __m512i prev = _mm512_setzero_si512();
+    __m512i error = _mm512_setzero_si512();
+    __m512i incomplete = _mm512_setzero_si512();
+    char tail[64] = { 0 };
+
+    for (size_t i = 0; i < length; i += 64) {
+        const char *block = &buffer[i];
+        if (length - i < 64)
+            block = memcpy(tail, block, length - i);
+
+        __m512i vec = _mm512_loadu_si512((const void *)block);
+        if (_mm512_movepi8_mask(vec)) {
+            error = _mm512_or_si512(error, pstr__utf8_errors_avx512(vec, prev));
+            incomplete = _mm512_subs_epu8(vec, limit);
+        } else {
+            error = _mm512_or_si512(error, incomplete);
+            incomplete = _mm512_setzero_si512();
+        }
+        prev = vec;
+    }
+
+    error = _mm512_or_si512(error, incomplete);
+    return !_mm512_test_epi8_mask(error, error);
+}
+
+PSTRING_TARGET("avx512bw")
+static size_t pstr__count_utf8_avx512(
+    const char *buffer, size_t length, int surrogates
+) {
+    const __m512i lead = _mm512_set1_epi8(-65);
+    const __m512i four = _mm512_set1_epi8((char)0xF0);
+    const __m512i one = _mm512_set1_epi8(1);
+    const __m512i pair = _mm512_set1_epi8(surrogates ? 1 : 0);
+    __m512i sums = _mm512_setzero_si512();
+    size_t count = 0, i = 0;
+
+    for (; length - i >= 64; i += 64) {
+        __m512i vec = _mm512_loadu_si512((const void *)&buffer[i]);
+        __mmask64 chars = _mm512_cmpgt_epi8_mask(vec, lead);
+        __mmask64 pairs = _mm512_cmpge_epu8_mask(vec, four);
+        __m512i ones = _mm512_add_epi8(
+            _mm512_maskz_mov_epi8(chars, one),
+            _mm512_maskz_mov_epi8(pairs, pair)
+        );
+        ones = _mm512_sad_epu8(ones, _mm512_setzero_si512());
+        sums = _mm512_add_epi64(sums, ones);
+    }
+
+    count = (size_t)_mm512_reduce_add_epi64(sums);
+    for (; i < length; i++)
+        count += pstr__utf8_units(buffer[i], surrogates);
+
+    return count;
+}
+
+PSTRING_TARGET("avx512bw")
+static size_t pstr__decode_utf8_avx512(
+    void *dst,
+    size_t *units,
+    const char *src,
+    size_t length,
+    size_t width,
+    int swap
+) {
+    const __m512i bits = _mm512_set1_epi32(0x3F);
+    size_t count = 0, i = 0;
+
+    while (length - i >= 19) {
+        if (length - i >= 64) {
+            __m512i vec = _mm512_loadu_si512((const void *)&src[i]);
+            if (!_mm512_movepi8_mask(vec)) {
+                for (size_t j = 0; j < 4; j++, i += 16, count += 16) {
+                    __m128i part = _mm_loadu_si128((const __m128i *)&src[i]);
+                    if (width == 2) {
+                        __m256i wide = _mm256_cvtepu8_epi16(part);
+                        if (swap)
+                            wide = _mm256_slli_epi16(wide, 8);
+                        _mm256_storeu_si256(
+                            (__m256i *)((uint16_t *)dst + count), wide
+                        );
+                    } else {
+                        _mm512_storeu_si512(
+                            (void *)((uint32_t *)dst + count),
+                            _mm512_cvtepu8_epi32(part)
+                        );
+                    }
+                }
+                continue;
+            }
+        }
+
+        /* every byte is decoded as if it started a character, using the
+           three bytes after it, and only lanes of lead bytes are kept */
+        __m512i b0, b1, b2, b3;
+        b0 = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)&src[i]));
+        b1 = _mm512_cvtepu8_epi32(
+            _mm_loadu_si128((const __m128i *)&src[i + 1])
+        );
+        b2 = _mm512_cvtepu8_epi32(
+            _mm_loadu_si128((const __m128i *)&src[i + 2])
+        );
+        b3 = _mm512_cvtepu8_epi32(
+            _mm_loadu_si128((const __m128i *)&src[i + 3])
+        );
+
+        __mmask16 two = _mm512_cmpge_epu32_mask(b0, _mm512_set1_epi32(0xC0));
+        __mmask16 three = _mm512_cmpge_epu32_mask(b0, _mm512_set1_epi32(0xE0));
+        __mmask16 four = _mm512_cmpge_epu32_mask(b0, _mm512_set1_epi32(0xF0));
+        __mmask16 ascii = _mm512_cmplt_epu32_mask(b0, _mm512_set1_epi32(0x80));
+        if (width == 2 && four)
+            break;
+
+        b1 = _mm512_and_si512(b1, bits);
+        b2 = _mm512_and_si512(b2, bits);
+        b3 = _mm512_and_si512(b3, bits);
+        __m512i tail2 = _mm512_or_si512(_mm512_slli_epi32(b1, 6), b2);
+        __m512i tail3 = _mm512_or_si512(_mm512_slli_epi32(tail2, 6), b3);
+
+        __m512i lead2 = _mm512_and_si512(b0, _mm512_set1_epi32(0x1F));
+        __m512i lead3 = _mm512_and_si512(b0, _mm512_set1_epi32(0x0F));
+        __m512i lead4 = _mm512_and_si512(b0, _mm512_set1_epi32(0x07));
+        lead2 = _mm512_slli_epi32(lead2, 6);
+        lead3 = _mm512_slli_epi32(lead3, 12);
+        lead4 = _mm512_slli_epi32(lead4, 18);
+
+        __m512i code = b0;
+        __mmask16 leads = ascii | two;
+        code = _mm512_mask_or_epi32(code, two, lead2, b1);
+        code = _mm512_mask_or_epi32(code, three, lead3, tail2);
+        code = _mm512_mask_or_epi32(code, four, lead4, tail3);
+
+        code = _mm512_maskz_compress_epi32(leads, code);
+        if (width == 2) {
+            __m256i narrow = _mm512_cvtepi32_epi16(code);
+            if (swap)
+                narrow = _mm256_or_si256(
+                    _mm256_slli_epi16(narrow, 8), _mm256_srli_epi16(narrow, 8)
+                );
+            _mm256_storeu_si256((__m256i *)((uint16_t *)dst + count), narrow);
+        } else {
+            _mm512_storeu_si512((void *)((uint32_t *)dst + count), code);
+        }
+
+        /* the last character may end after the block */
+        size_t end = 16;
+        while (end < 19 && (src[i + end] & 0xC0) == 0x80)
+            end++;
+
+        count += _mm512_mask_reduce_add_epi32(leads, _mm512_set1_epi32(1));
+        i += end;
+    }
+
+    *units = count;
+    return i;
+}
+
+PSTRING_TARGET("avx512bw")
+static size_t pstr__encode_utf8_avx512(
+    char *dst,
+    size_t *bytes,
+    const void *src,
+    size_t length,
+    size_t width,
+    int swap
+) {
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i slot = _mm512_setr_epi32(
+        0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3
+    );
+    const __m512i group = _mm512_setr_epi32(
+        0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3
+    );
+    const __m512i prefix = _mm512_setr_epi32(
+        0, 0, 0xC0, 0xE0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+    );
+    size_t size = 0, i = 0;
+
+    /* the bytes stored past the end of a block are overwritten by the
+       characters after it, of which there are at least 16 */
+    while (length - i >= 32) {
+        if (width == 2 && length - i >= 64) {
+            const uint16_t *in = (const uint16_t *)src + i;
+            __m512i low = _mm512_loadu_si512((const void *)in);
+            __m512i high = _mm512_loadu_si512((const void *)(in + 32));
+            __m512i mask = _mm512_set1_epi16((short)(swap ? 0x80FF : 0xFF80));
+            __m512i bits = _mm512_or_si512(low, high);
+            if (!_mm512_test_epi16_mask(bits, mask)) {
+                if (swap) {
+                    low = _mm512_srli_epi16(low, 8);
+                    high = _mm512_srli_epi16(high, 8);
+                }
+                if (dst) {
+                    _mm256_storeu_si256(
+                        (__m256i *)&dst[size], _mm512_cvtepi16_epi8(low)
+                    );
+                    _mm256_storeu_si256(
+                        (__m256i *)&dst[size + 32], _mm512_cvtepi16_epi8(high)
+                    );
+                }
+                i += 64;
+                size += 64;
+                continue;
+            }
+        }
+
+        __m512i code;
+        if (width == 2) {
+            const uint16_t *in = (const uint16_t *)src + i;
+            __m256i vec = _mm256_loadu_si256((const __m256i *)in);
+            if (swap)
+                vec = _mm256_or_si256(
+                    _mm256_slli_epi16(vec, 8), _mm256_srli_epi16(vec, 8)
+                );
+            code = _mm512_cvtepu16_epi32(vec);
+        } else {
+            const uint32_t *in = (const uint32_t *)src + i;
+            code = _mm512_loadu_si512((const void *)in);
+        }
+
+        /* surrogates and characters past the BMP are left to the caller */
+        __m512i surrogate = _mm512_sub_epi32(code, _mm512_set1_epi32(0xD800));
+        if (_mm512_cmpge_epu32_mask(code, _mm512_set1_epi32(0x10000))
+            | _mm512_cmplt_epu32_mask(surrogate, _mm512_set1_epi32(0x800)))
+            break;
+
+        __mmask16 two = _mm512_cmpge_epu32_mask(code, _mm512_set1_epi32(0x80));
+        __mmask16 three
+            = _mm512_cmpge_epu32_mask(code, _mm512_set1_epi32(0x800));
+        if (!two) {
+            if (dst)
+                _mm_storeu_si128(
+                    (__m128i *)&dst[size], _mm512_cvtepi32_epi8(code)
+                );
+            i += 16;
+            size += 16;
+            continue;
+        }
+
+        __m512i sizes = _mm512_mask_add_epi32(one, two, one, one);
+        sizes = _mm512_mask_add_epi32(sizes, three, sizes, one);
+
+        /* every character is spread over four lanes, one for each of its
+           possible bytes, and the lanes of bytes it has are compressed */
+        for (int g = 0; dst && g < 4; g++) {
+            __m512i index = _mm512_add_epi32(group, _mm512_set1_epi32(g * 4));
+            __m512i chr = _mm512_permutexvar_epi32(index, code);
+            __m512i chr_size = _mm512_permutexvar_epi32(index, sizes);
+            __mmask16 used = _mm512_cmplt_epu32_mask(slot, chr_size);
+
+            /* bytes are taken from the top, six bits at a time */
+            __m512i shift = _mm512_sub_epi32(chr_size, one);
+            shift = _mm512_sub_epi32(shift, slot);
+            shift = _mm512_mullo_epi32(shift, _mm512_set1_epi32(6));
+
+            __m512i byte = _mm512_srlv_epi32(chr, shift);
+            __m512i lead = _mm512_permutexvar_epi32(chr_size, prefix);
+            lead = _mm512_or_si512(byte, lead);
+            byte = _mm512_and_si512(byte, _mm512_set1_epi32(0x3F));
+            byte = _mm512_or_si512(byte, _mm512_set1_epi32(0x80));
+            byte = _mm512_mask_mov_epi32(byte, 0x1111, lead);
+            byte = _mm512_maskz_compress_epi32(used, byte);
+
+            _mm_storeu_si128(
+                (__m128i *)&dst[size], _mm512_cvtepi32_epi8(byte)
+            );
+            size += _mm512_mask_reduce_add_epi32(0x1111, chr_size);
+        }
+
+        if (!dst)
+            size += _mm512_reduce_add_epi32(sizes);
+        i += 16;
+    }
+
+    *bytes = size;
+    return i;
+}
+#endif
+
+#if defined(PSTRING_AVX) && defined(PSTRING_AVX_KERNELS)
+PSTRING_TARGET("avx2")
 static uint64_t pstr__match_set_avx(
     const char *buffer, const char *set, size_t length
 ) {
@@ -69,116 +935,1631 @@ static uint64_t pstr__match_set_avx(
         __m256i check = _mm256_set1_epi8(set[ch]);
         tmp = _mm256_or_si256(tmp, _mm256_cmpeq_epi8(vec, check));
     }
-    result = _mm256_movemask_epi8(tmp);
+    result = (uint32_t)_mm256_movemask_epi8(tmp);
     #else
     for (size_t ch = 0; ch < length; ch++) {
         __m256i check = _mm256_set1_epi8(set[ch]);
-        result |= _mm256_movemask_epi8(_mm256_cmpeq_epi8(vec, check));
+        check = _mm256_cmpeq_epi8(vec, check);
+        result |= (uint32_t)_mm256_movemask_epi8(check);
     }
     #endif
 
     return result;
 }
 
+PSTRING_TARGET("avx2")
 static uint64_t pstr__match_chr_avx(const char *buffer, int ch) {
     __m256i vec = _mm256_set1_epi8((char)ch);
     __m256i chars = _mm256_loadu_si256((const __m256i *)buffer);
-    return _mm256_movemask_epi8(_mm256_cmpeq_epi8(vec, chars));
+    return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(vec, chars));
+}
+
+PSTRING_TARGET("avx2")
+static uint64_t pstr__compare_avx(const char *left, const char *right) {
+    __m256i leftVec = _mm256_loadu_si256((const __m256i *)left);
+    __m256i rightVec = _mm256_loadu_si256((const __m256i *)right);
+    __m256i result = _mm256_cmpeq_epi8(leftVec, rightVec);
+    return (uint32_t)_mm256_movemask_epi8(result);
+}
+
+PSTRING_TARGET("avx2")
+static uint64_t pstr__match_pair_avx(
+    const char *buffer, int first, int last, size_t distance
+) {
+    __m256i head = _mm256_loadu_si256((const __m256i *)buffer);
+    __m256i tail = _mm256_loadu_si256((const __m256i *)&buffer[distance]);
+    head = _mm256_cmpeq_epi8(head, _mm256_set1_epi8((char)first));
+    tail = _mm256_cmpeq_epi8(tail, _mm256_set1_epi8((char)last));
+    return (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(head, tail));
+}
+
+PSTRING_TARGET("avx2")
+static uint64_t pstr__match_class_avx(
+    const char *buffer, const pstrset_t *set
+) {
+    const __m256i bits = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128
+    ));
+    const __m256i nibble = _mm256_set1_epi8((char)0x8f);
+    __m256i low = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i *)set->low)
+    );
+    __m256i high = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i *)set->high)
+    );
+    __m256i vec = _mm256_loadu_si256((const __m256i *)buffer);
+    __m256i flip = _mm256_xor_si256(vec, _mm256_set1_epi8((char)0x80));
+
+    __m256i rows = _mm256_or_si256(
+        _mm256_shuffle_epi8(low, _mm256_and_si256(vec, nibble)),
+        _mm256_shuffle_epi8(high, _mm256_and_si256(flip, nibble))
+    );
+    __m256i shift = _mm256_and_si256(
+        _mm256_srli_epi16(vec, 4), _mm256_set1_epi8(0x0f)
+    );
+    __m256i hit = _mm256_and_si256(rows, _mm256_shuffle_epi8(bits, shift));
+    hit = _mm256_cmpeq_epi8(hit, _mm256_setzero_si256());
+    return (uint32_t)~_mm256_movemask_epi8(hit);
+}
+
+PSTRING_TARGET("avx2")
+static inline __m256i pstr__case_avx(__m256i vec, char from) {
+    __m256i above = _mm256_cmpgt_epi8(vec, _mm256_set1_epi8(from - 1));
+    __m256i below = _mm256_cmpgt_epi8(_mm256_set1_epi8(from + 26), vec);
+    __m256i letters = _mm256_and_si256(above, below);
+    return _mm256_xor_si256(
+        vec, _mm256_and_si256(letters, _mm256_set1_epi8(0x20))
+    );
+}
+
+PSTRING_TARGET("avx2")
+static uint64_t pstr__change_case_avx(char *dst, const char *src, int upper) {
+    __m256i vec = _mm256_loadu_si256((const __m256i *)src);
+    _mm256_storeu_si256(
+        (__m256i *)dst, pstr__case_avx(vec, upper ? 'a' : 'A')
+    );
+    return (uint32_t)_mm256_movemask_epi8(vec);
+}
+
+PSTRING_TARGET("avx2")
+static uint64_t pstr__compare_case_avx(const char *left, const char *right) {
+    __m256i leftVec = _mm256_loadu_si256((const __m256i *)left);
+    __m256i rightVec = _mm256_loadu_si256((const __m256i *)right);
+    __m256i result = _mm256_cmpeq_epi8(
+        pstr__case_avx(leftVec, 'A'), pstr__case_avx(rightVec, 'A')
+    );
+    return (uint32_t)_mm256_movemask_epi8(_mm256_andnot_si256(leftVec, result));
+}
+
+PSTRING_TARGET("avx2")
+static uint64_t pstr__match_case_avx(const char *buffer, int ch) {
+    __m256i vec = _mm256_loadu_si256((const __m256i *)buffer);
+    __m256i result = _mm256_cmpeq_epi8(
+        pstr__case_avx(vec, 'A'), _mm256_set1_epi8((char)ch)
+    );
+    return (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(vec, result));
+}
+
+PSTRING_TARGET("avx2")
+static inline __m256i pstr__utf8_errors_avx(__m256i input, __m256i prev) {
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    __m256i high = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i *)utf8_high)
+    );
+    __m256i low = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i *)utf8_low)
+    );
+    __m256i next = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128((const __m128i *)utf8_next)
+    );
+
+    __m256i shifted = _mm256_permute2x128_si256(prev, input, 0x21);
+    __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+    __m256i prev2 = _mm256_alignr_epi8(input, shifted, 14);
+    __m256i prev3 = _mm256_alignr_epi8(input, shifted, 13);
+
+    __m256i errors = _mm256_and_si256(
+        _mm256_and_si256(
+            _mm256_shuffle_epi8(
+                high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)
+            ),
+            _mm256_shuffle_epi8(low, _mm256_and_si256(prev1, nibble))
+        ),
+        _mm256_shuffle_epi8(
+            next, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)
+        )
+    );
+    __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8(0xe0 - 0x80));
+    __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(0xf0 - 0x80));
+    __m256i conts = _mm256_and_si256(
+        _mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80)
+    );
+    return _mm256_xor_si256(conts, errors);
+}
+
+PSTRING_TARGET("avx2")
+static int pstr__valid_utf8_avx(const char *buffer, size_t length) {
+    const __m256i limit = _mm256_inserti128_si256(
+        _mm256_set1_epi8(-1),
+        _mm_loadu_si128((const __m128i *)utf8_incomplete),
+        1
+    );
+    __m256i prev = _mm256_setzero_si256();
+    __m256i error = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    char tail[32] = { 0 };
+
+    for (size_t i = 0; i < length; i += 32) {
+        const char *block = &buffer[i];
+        if (length - i < 32)
+            block = memcpy(tail, block, length - i);
+
+        __m256i vec = _mm256_loadu_si256((const __m256i *)block);
+        if (_mm256_movemask_epi8(vec)) {
+            error = _mm256_or_si256(error, pstr__utf8_errors_avx(vec, prev));
+            incomplete = _mm256_subs_epu8(vec, limit);
+        } else {
+            error = _mm256_or_si256(error, incomplete);
+            incomplete = _mm256_setzero_si256();
+        }
+        prev = vec;
+    }
+
+    error = _mm256_or_si256(error, incomplete);
+    return _mm256_testz_si256(error, error);
+}
+
+PSTRING_TARGET("avx2")
+static size_t pstr__count_utf8_avx(
+    const char *buffer, size_t length, int surrogates
+) {
+    const __m256i lead = _mm256_set1_epi8(-65);
+    const __m256i four = _mm256_set1_epi8((char)0xF0);
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i pair = _mm256_set1_epi8(surrogates ? 1 : 0);
+    size_t count = 0, i = 0;
+
+    for (; length - i >= 32; i += 32) {
+        __m256i vec = _mm256_loadu_si256((const __m256i *)&buffer[i]);
+        __m256i chars = _mm256_and_si256(_mm256_cmpgt_epi8(vec, lead), one);
+        __m256i pairs = _mm256_cmpeq_epi8(_mm256_max_epu8(vec, four), vec);
+        pairs = _mm256_and_si256(pairs, pair);
+        chars = _mm256_add_epi8(chars, pairs);
+        __m256i sums = _mm256_sad_epu8(chars, _mm256_setzero_si256());
+        __m128i sum = _mm_add_epi64(
+            _mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1)
+        );
+        count += _mm_cvtsi128_si32(sum) + _mm_extract_epi16(sum, 4);
+    }
+
+    for (; i < length; i++)
+        count += pstr__utf8_units(buffer[i], surrogates);
+
+    return count;
 }
 
-static uint64_t pstr__compare_avx(const char *left, const char *right) {
-    __m256i leftVec = _mm256_loadu_si256((const __m256i *)left);
-    __m256i rightVec = _mm256_loadu_si256((const __m256i *)right);
-    return _mm256_movemask_epi8(_mm256_cmpeq_epi8(leftVec, rightVec));
+/* Expands two rows of the shuffles packed into nibbles into a pshufb mask,
+   one for each 128-bit lane. */
+PSTRING_TARGET("avx2")
+static inline __m256i pstr__shuffle_avx(
+    const uint64_t *low, const uint64_t *high
+) {
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    __m256i vec = _mm256_setr_epi64x((long long)*low, 0, (long long)*high, 0);
+
+    return _mm256_unpacklo_epi8(
+        _mm256_and_si256(vec, nibble),
+        _mm256_and_si256(_mm256_srli_epi16(vec, 4), nibble)
+    );
+}
+
+/* Stores eight code units held in 16-bit lanes as UTF-16 or UTF-32. */
+PSTRING_TARGET("avx2")
+static inline void pstr__store_units_avx(
+    void *dst, __m128i code, size_t width, int swap
+) {
+    if (width == 2) {
+        if (swap)
+            code = _mm_or_si128(
+                _mm_slli_epi16(code, 8), _mm_srli_epi16(code, 8)
+            );
+        _mm_storeu_si128((__m128i *)dst, code);
+    } else {
+        _mm256_storeu_si256((__m256i *)dst, _mm256_cvtepu16_epi32(code));
+    }
+}
+
+PSTRING_TARGET("avx2")
+static size_t pstr__decode_utf8_avx(
+    void *dst,
+    size_t *units,
+    const char *src,
+    size_t length,
+    size_t width,
+    int swap
+) {
+    const __m256i bits = _mm256_set1_epi16(0x3F);
+    char *out = dst;
+    size_t count = 0, i = 0;
+
+    while (length - i >= 18) {
+        if (length - i >= 32) {
+            __m256i vec = _mm256_loadu_si256((const __m256i *)&src[i]);
+            if (!_mm256_movemask_epi8(vec)) {
+                __m128i low = _mm256_castsi256_si128(vec);
+                __m128i high = _mm256_extracti128_si256(vec, 1);
+                __m128i zero = _mm_setzero_si128();
+                __m128i parts[4] = {
+                    _mm_unpacklo_epi8(low, zero),
+                    _mm_unpackhi_epi8(low, zero),
+                    _mm_unpacklo_epi8(high, zero),
+                    _mm_unpackhi_epi8(high, zero),
+                };
+
+                for (size_t j = 0; j < 4; j++, count += 8)
+                    pstr__store_units_avx(
+                        &out[count * width], parts[j], width, swap
+                    );
+                i += 32;
+                continue;
+            }
+        }
+
+        /* four byte characters are left to the caller */
+        __m128i head = _mm_loadu_si128((const __m128i *)&src[i]);
+        __m128i top = _mm_and_si128(head, _mm_set1_epi8((char)0xF0));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(top, _mm_set1_epi8((char)0xF0))))
+            break;
+
+        __m128i conts = _mm_and_si128(head, _mm_set1_epi8((char)0xC0));
+        conts = _mm_cmpeq_epi8(conts, _mm_set1_epi8((char)0x80));
+        unsigned leads = ~_mm_movemask_epi8(conts) & 0xFFFF;
+
+        /* every byte is decoded as if it started a character, using the
+           two bytes after it, and only lanes of lead bytes are kept */
+        __m256i b0 = _mm256_cvtepu8_epi16(head);
+        __m256i b1 = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)&src[i + 1])
+        );
+        __m256i b2 = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)&src[i + 2])
+        );
+        b1 = _mm256_and_si256(b1, bits);
+        b2 = _mm256_and_si256(b2, bits);
+
+        /* the lead byte of three is shifted out of the lane past its bits */
+        __m256i two = _mm256_and_si256(b0, _mm256_set1_epi16(0x1F));
+        two = _mm256_or_si256(_mm256_slli_epi16(two, 6), b1);
+        __m256i three = _mm256_or_si256(
+            _mm256_slli_epi16(b0, 12), _mm256_slli_epi16(b1, 6)
+        );
+        three = _mm256_or_si256(three, b2);
+
+        __m256i code = _mm256_blendv_epi8(
+            b0, two, _mm256_cmpgt_epi16(b0, _mm256_set1_epi16(0x7F))
+        );
+        code = _mm256_blendv_epi8(
+            code, three, _mm256_cmpgt_epi16(b0, _mm256_set1_epi16(0xDF))
+        );
+        code = _mm256_shuffle_epi8(
+            code,
+            pstr__shuffle_avx(
+                &utf8_compress[leads & 0xFF], &utf8_compress[leads >> 8]
+            )
+        );
+
+        pstr__store_units_avx(
+            &out[count * width], _mm256_castsi256_si128(code), width, swap
+        );
+        count += pstr__bits8(leads & 0xFF);
+        pstr__store_units_avx(
+            &out[count * width], _mm256_extracti128_si256(code, 1), width, swap
+        );
+        count += pstr__bits8(leads >> 8);
+
+        /* the last character may end after the block */
+        size_t end = 16;
+        while (end < 18 && (src[i + end] & 0xC0) == 0x80)
+            end++;
+
+        i += end;
+    }
+
+    *units = count;
+    return i;
+}
+
+/* Loads sixteen UTF-16 or UTF-32 code units into 16-bit lanes, returning
+   zero if any of them doesn't fit. */
+PSTRING_TARGET("avx2")
+static inline int pstr__load_units_avx(
+    __m256i *out, const void *src, size_t width, int swap
+) {
+    const __m256i *in = src;
+
+    if (width == 2) {
+        __m256i vec = _mm256_loadu_si256(in);
+        if (swap)
+            vec = _mm256_or_si256(
+                _mm256_slli_epi16(vec, 8), _mm256_srli_epi16(vec, 8)
+            );
+        *out = vec;
+        return PSTRING_TRUE;
+    }
+
+    __m256i a = _mm256_loadu_si256(&in[0]), b = _mm256_loadu_si256(&in[1]);
+    __m256i wide = _mm256_set1_epi32((int)0xFFFF0000);
+    if (!_mm256_testz_si256(_mm256_or_si256(a, b), wide))
+        return PSTRING_FALSE;
+
+    /* packing works within 128 bit lanes, which are put back in order */
+    *out = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xD8);
+    return PSTRING_TRUE;
+}
+
+/* Encodes eight code points below U+10000 held in 32-bit lanes as UTF-8,
+   storing them in `dst` unless it's `NULL`, and returns their size. */
+PSTRING_TARGET("avx2")
+static inline size_t pstr__encode_lanes_avx(char *dst, __m256i code) {
+    const __m256i bits = _mm256_set1_epi32(0x3F);
+    __m256i last = _mm256_or_si256(
+        _mm256_and_si256(code, bits), _mm256_set1_epi32(0x80)
+    );
+
+    __m256i two = _mm256_or_si256(
+        _mm256_srli_epi32(code, 6), _mm256_set1_epi32(0xC0)
+    );
+    two = _mm256_or_si256(two, _mm256_slli_epi32(last, 8));
+
+    __m256i middle = _mm256_and_si256(_mm256_srli_epi32(code, 6), bits);
+    middle = _mm256_or_si256(middle, _mm256_set1_epi32(0x80));
+    __m256i three = _mm256_or_si256(
+        _mm256_srli_epi32(code, 12), _mm256_set1_epi32(0xE0)
+    );
+    three = _mm256_or_si256(three, _mm256_slli_epi32(middle, 8));
+    three = _mm256_or_si256(three, _mm256_slli_epi32(last, 16));
+
+    __m256i multi = _mm256_cmpgt_epi32(code, _mm256_set1_epi32(0x7F));
+    __m256i long3 = _mm256_cmpgt_epi32(code, _mm256_set1_epi32(0x7FF));
+    code = _mm256_blendv_epi8(code, two, multi);
+    code = _mm256_blendv_epi8(code, three, long3);
+
+    unsigned twos = _mm256_movemask_ps(_mm256_castsi256_ps(multi));
+    unsigned threes = _mm256_movemask_ps(_mm256_castsi256_ps(long3));
+    unsigned low = (twos & 0xF) | (threes & 0xF) << 4;
+    unsigned high = twos >> 4 | (threes & 0xF0);
+    size_t size = 4 + pstr__bits8(low);
+
+    if (dst) {
+        code = _mm256_shuffle_epi8(
+            code, pstr__shuffle_avx(&utf8_pack3[low], &utf8_pack3[high])
+        );
+        _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(code));
+        _mm_storeu_si128(
+            (__m128i *)&dst[size], _mm256_extracti128_si256(code, 1)
+        );
+    }
+
+    return size + 4 + pstr__bits8(high);
+}
+
+PSTRING_TARGET("avx2")
+static size_t pstr__encode_utf8_avx(
+    char *dst,
+    size_t *bytes,
+    const void *src,
+    size_t length,
+    size_t width,
+    int swap
+) {
+    const __m256i zero = _mm256_setzero_si256();
+    const char *in = src;
+    size_t size = 0, i = 0;
+
+    /* blocks of characters always store 16 bytes, and the ones past their
+       size are overwritten by the characters after them, of which there
+       are at least 16 */
+    while (length - i >= 32) {
+        __m256i code, next;
+        if (!pstr__load_units_avx(&code, &in[i * width], width, swap))
+            break;
+
+        if (pstr__load_units_avx(&next, &in[(i + 16) * width], width, swap)
+            && _mm256_testz_si256(
+                _mm256_or_si256(code, next), _mm256_set1_epi16((short)0xFF80)
+            )) {
+            /* packing works within 128 bit lanes, leaving each group of
+               eight characters in the lane of the vector it came from */
+            __m256i vec = _mm256_packus_epi16(code, next);
+            if (dst)
+                _mm256_storeu_si256(
+                    (__m256i *)&dst[size], _mm256_permute4x64_epi64(vec, 0xD8)
+                );
+            i += 32;
+            size += 32;
+            continue;
+        }
+
+        /* surrogates are left to the caller */
+        __m256i top = _mm256_and_si256(code, _mm256_set1_epi16((short)0xF800));
+        top = _mm256_cmpeq_epi16(top, _mm256_set1_epi16((short)0xD800));
+        if (_mm256_movemask_epi8(top))
+            break;
+
+        /* lanes at or above the limit saturate to non-zero */
+        __m256i ascii = _mm256_subs_epu16(code, _mm256_set1_epi16(0x7F));
+        __m256i small = _mm256_subs_epu16(code, _mm256_set1_epi16(0x7FF));
+        ascii = _mm256_cmpeq_epi16(ascii, zero);
+        small = _mm256_cmpeq_epi16(small, zero);
+
+        if (_mm256_movemask_epi8(small) == -1) {
+            __m256i last = _mm256_and_si256(code, _mm256_set1_epi16(0x3F));
+            last = _mm256_or_si256(last, _mm256_set1_epi16(0x80));
+            __m256i two = _mm256_or_si256(
+                _mm256_srli_epi16(code, 6), _mm256_set1_epi16(0xC0)
+            );
+            two = _mm256_or_si256(two, _mm256_slli_epi16(last, 8));
+            code = _mm256_blendv_epi8(two, code, ascii);
+
+            /* packing leaves the mask of each half in its 128 bit lane */
+            unsigned mask = _mm256_movemask_epi8(
+                _mm256_packs_epi16(ascii, zero)
+            );
+            unsigned low = ~mask & 0xFF, high = ~mask >> 16 & 0xFF;
+            size_t part = 8 + pstr__bits8(low);
+
+            if (dst) {
+                code = _mm256_shuffle_epi8(
+                    code, pstr__shuffle_avx(&utf8_pack2[low], &utf8_pack2[high])
+                );
+                _mm_storeu_si128(
+                    (__m128i *)&dst[size], _mm256_castsi256_si128(code)
+                );
+                _mm_storeu_si128(
+                    (__m128i *)&dst[size + part],
+                    _mm256_extracti128_si256(code, 1)
+                );
+            }
+            size += part + 8 + pstr__bits8(high);
+        } else {
+            __m256i low = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(code));
+            __m256i high
+                = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(code, 1));
+
+            size += pstr__encode_lanes_avx(dst ? &dst[size] : NULL, low);
+            size += pstr__encode_lanes_avx(dst ? &dst[size] : NULL, high);
+        }
+
+        i += 16;
+    }
+
+    *bytes = size;
+    return i;
+}
+#endif
+
+#if defined(PSTRING_SSE) && defined(PSTRING_SSE_KERNELS)
+PSTRING_TARGET("sse2")
+static uint64_t pstr__match_set_sse(
+    const char *buffer, const char *set, size_t length
+) {
+    __m128i vec = _mm_loadu_si128((const __m128i *)buffer);
+    uint64_t result = 0;
+
+    #ifndef PSTRING_ALT_SPN
+    __m128i tmp = _mm_setzero_si128();
+    for (size_t ch = 0; ch < length; ch++) {
+        __m128i check = _mm_set1_epi8(set[ch]);
+        tmp = _mm_or_si128(tmp, _mm_cmpeq_epi8(vec, check));
+    }
+    result = _mm_movemask_epi8(tmp);
+    #else
+    for (size_t ch = 0; ch < length; ch++) {
+        __m128i check = _mm_set1_epi8(set[ch]);
+        result |= _mm_movemask_epi8(_mm_cmpeq_epi8(vec, check));
+    }
+    #endif
+
+    return result;
+}
+
+PSTRING_TARGET("sse2")
+static uint64_t pstr__match_chr_sse(const char *buffer, int ch) {
+    __m128i vec = _mm_set1_epi8((char)ch);
+    __m128i chars = _mm_loadu_si128((const __m128i *)buffer);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(vec, chars));
+}
+
+PSTRING_TARGET("sse2")
+static uint64_t pstr__compare_sse(const char *left, const char *right) {
+    __m128i leftVec = _mm_loadu_si128((const __m128i *)left);
+    __m128i rightVec = _mm_loadu_si128((const __m128i *)right);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(leftVec, rightVec));
+}
+
+PSTRING_TARGET("sse2")
+static uint64_t pstr__match_pair_sse(
+    const char *buffer, int first, int last, size_t distance
+) {
+    __m128i head = _mm_loadu_si128((const __m128i *)buffer);
+    __m128i tail = _mm_loadu_si128((const __m128i *)&buffer[distance]);
+    head = _mm_cmpeq_epi8(head, _mm_set1_epi8((char)first));
+    tail = _mm_cmpeq_epi8(tail, _mm_set1_epi8((char)last));
+    return _mm_movemask_epi8(_mm_and_si128(head, tail));
+}
+
+PSTRING_TARGET("sse2")
+static inline __m128i pstr__case_sse(__m128i vec, char from) {
+    __m128i above = _mm_cmpgt_epi8(vec, _mm_set1_epi8(from - 1));
+    __m128i below = _mm_cmplt_epi8(vec, _mm_set1_epi8(from + 26));
+    __m128i letters = _mm_and_si128(above, below);
+    return _mm_xor_si128(vec, _mm_and_si128(letters, _mm_set1_epi8(0x20)));
+}
+
+PSTRING_TARGET("sse2")
+static uint64_t pstr__change_case_sse(char *dst, const char *src, int upper) {
+    __m128i vec = _mm_loadu_si128((const __m128i *)src);
+    _mm_storeu_si128((__m128i *)dst, pstr__case_sse(vec, upper ? 'a' : 'A'));
+    return _mm_movemask_epi8(vec);
+}
+
+PSTRING_TARGET("sse2")
+static uint64_t pstr__compare_case_sse(const char *left, const char *right) {
+    __m128i leftVec = _mm_loadu_si128((const __m128i *)left);
+    __m128i rightVec = _mm_loadu_si128((const __m128i *)right);
+    __m128i result = _mm_cmpeq_epi8(
+        pstr__case_sse(leftVec, 'A'), pstr__case_sse(rightVec, 'A')
+    );
+    return _mm_movemask_epi8(_mm_andnot_si128(leftVec, result));
+}
+
+PSTRING_TARGET("sse2")
+static uint64_t pstr__match_case_sse(const char *buffer, int ch) {
+    __m128i vec = _mm_loadu_si128((const __m128i *)buffer);
+    __m128i result
+        = _mm_cmpeq_epi8(pstr__case_sse(vec, 'A'), _mm_set1_epi8((char)ch));
+    return _mm_movemask_epi8(_mm_or_si128(vec, result));
+}
+
+PSTRING_TARGET("sse2")
+static size_t pstr__count_utf8_sse(
+    const char *buffer, size_t length, int surrogates
+) {
+    const __m128i lead = _mm_set1_epi8(-65);
+    const __m128i four = _mm_set1_epi8((char)0xF0);
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i pair = _mm_set1_epi8(surrogates ? 1 : 0);
+    size_t count = 0, i = 0;
+
+    for (; length - i >= 16; i += 16) {
+        __m128i vec = _mm_loadu_si128((const __m128i *)&buffer[i]);
+        __m128i chars = _mm_and_si128(_mm_cmpgt_epi8(vec, lead), one);
+        __m128i pairs = _mm_cmpeq_epi8(_mm_max_epu8(vec, four), vec);
+        pairs = _mm_and_si128(pairs, pair);
+        chars = _mm_add_epi8(chars, pairs);
+        __m128i sum = _mm_sad_epu8(chars, _mm_setzero_si128());
+        count += _mm_cvtsi128_si32(sum) + _mm_extract_epi16(sum, 4);
+    }
+
+    for (; i < length; i++)
+        count += pstr__utf8_units(buffer[i], surrogates);
+
+    return count;
+}
+
+/* Stores eight code units held in 16-bit lanes as UTF-16 or UTF-32. */
+PSTRING_TARGET("sse2")
+static inline void pstr__store_units_sse(
+    void *dst, __m128i code, size_t width, int swap
+) {
+    const __m128i zero = _mm_setzero_si128();
+
+    if (width == 2) {
+        if (swap)
+            code = _mm_or_si128(
+                _mm_slli_epi16(code, 8), _mm_srli_epi16(code, 8)
+            );
+        _mm_storeu_si128((__m128i *)dst, code);
+    } else {
+        __m128i *out = (__m128i *)dst;
+        _mm_storeu_si128(&out[0], _mm_unpacklo_epi16(code, zero));
+        _mm_storeu_si128(&out[1], _mm_unpackhi_epi16(code, zero));
+    }
+}
+
+    #ifdef PSTRING_SSE2_KERNELS
+PSTRING_TARGET("sse2")
+static size_t pstr__decode_utf8_sse(
+    void *dst,
+    size_t *units,
+    const char *src,
+    size_t length,
+    size_t width,
+    int swap
+) {
+    const __m128i zero = _mm_setzero_si128();
+    char *out = dst;
+    size_t i = 0;
+
+    for (; length - i >= 16; i += 16) {
+        __m128i vec = _mm_loadu_si128((const __m128i *)&src[i]);
+        if (_mm_movemask_epi8(vec))
+            break;
+
+        pstr__store_units_sse(
+            &out[i * width], _mm_unpacklo_epi8(vec, zero), width, swap
+        );
+        pstr__store_units_sse(
+            &out[(i + 8) * width], _mm_unpackhi_epi8(vec, zero), width, swap
+        );
+    }
+
+    *units = i;
+    return i;
+}
+
+PSTRING_TARGET("sse2")
+static size_t pstr__encode_utf8_sse(
+    char *dst,
+    size_t *bytes,
+    const void *src,
+    size_t length,
+    size_t width,
+    int swap
+) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; length - i >= 16; i += 16) {
+        __m128i vec;
+        if (width == 2) {
+            const __m128i *in = (const __m128i *)((const uint16_t *)src + i);
+            __m128i low = _mm_loadu_si128(&in[0]);
+            __m128i high = _mm_loadu_si128(&in[1]);
+            __m128i bits = _mm_and_si128(
+                _mm_or_si128(low, high),
+                _mm_set1_epi16((short)(swap ? 0x80FF : 0xFF80))
+            );
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(bits, zero)) != 0xFFFF)
+                break;
+
+            if (swap) {
+                low = _mm_srli_epi16(low, 8);
+                high = _mm_srli_epi16(high, 8);
+            }
+            vec = _mm_packus_epi16(low, high);
+        } else {
+            const __m128i *in = (const __m128i *)((const uint32_t *)src + i);
+            __m128i a = _mm_loadu_si128(&in[0]), b = _mm_loadu_si128(&in[1]);
+            __m128i c = _mm_loadu_si128(&in[2]), d = _mm_loadu_si128(&in[3]);
+            __m128i bits = _mm_and_si128(
+                _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)),
+                _mm_set1_epi32(~0x7F)
+            );
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(bits, zero)) != 0xFFFF)
+                break;
+
+            vec = _mm_packus_epi16(
+                _mm_packs_epi32(a, b), _mm_packs_epi32(c, d)
+            );
+        }
+
+        if (dst)
+            _mm_storeu_si128((__m128i *)&dst[i], vec);
+    }
+
+    *bytes = i;
+    return i;
+}
+    #endif
+#endif
+
+#if defined(PSTRING_SSSE3) && defined(PSTRING_SSE_KERNELS)
+/* Muła's universal pshufb lookup: the low nibble selects a row of high
+   nibbles from one of the two tables, and the high nibble selects a bit
+   within that row. Indices with the top bit set make pshufb return zero,
+   which is how each table ignores the half it doesn't cover. */
+PSTRING_TARGET("ssse3")
+static uint64_t pstr__match_class_ssse3(
+    const char *buffer, const pstrset_t *set
+) {
+    const __m128i bits = _mm_setr_epi8(
+        1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128
+    );
+    const __m128i nibble = _mm_set1_epi8((char)0x8f);
+    __m128i low = _mm_loadu_si128((const __m128i *)set->low);
+    __m128i high = _mm_loadu_si128((const __m128i *)set->high);
+    __m128i vec = _mm_loadu_si128((const __m128i *)buffer);
+    __m128i flip = _mm_xor_si128(vec, _mm_set1_epi8((char)0x80));
+
+    __m128i rows = _mm_or_si128(
+        _mm_shuffle_epi8(low, _mm_and_si128(vec, nibble)),
+        _mm_shuffle_epi8(high, _mm_and_si128(flip, nibble))
+    );
+    __m128i shift = _mm_and_si128(_mm_srli_epi16(vec, 4), _mm_set1_epi8(0x0f));
+    __m128i hit = _mm_and_si128(rows, _mm_shuffle_epi8(bits, shift));
+    hit = _mm_cmpeq_epi8(hit, _mm_setzero_si128());
+    return ~_mm_movemask_epi8(hit) & 0xffff;
+}
+
+PSTRING_TARGET("ssse3")
+static inline __m128i pstr__utf8_errors_ssse3(__m128i input, __m128i prev) {
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    __m128i high = _mm_loadu_si128((const __m128i *)utf8_high);
+    __m128i low = _mm_loadu_si128((const __m128i *)utf8_low);
+    __m128i next = _mm_loadu_si128((const __m128i *)utf8_next);
+
+    __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+    __m128i prev2 = _mm_alignr_epi8(input, prev, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, prev, 13);
+
+    __m128i errors = _mm_and_si128(
+        _mm_and_si128(
+            _mm_shuffle_epi8(
+                high, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)
+            ),
+            _mm_shuffle_epi8(low, _mm_and_si128(prev1, nibble))
+        ),
+        _mm_shuffle_epi8(
+            next, _mm_and_si128(_mm_srli_epi16(input, 4), nibble)
+        )
+    );
+    __m128i third = _mm_subs_epu8(prev2, _mm_set1_epi8(0xe0 - 0x80));
+    __m128i fourth = _mm_subs_epu8(prev3, _mm_set1_epi8(0xf0 - 0x80));
+    __m128i conts = _mm_and_si128(
+        _mm_or_si128(third, fourth), _mm_set1_epi8((char)0x80)
+    );
+    return _mm_xor_si128(conts, errors);
+}
+
+PSTRING_TARGET("ssse3")
+static int pstr__valid_utf8_ssse3(const char *buffer, size_t length) {
+    const __m128i limit = _mm_loadu_si128((const __m128i *)utf8_incomplete);
+    __m128i prev = _mm_setzero_si128();
+    __m128i error = _mm_setzero_si128();
+    __m128i incomplete = _mm_setzero_si128();
+    char tail[16] = { 0 };
+
+    for (size_t i = 0; i < length; i += 16) {
+        const char *block = &buffer[i];
+        if (length - i < 16)
+            block = memcpy(tail, block, length - i);
+
+        __m128i vec = _mm_loadu_si128((const __m128i *)block);
+        if (_mm_movemask_epi8(vec)) {
+            error = _mm_or_si128(error, pstr__utf8_errors_ssse3(vec, prev));
+            incomplete = _mm_subs_epu8(vec, limit);
+        } else {
+            error = _mm_or_si128(error, incomplete);
+            incomplete = _mm_setzero_si128();
+        }
+        prev = vec;
+    }
+
+    error = _mm_or_si128(error, incomplete);
+    error = _mm_cmpeq_epi8(error, _mm_setzero_si128());
+    return _mm_movemask_epi8(error) == 0xffff;
+}
+
+/* Expands a row of the shuffles packed into nibbles into a pshufb mask. */
+PSTRING_TARGET("ssse3")
+static inline __m128i pstr__shuffle_ssse3(const uint64_t *row) {
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    __m128i vec = _mm_loadl_epi64((const __m128i *)row);
+
+    return _mm_unpacklo_epi8(
+        _mm_and_si128(vec, nibble),
+        _mm_and_si128(_mm_srli_epi16(vec, 4), nibble)
+    );
+}
+
+PSTRING_TARGET("ssse3")
+static inline __m128i pstr__blend_ssse3(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/* Decodes the characters of up to three bytes starting in the 16-bit lanes
+   of `b0`, whose next bytes are in the same lanes of `b1` and `b2`, and
+   packs those of the lanes set in `leads` at the start. */
+PSTRING_TARGET("ssse3")
+static inline __m128i pstr__decode_lanes_ssse3(
+    __m128i b0, __m128i b1, __m128i b2, unsigned leads
+) {
+    const __m128i bits = _mm_set1_epi16(0x3F);
+    b1 = _mm_and_si128(b1, bits);
+    b2 = _mm_and_si128(b2, bits);
+
+    /* the lead byte of three is shifted out of the lane past its bits */
+    __m128i two = _mm_and_si128(b0, _mm_set1_epi16(0x1F));
+    two = _mm_or_si128(_mm_slli_epi16(two, 6), b1);
+    __m128i three = _mm_or_si128(_mm_slli_epi16(b0, 12), _mm_slli_epi16(b1, 6));
+    three = _mm_or_si128(three, b2);
+
+    __m128i code = pstr__blend_ssse3(
+        _mm_cmpgt_epi16(b0, _mm_set1_epi16(0x7F)), two, b0
+    );
+    code = pstr__blend_ssse3(
+        _mm_cmpgt_epi16(b0, _mm_set1_epi16(0xDF)), three, code
+    );
+    return _mm_shuffle_epi8(code, pstr__shuffle_ssse3(&utf8_compress[leads]));
+}
+
+PSTRING_TARGET("ssse3")
+static size_t pstr__decode_utf8_ssse3(
+    void *dst,
+    size_t *units,
+    const char *src,
+    size_t length,
+    size_t width,
+    int swap
+) {
+    const __m128i zero = _mm_setzero_si128();
+    char *out = dst;
+    size_t count = 0, i = 0;
+
+    while (length - i >= 18) {
+        __m128i vec = _mm_loadu_si128((const __m128i *)&src[i]);
+        if (!_mm_movemask_epi8(vec)) {
+            pstr__store_units_sse(
+                &out[count * width], _mm_unpacklo_epi8(vec, zero), width, swap
+            );
+            pstr__store_units_sse(
+                &out[(count + 8) * width],
+                _mm_unpackhi_epi8(vec, zero),
+                width,
+                swap
+            );
+            i += 16;
+            count += 16;
+            continue;
+        }
+
+        /* four byte characters are left to the caller */
+        __m128i top = _mm_and_si128(vec, _mm_set1_epi8((char)0xF0));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(top, _mm_set1_epi8((char)0xF0))))
+            break;
+
+        __m128i conts = _mm_and_si128(vec, _mm_set1_epi8((char)0xC0));
+        conts = _mm_cmpeq_epi8(conts, _mm_set1_epi8((char)0x80));
+        unsigned leads = ~_mm_movemask_epi8(conts) & 0xFFFF;
+
+        /* every byte is decoded as if it started a character, using the
+           two bytes after it, and only lanes of lead bytes are kept */
+        __m128i next1 = _mm_loadu_si128((const __m128i *)&src[i + 1]);
+        __m128i next2 = _mm_loadu_si128((const __m128i *)&src[i + 2]);
+        __m128i low = pstr__decode_lanes_ssse3(
+            _mm_unpacklo_epi8(vec, zero),
+            _mm_unpacklo_epi8(next1, zero),
+            _mm_unpacklo_epi8(next2, zero),
+            leads & 0xFF
+        );
+        __m128i high = pstr__decode_lanes_ssse3(
+            _mm_unpackhi_epi8(vec, zero),
+            _mm_unpackhi_epi8(next1, zero),
+            _mm_unpackhi_epi8(next2, zero),
+            leads >> 8
+        );
+
+        pstr__store_units_sse(&out[count * width], low, width, swap);
+        count += pstr__bits8(leads & 0xFF);
+        pstr__store_units_sse(&out[count * width], high, width, swap);
+        count += pstr__bits8(leads >> 8);
+
+        /* the last character may end after the block */
+        size_t end = 16;
+        while (end < 18 && (src[i + end] & 0xC0) == 0x80)
+            end++;
+
+        i += end;
+    }
+
+    *units = count;
+    return i;
+}
+
+/* Loads eight UTF-16 or UTF-32 code units into 16-bit lanes, returning
+   zero if any of them doesn't fit. */
+PSTRING_TARGET("ssse3")
+static inline int pstr__load_units_ssse3(
+    __m128i *out, const void *src, size_t width, int swap
+) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i *in = src;
+
+    if (width == 2) {
+        __m128i vec = _mm_loadu_si128(in);
+        if (swap)
+            vec = _mm_or_si128(_mm_slli_epi16(vec, 8), _mm_srli_epi16(vec, 8));
+        *out = vec;
+        return PSTRING_TRUE;
+    }
+
+    __m128i a = _mm_loadu_si128(&in[0]), b = _mm_loadu_si128(&in[1]);
+    __m128i wide = _mm_and_si128(
+        _mm_or_si128(a, b), _mm_set1_epi32((int)0xFFFF0000)
+    );
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(wide, zero)) != 0xFFFF)
+        return PSTRING_FALSE;
+
+    /* signed saturation is avoided by packing units biased into its range */
+    const __m128i bias = _mm_set1_epi32(0x8000);
+    __m128i packed = _mm_packs_epi32(
+        _mm_sub_epi32(a, bias), _mm_sub_epi32(b, bias)
+    );
+    *out = _mm_add_epi16(packed, _mm_set1_epi16((short)0x8000));
+    return PSTRING_TRUE;
+}
+
+/* Encodes four code points below U+10000 held in 32-bit lanes as UTF-8,
+   packed at the start, storing their size in `size`. */
+PSTRING_TARGET("ssse3")
+static inline __m128i pstr__encode_lanes_ssse3(__m128i code, size_t *size) {
+    const __m128i bits = _mm_set1_epi32(0x3F);
+    __m128i last = _mm_or_si128(
+        _mm_and_si128(code, bits), _mm_set1_epi32(0x80)
+    );
+
+    __m128i two = _mm_or_si128(
+        _mm_srli_epi32(code, 6), _mm_set1_epi32(0xC0)
+    );
+    two = _mm_or_si128(two, _mm_slli_epi32(last, 8));
+
+    __m128i middle = _mm_and_si128(_mm_srli_epi32(code, 6), bits);
+    middle = _mm_or_si128(middle, _mm_set1_epi32(0x80));
+    __m128i three = _mm_or_si128(
+        _mm_srli_epi32(code, 12), _mm_set1_epi32(0xE0)
+    );
+    three = _mm_or_si128(three, _mm_slli_epi32(middle, 8));
+    three = _mm_or_si128(three, _mm_slli_epi32(last, 16));
+
+    __m128i multi = _mm_cmpgt_epi32(code, _mm_set1_epi32(0x7F));
+    __m128i long3 = _mm_cmpgt_epi32(code, _mm_set1_epi32(0x7FF));
+    code = pstr__blend_ssse3(multi, two, code);
+    code = pstr__blend_ssse3(long3, three, code);
+
+    unsigned twos = _mm_movemask_ps(_mm_castsi128_ps(multi));
+    unsigned threes = _mm_movemask_ps(_mm_castsi128_ps(long3));
+    *size = 4 + pstr__bits8(twos) + pstr__bits8(threes);
+    return _mm_shuffle_epi8(
+        code, pstr__shuffle_ssse3(&utf8_pack3[twos | threes << 4])
+    );
+}
+
+PSTRING_TARGET("ssse3")
+static size_t pstr__encode_utf8_ssse3(
+    char *dst,
+    size_t *bytes,
+    const void *src,
+    size_t length,
+    size_t width,
+    int swap
+) {
+    const __m128i zero = _mm_setzero_si128();
+    const char *in = src;
+    size_t size = 0, i = 0;
+
+    /* blocks of characters always store 16 bytes, and the ones past their
+       size are overwritten by the characters after them, of which there
+       are at least 16 */
+    while (length - i >= 16) {
+        __m128i code, next;
+        if (!pstr__load_units_ssse3(&code, &in[i * width], width, swap))
+            break;
+
+        if (pstr__load_units_ssse3(&next, &in[(i + 8) * width], width, swap)) {
+            __m128i bits = _mm_and_si128(
+                _mm_or_si128(code, next), _mm_set1_epi16((short)0xFF80)
+            );
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(bits, zero)) == 0xFFFF) {
+                if (dst)
+                    _mm_storeu_si128(
+                        (__m128i *)&dst[size], _mm_packus_epi16(code, next)
+                    );
+                i += 16;
+                size += 16;
+                continue;
+            }
+        }
+
+        if (length - i < 24)
+            break;
+
+        /* surrogates are left to the caller */
+        __m128i top = _mm_and_si128(code, _mm_set1_epi16((short)0xF800));
+        top = _mm_cmpeq_epi16(top, _mm_set1_epi16((short)0xD800));
+        if (_mm_movemask_epi8(top))
+            break;
+
+        /* lanes at or above the limit saturate to non-zero */
+        __m128i ascii = _mm_subs_epu16(code, _mm_set1_epi16(0x7F));
+        __m128i small = _mm_subs_epu16(code, _mm_set1_epi16(0x7FF));
+        ascii = _mm_cmpeq_epi16(ascii, zero);
+        small = _mm_cmpeq_epi16(small, zero);
+
+        if (_mm_movemask_epi8(small) == 0xFFFF) {
+            __m128i last = _mm_and_si128(code, _mm_set1_epi16(0x3F));
+            last = _mm_or_si128(last, _mm_set1_epi16(0x80));
+            __m128i two = _mm_or_si128(
+                _mm_srli_epi16(code, 6), _mm_set1_epi16(0xC0)
+            );
+            two = _mm_or_si128(two, _mm_slli_epi16(last, 8));
+            code = pstr__blend_ssse3(ascii, code, two);
+
+            unsigned twos = _mm_movemask_epi8(_mm_packs_epi16(ascii, zero));
+            twos = ~twos & 0xFF;
+            if (dst)
+                _mm_storeu_si128(
+                    (__m128i *)&dst[size],
+                    _mm_shuffle_epi8(
+                        code, pstr__shuffle_ssse3(&utf8_pack2[twos])
+                    )
+                );
+            size += 8 + pstr__bits8(twos);
+        } else {
+            __m128i halves[2] = {
+                _mm_unpacklo_epi16(code, zero),
+                _mm_unpackhi_epi16(code, zero),
+            };
+
+            for (size_t h = 0; h < 2; h++) {
+                size_t part;
+                __m128i vec = pstr__encode_lanes_ssse3(halves[h], &part);
+                if (dst)
+                    _mm_storeu_si128((__m128i *)&dst[size], vec);
+                size += part;
+            }
+        }
+
+        i += 8;
+    }
+
+    *bytes = size;
+    return i;
+}
+#endif
+
+#ifdef PSTRING_NEON
+static inline uint64_t pstr__movemask_neon(uint8x16_t vec) {
+    const uint8x16_t bits = {
+        1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128,
+    };
+    uint8x16_t masked = vandq_u8(vec, bits);
+    uint64_t low = vaddv_u8(vget_low_u8(masked));
+    uint64_t high = vaddv_u8(vget_high_u8(masked));
+    return low | (high << 8);
+}
+
+static uint64_t pstr__match_set_neon(
+    const char *buffer, const char *set, size_t length
+) {
+    uint8x16_t vec = vld1q_u8((const uint8_t *)buffer);
+    uint8x16_t tmp = vdupq_n_u8(0);
+
+    for (size_t ch = 0; ch < length; ch++)
+        tmp = vorrq_u8(tmp, vceqq_u8(vec, vdupq_n_u8((uint8_t)set[ch])));
+
+    return pstr__movemask_neon(tmp);
+}
+
+static uint64_t pstr__match_chr_neon(const char *buffer, int ch) {
+    uint8x16_t vec = vdupq_n_u8((uint8_t)ch);
+    uint8x16_t chars = vld1q_u8((const uint8_t *)buffer);
+    return pstr__movemask_neon(vceqq_u8(vec, chars));
+}
+
+static uint64_t pstr__compare_neon(const char *left, const char *right) {
+    uint8x16_t leftVec = vld1q_u8((const uint8_t *)left);
+    uint8x16_t rightVec = vld1q_u8((const uint8_t *)right);
+    return pstr__movemask_neon(vceqq_u8(leftVec, rightVec));
+}
+
+static uint64_t pstr__match_pair_neon(
+    const char *buffer, int first, int last, size_t distance
+) {
+    uint8x16_t head = vld1q_u8((const uint8_t *)buffer);
+    uint8x16_t tail = vld1q_u8((const uint8_t *)&buffer[distance]);
+    head = vceqq_u8(head, vdupq_n_u8((uint8_t)first));
+    tail = vceqq_u8(tail, vdupq_n_u8((uint8_t)last));
+    return pstr__movemask_neon(vandq_u8(head, tail));
+}
+
+/* same lookup as the pshufb kernels, `tbl` also returns zero for
+   indices outside of the table */
+static uint64_t pstr__match_class_neon(
+    const char *buffer, const pstrset_t *set
+) {
+    const uint8x16_t bits = {
+        1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128,
+    };
+    const uint8x16_t nibble = vdupq_n_u8(0x8f);
+    uint8x16_t low = vld1q_u8(set->low);
+    uint8x16_t high = vld1q_u8(set->high);
+    uint8x16_t vec = vld1q_u8((const uint8_t *)buffer);
+    uint8x16_t flip = veorq_u8(vec, vdupq_n_u8(0x80));
+
+    uint8x16_t rows = vorrq_u8(
+        vqtbl1q_u8(low, vandq_u8(vec, nibble)),
+        vqtbl1q_u8(high, vandq_u8(flip, nibble))
+    );
+    uint8x16_t bit = vqtbl1q_u8(bits, vshrq_n_u8(vec, 4));
+    return pstr__movemask_neon(vtstq_u8(rows, bit));
+}
+
+static inline uint8x16_t pstr__case_neon(uint8x16_t vec, uint8_t from) {
+    uint8x16_t offset = vsubq_u8(vec, vdupq_n_u8(from));
+    uint8x16_t letters = vcltq_u8(offset, vdupq_n_u8(26));
+    return veorq_u8(vec, vandq_u8(letters, vdupq_n_u8(0x20)));
+}
+
+static uint64_t pstr__change_case_neon(char *dst, const char *src, int upper) {
+    uint8x16_t vec = vld1q_u8((const uint8_t *)src);
+    vst1q_u8((uint8_t *)dst, pstr__case_neon(vec, upper ? 'a' : 'A'));
+    return pstr__movemask_neon(vtstq_u8(vec, vdupq_n_u8(0x80)));
+}
+
+static uint64_t pstr__compare_case_neon(const char *left, const char *right) {
+    uint8x16_t leftVec = vld1q_u8((const uint8_t *)left);
+    uint8x16_t rightVec = vld1q_u8((const uint8_t *)right);
+    uint8x16_t result = vceqq_u8(
+        pstr__case_neon(leftVec, 'A'), pstr__case_neon(rightVec, 'A')
+    );
+    uint8x16_t wide = vtstq_u8(leftVec, vdupq_n_u8(0x80));
+    return pstr__movemask_neon(vbicq_u8(result, wide));
+}
+
+static uint64_t pstr__match_case_neon(const char *buffer, int ch) {
+    uint8x16_t vec = vld1q_u8((const uint8_t *)buffer);
+    uint8x16_t result
+        = vceqq_u8(pstr__case_neon(vec, 'A'), vdupq_n_u8((uint8_t)ch));
+    uint8x16_t wide = vtstq_u8(vec, vdupq_n_u8(0x80));
+    return pstr__movemask_neon(vorrq_u8(result, wide));
+}
+
+static inline uint8x16_t pstr__utf8_errors_neon(
+    uint8x16_t input, uint8x16_t prev
+) {
+    const uint8x16_t nibble = vdupq_n_u8(0x0f);
+    uint8x16_t prev1 = vextq_u8(prev, input, 15);
+    uint8x16_t prev2 = vextq_u8(prev, input, 14);
+    uint8x16_t prev3 = vextq_u8(prev, input, 13);
+
+    uint8x16_t errors = vandq_u8(
+        vandq_u8(
+            vqtbl1q_u8(vld1q_u8(utf8_high), vshrq_n_u8(prev1, 4)),
+            vqtbl1q_u8(vld1q_u8(utf8_low), vandq_u8(prev1, nibble))
+        ),
+        vqtbl1q_u8(vld1q_u8(utf8_next), vshrq_n_u8(input, 4))
+    );
+    uint8x16_t third = vqsubq_u8(prev2, vdupq_n_u8(0xe0 - 0x80));
+    uint8x16_t fourth = vqsubq_u8(prev3, vdupq_n_u8(0xf0 - 0x80));
+    uint8x16_t conts = vandq_u8(vorrq_u8(third, fourth), vdupq_n_u8(0x80));
+    return veorq_u8(conts, errors);
+}
+
+static int pstr__valid_utf8_neon(const char *buffer, size_t length) {
+    const uint8x16_t limit = vld1q_u8(utf8_incomplete);
+    uint8x16_t prev = vdupq_n_u8(0);
+    uint8x16_t error = vdupq_n_u8(0);
+    uint8x16_t incomplete = vdupq_n_u8(0);
+    char tail[16] = { 0 };
+
+    for (size_t i = 0; i < length; i += 16) {
+        const char *block = &buffer[i];
+        if (length - i < 16)
+            block = memcpy(tail, block, length - i);
+
+        uint8x16_t vec = vld1q_u8((const uint8_t *)block);
+        if (vmaxvq_u8(vec) >= 0x80) {
+            error = vorrq_u8(error, pstr__utf8_errors_neon(vec, prev));
+            incomplete = vqsubq_u8(vec, limit);
+        } else {
+            error = vorrq_u8(error, incomplete);
+            incomplete = vdupq_n_u8(0);
+        }
+        prev = vec;
+    }
+
+    error = vorrq_u8(error, incomplete);
+    return vmaxvq_u8(error) == 0;
+}
+
+static size_t pstr__count_utf8_neon(
+    const char *buffer, size_t length, int surrogates
+) {
+    const int8x16_t lead = vdupq_n_s8(-65);
+    const uint8x16_t four = vdupq_n_u8(0xF0);
+    const uint8x16_t pair = vdupq_n_u8(surrogates ? 1 : 0);
+    size_t count = 0, i = 0;
+
+    for (; length - i >= 16; i += 16) {
+        int8x16_t vec = vld1q_s8((const int8_t *)&buffer[i]);
+        uint8x16_t chars = vandq_u8(vcgtq_s8(vec, lead), vdupq_n_u8(1));
+        uint8x16_t pairs = vcgeq_u8(vreinterpretq_u8_s8(vec), four);
+        pairs = vandq_u8(pairs, pair);
+        count += vaddlvq_u8(vaddq_u8(chars, pairs));
+    }
+
+    for (; i < length; i++)
+        count += pstr__utf8_units(buffer[i], surrogates);
+
+    return count;
+}
+
+/* Expands a row of the shuffles packed into nibbles into a table lookup. */
+static inline uint8x16_t pstr__shuffle_neon(const uint64_t *row) {
+    uint8x8_t vec = vcreate_u8(*row);
+    uint8x8_t low = vand_u8(vec, vdup_n_u8(0x0f));
+    uint8x8_t high = vshr_n_u8(vec, 4);
+
+    return vcombine_u8(vzip1_u8(low, high), vzip2_u8(low, high));
+}
+
+/* Stores eight code units held in 16-bit lanes as UTF-16 or UTF-32. */
+static inline void pstr__store_units_neon(
+    void *dst, uint16x8_t code, size_t width, int swap
+) {
+    if (width == 2) {
+        if (swap)
+            code = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(code)));
+        vst1q_u16((uint16_t *)dst, code);
+    } else {
+        uint32_t *out = dst;
+        vst1q_u32(out, vmovl_u16(vget_low_u16(code)));
+        vst1q_u32(out + 4, vmovl_high_u16(code));
+    }
+}
+
+/* Decodes the characters of up to three bytes starting in the 16-bit lanes
+   of `b0`, whose next bytes are in the same lanes of `b1` and `b2`, and
+   packs those of the lanes set in `leads` at the start. */
+static inline uint16x8_t pstr__decode_lanes_neon(
+    uint16x8_t b0, uint16x8_t b1, uint16x8_t b2, unsigned leads
+) {
+    const uint16x8_t bits = vdupq_n_u16(0x3F);
+    b1 = vandq_u16(b1, bits);
+    b2 = vandq_u16(b2, bits);
+
+    /* the lead byte of three is shifted out of the lane past its bits */
+    uint16x8_t two = vandq_u16(b0, vdupq_n_u16(0x1F));
+    two = vorrq_u16(vshlq_n_u16(two, 6), b1);
+    uint16x8_t three = vorrq_u16(vshlq_n_u16(b0, 12), vshlq_n_u16(b1, 6));
+    three = vorrq_u16(three, b2);
+
+    uint16x8_t code = vbslq_u16(vcgtq_u16(b0, vdupq_n_u16(0x7F)), two, b0);
+    code = vbslq_u16(vcgtq_u16(b0, vdupq_n_u16(0xDF)), three, code);
+    return vreinterpretq_u16_u8(
+        vqtbl1q_u8(
+            vreinterpretq_u8_u16(code),
+            pstr__shuffle_neon(&utf8_compress[leads])
+        )
+    );
+}
+
+static size_t pstr__decode_utf8_neon(
+    void *dst,
+    size_t *units,
+    const char *src,
+    size_t length,
+    size_t width,
+    int swap
+) {
+    const uint8_t *in = (const uint8_t *)src;
+    char *out = dst;
+    size_t count = 0, i = 0;
+
+    while (length - i >= 18) {
+        uint8x16_t vec = vld1q_u8(&in[i]);
+        uint8_t max = vmaxvq_u8(vec);
+        if (max < 0x80) {
+            pstr__store_units_neon(
+                &out[count * width], vmovl_u8(vget_low_u8(vec)), width, swap
+            );
+            pstr__store_units_neon(
+                &out[(count + 8) * width], vmovl_high_u8(vec), width, swap
+            );
+            i += 16;
+            count += 16;
+            continue;
+        }
+
+        /* four byte characters are left to the caller */
+        if (max >= 0xF0)
+            break;
+
+        uint8x16_t conts = vandq_u8(vec, vdupq_n_u8(0xC0));
+        conts = vceqq_u8(conts, vdupq_n_u8(0x80));
+        unsigned leads = ~(unsigned)pstr__movemask_neon(conts) & 0xFFFF;
+
+        /* every byte is decoded as if it started a character, using the
+           two bytes after it, and only lanes of lead bytes are kept */
+        uint8x16_t next1 = vld1q_u8(&in[i + 1]);
+        uint8x16_t next2 = vld1q_u8(&in[i + 2]);
+        uint16x8_t low = pstr__decode_lanes_neon(
+            vmovl_u8(vget_low_u8(vec)),
+            vmovl_u8(vget_low_u8(next1)),
+            vmovl_u8(vget_low_u8(next2)),
+            leads & 0xFF
+        );
+        uint16x8_t high = pstr__decode_lanes_neon(
+            vmovl_high_u8(vec),
+            vmovl_high_u8(next1),
+            vmovl_high_u8(next2),
+            leads >> 8
+        );
+
+        pstr__store_units_neon(&out[count * width], low, width, swap);
+        count += pstr__bits8(leads & 0xFF);
+        pstr__store_units_neon(&out[count * width], high, width, swap);
+        count += pstr__bits8(leads >> 8);
+
+        /* the last character may end after the block */
+        size_t end = 16;
+        while (end < 18 && (src[i + end] & 0xC0) == 0x80)
+            end++;
+
+        i += end;
+    }
+
+    *units = count;
+    return i;
+}
+
+/* Loads eight UTF-16 or UTF-32 code units into 16-bit lanes, returning
+   zero if any of them doesn't fit. */
+static inline int pstr__load_units_neon(
+    uint16x8_t *out, const void *src, size_t width, int swap
+) {
+    if (width == 2) {
+        uint16x8_t vec = vld1q_u16((const uint16_t *)src);
+        if (swap)
+            vec = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(vec)));
+        *out = vec;
+        return PSTRING_TRUE;
+    }
+
+    const uint32_t *in = src;
+    uint32x4_t a = vld1q_u32(in), b = vld1q_u32(in + 4);
+    if (vmaxvq_u32(vorrq_u32(a, b)) > 0xFFFF)
+        return PSTRING_FALSE;
+
+    *out = vcombine_u16(vmovn_u32(a), vmovn_u32(b));
+    return PSTRING_TRUE;
+}
+
+/* Encodes four code points below U+10000 held in 32-bit lanes as UTF-8,
+   storing them in `dst` unless it's `NULL`, and returns their size. */
+static inline size_t pstr__encode_lanes_neon(char *dst, uint32x4_t code) {
+    const uint32x4_t lanes = { 1, 2, 4, 8 };
+    const uint32x4_t bits = vdupq_n_u32(0x3F);
+    uint32x4_t last = vorrq_u32(vandq_u32(code, bits), vdupq_n_u32(0x80));
+
+    uint32x4_t two = vorrq_u32(vshrq_n_u32(code, 6), vdupq_n_u32(0xC0));
+    two = vorrq_u32(two, vshlq_n_u32(last, 8));
+
+    uint32x4_t middle = vandq_u32(vshrq_n_u32(code, 6), bits);
+    middle = vorrq_u32(middle, vdupq_n_u32(0x80));
+    uint32x4_t three = vorrq_u32(vshrq_n_u32(code, 12), vdupq_n_u32(0xE0));
+    three = vorrq_u32(three, vshlq_n_u32(middle, 8));
+    three = vorrq_u32(three, vshlq_n_u32(last, 16));
+
+    uint32x4_t multi = vcgtq_u32(code, vdupq_n_u32(0x7F));
+    uint32x4_t long3 = vcgtq_u32(code, vdupq_n_u32(0x7FF));
+    code = vbslq_u32(multi, two, code);
+    code = vbslq_u32(long3, three, code);
+
+    unsigned twos = vaddvq_u32(vandq_u32(multi, lanes));
+    unsigned threes = vaddvq_u32(vandq_u32(long3, lanes));
+    if (dst) {
+        const uint64_t *row = &utf8_pack3[twos | threes << 4];
+        uint8x16_t shuffle = pstr__shuffle_neon(row);
+        vst1q_u8(
+            (uint8_t *)dst, vqtbl1q_u8(vreinterpretq_u8_u32(code), shuffle)
+        );
+    }
+
+    return 4 + pstr__bits8(twos) + pstr__bits8(threes);
 }
-#endif
 
-#ifdef PSTRING_SSE
-static uint64_t pstr__match_set_sse(
-    const char *buffer, const char *set, size_t length
+static size_t pstr__encode_utf8_neon(
+    char *dst,
+    size_t *bytes,
+    const void *src,
+    size_t length,
+    size_t width,
+    int swap
 ) {
-    __m128i vec = _mm_loadu_si128((const __m128i *)buffer);
-    uint64_t result = 0;
+    const uint16x8_t lanes = { 1, 2, 4, 8, 16, 32, 64, 128 };
+    const char *in = src;
+    size_t size = 0, i = 0;
+
+    /* blocks of characters always store 16 bytes, and the ones past their
+       size are overwritten by the characters after them, of which there
+       are at least 16 */
+    while (length - i >= 16) {
+        uint16x8_t code, next;
+        if (!pstr__load_units_neon(&code, &in[i * width], width, swap))
+            break;
 
-    #ifndef PSTRING_ALT_SPN
-    __m128i tmp = _mm_setzero_si128();
-    for (size_t ch = 0; ch < length; ch++) {
-        __m128i check = _mm_set1_epi8(set[ch]);
-        tmp = _mm_or_si128(tmp, _mm_cmpeq_epi8(vec, check));
-    }
-    result = _mm_movemask_epi8(tmp);
-    #else
-    for (size_t ch = 0; ch < length; ch++) {
-        __m128i check = _mm_set1_epi8(set[ch]);
-        result |= _mm_movemask_epi8(_mm_cmpeq_epi8(vec, check));
-    }
-    #endif
+        if (pstr__load_units_neon(&next, &in[(i + 8) * width], width, swap)
+            && vmaxvq_u16(vorrq_u16(code, next)) < 0x80) {
+            if (dst)
+                vst1q_u8(
+                    (uint8_t *)&dst[size],
+                    vcombine_u8(vmovn_u16(code), vmovn_u16(next))
+                );
+            i += 16;
+            size += 16;
+            continue;
+        }
 
-    return result;
-}
+        if (length - i < 24)
+            break;
 
-static uint64_t pstr__match_chr_sse(const char *buffer, int ch) {
-    __m128i vec = _mm_set1_epi8((char)ch);
-    __m128i chars = _mm_loadu_si128((const __m128i *)buffer);
-    return _mm_movemask_epi8(_mm_cmpeq_epi8(vec, chars));
-}
+        /* surrogates are left to the caller */
+        uint16x8_t top = vandq_u16(code, vdupq_n_u16(0xF800));
+        if (vmaxvq_u16(vceqq_u16(top, vdupq_n_u16(0xD800))))
+            break;
 
-static uint64_t pstr__compare_sse(const char *left, const char *right) {
-    __m128i leftVec = _mm_loadu_si128((const __m128i *)left);
-    __m128i rightVec = _mm_loadu_si128((const __m128i *)right);
-    return _mm_movemask_epi8(_mm_cmpeq_epi8(leftVec, rightVec));
-}
+        if (vmaxvq_u16(code) < 0x800) {
+            uint16x8_t last = vandq_u16(code, vdupq_n_u16(0x3F));
+            last = vorrq_u16(last, vdupq_n_u16(0x80));
+            uint16x8_t two = vorrq_u16(vshrq_n_u16(code, 6), vdupq_n_u16(0xC0));
+            two = vorrq_u16(two, vshlq_n_u16(last, 8));
+
+            uint16x8_t multi = vcgtq_u16(code, vdupq_n_u16(0x7F));
+            code = vbslq_u16(multi, two, code);
+
+            unsigned twos = vaddvq_u16(vandq_u16(multi, lanes));
+            if (dst)
+                vst1q_u8(
+                    (uint8_t *)&dst[size],
+                    vqtbl1q_u8(
+                        vreinterpretq_u8_u16(code),
+                        pstr__shuffle_neon(&utf8_pack2[twos])
+                    )
+                );
+            size += 8 + pstr__bits8(twos);
+        } else {
+            uint32x4_t low = vmovl_u16(vget_low_u16(code));
+            uint32x4_t high = vmovl_high_u16(code);
+
+            size += pstr__encode_lanes_neon(dst ? &dst[size] : NULL, low);
+            size += pstr__encode_lanes_neon(dst ? &dst[size] : NULL, high);
+        }
+
+        i += 8;
+    }
 
+    *bytes = size;
+    return i;
+}
 #endif
 
-static struct {
+struct pstr__impl {
     size_t size; /* vector size */
     uint64_t (*match_set)(const char *buffer, const char *set, size_t length);
     uint64_t (*match_chr)(const char *buffer, int ch);
     uint64_t (*compare)(const char *left, const char *right);
-} g_impl = {
-#if !defined(PSTRING_DETECT) && defined(PSTRING_AVX)
-    .size = 32,
-    .match_set = &pstr__match_set_avx,
-    .match_chr = &pstr__match_chr_avx,
-    .compare = &pstr__compare_avx,
-#elif !defined(PSTRING_DETECT) && defined(PSTRING_SSE)
-    .size = 16,
-    .match_set = &pstr__match_set_sse,
-    .match_chr = &pstr__match_chr_sse,
-    .compare = &pstr__compare_sse,
-#else
-    0
-#endif
+    uint64_t (*match_pair)(
+        const char *buffer, int first, int last, size_t distance
+    );
+    uint64_t (*match_class)(const char *buffer, const pstrset_t *set);
+    uint64_t (*change_case)(char *dst, const char *src, int upper);
+    uint64_t (*compare_case)(const char *left, const char *right);
+    uint64_t (*match_case)(const char *buffer, int ch);
+    int (*valid_utf8)(const char *buffer, size_t length);
+    size_t (*count_utf8)(const char *buffer, size_t length, int surrogates);
+    size_t (*decode_utf8)(
+        void *dst,
+        size_t *units,
+        const char *src,
+        size_t length,
+        size_t width,
+        int swap
+    );
+    size_t (*encode_utf8)(
+        char *dst,
+        size_t *bytes,
+        const void *src,
+        size_t length,
+        size_t width,
+        int swap
+    );
 };
 
-#ifdef PSTRING_DETECT
-    #include <pf_cpuinfo.h>
+#define PSTRING_IMPL(isa, bytes, class, valid, utf8) \
+    {                                                \
+        .size = (bytes),                             \
+        .match_set = &pstr__match_set_##isa,         \
+        .match_chr = &pstr__match_chr_##isa,         \
+        .compare = &pstr__compare_##isa,             \
+        .match_pair = &pstr__match_pair_##isa,       \
+        .match_class = (class),                      \
+        .change_case = &pstr__change_case_##isa,     \
+        .compare_case = &pstr__compare_case_##isa,   \
+        .match_case = &pstr__match_case_##isa,       \
+        .valid_utf8 = (valid),                       \
+        .count_utf8 = &pstr__count_utf8_##isa,       \
+        .decode_utf8 = &pstr__decode_utf8_##utf8,    \
+        .encode_utf8 = &pstr__encode_utf8_##utf8,    \
+    }
+
+/* The best implementation enabled by the compiler flags is used until,
+   or unless, a better one is found when the library is loaded. */
+static struct pstr__impl g_impl =
+#if defined(PSTRING_AVX512) && defined(__AVX512BW__)
+    PSTRING_IMPL(
+        avx512, 64, &pstr__match_class_avx512, &pstr__valid_utf8_avx512, avx512
+    );
+#elif defined(PSTRING_AVX) && defined(__AVX2__)
+    PSTRING_IMPL(avx, 32, &pstr__match_class_avx, &pstr__valid_utf8_avx, avx);
+#elif defined(PSTRING_SSSE3) && defined(__SSSE3__)
+    PSTRING_IMPL(
+        sse, 16, &pstr__match_class_ssse3, &pstr__valid_utf8_ssse3, ssse3
+    );
+#elif defined(PSTRING_SSE) && defined(__SSE2__)
+    PSTRING_IMPL(sse, 16, NULL, NULL, sse);
+#elif defined(PSTRING_NEON)
+    PSTRING_IMPL(
+        neon, 16, &pstr__match_class_neon, &pstr__valid_utf8_neon, neon
+    );
+#else
+    { 0 };
 #endif
 
-void pstrdetect(void) {
-#ifdef PSTRING_DETECT
+/* Runs once before `main` and before any thread the program starts, so
+   `g_impl` is never written while other threads may be reading it. */
+#ifdef PSTRING_DISPATCH
+__attribute__((constructor)) static void pstr__dispatch(void) {
+    __builtin_cpu_init();
+
+    #ifdef PSTRING_AVX512
+    if (__builtin_cpu_supports("avx512bw")) {
+        g_impl = (struct pstr__impl)PSTRING_IMPL(
+            avx512,
+            64,
+            &pstr__match_class_avx512,
+            &pstr__valid_utf8_avx512,
+            avx512
+        );
+        return;
+    }
+    #endif
     #ifdef PSTRING_AVX
-    if (PF_HAS_AVX) {
-        g_impl.size = 32;
-        g_impl.match_set = &pstr__match_set_avx;
-        g_impl.match_chr = &pstr__match_chr_avx;
-        g_impl.compare = &pstr__compare_avx;
+    if (__builtin_cpu_supports("avx2")) {
+        g_impl = (struct pstr__impl)PSTRING_IMPL(
+            avx, 32, &pstr__match_class_avx, &pstr__valid_utf8_avx, avx
+        );
+        return;
+    }
+    #endif
+    #ifdef PSTRING_SSSE3
+    if (__builtin_cpu_supports("ssse3")) {
+        g_impl = (struct pstr__impl)PSTRING_IMPL(
+            sse, 16, &pstr__match_class_ssse3, &pstr__valid_utf8_ssse3, ssse3
+        );
+        return;
     }
     #endif
     #ifdef PSTRING_SSE
-    if (PF_HAS_SSE) {
-        g_impl.size = 16;
-        g_impl.match_set = &pstr__match_set_sse;
-        g_impl.match_chr = &pstr__match_chr_sse;
-        g_impl.compare = &pstr__compare_sse;
+    if (__builtin_cpu_supports("sse2")) {
+        g_impl = (struct pstr__impl)PSTRING_IMPL(sse, 16, NULL, NULL, sse);
+        return;
     }
     #endif
+}
 #endif
+
+void pstrdetect(void) {
+}
+
+/* Returns a mask of the lowest `bits` bits, `bits` must be in [1, 64]. */
+static inline uint64_t pstr__mask(size_t bits) {
+    return UINT64_MAX >> (64 - bits);
 }
 
 static inline int pstr__clz_masked(uint64_t x, int bits) {
-    return pf_clz(x & ((1 << bits) - 1)) - bits;
+    return pf_clz64(x & pstr__mask(bits)) - (64 - bits);
 }
 
 size_t pstr__nlen(const char *str, size_t max) {
@@ -192,8 +2573,8 @@ size_t pstr__nlen(const char *str, size_t max) {
 
     size_t i = 0;
     if (g_impl.size > 0) {
-        for (int result; max - i >= g_impl.size; i += g_impl.size) {
-            if ((result = g_impl.match_chr(str, '\0'))) {
+        for (uint64_t result; max - i >= g_impl.size; i += g_impl.size) {
+            if ((result = g_impl.match_chr(&str[i], '\0'))) {
                 int bit = pf_ctz64(result);
                 return i + bit;
             }
@@ -272,10 +2653,136 @@ int pstrwrap(pstring_t *out, char *buffer, size_t length, size_t capacity) {
     return PSTRING_OK;
 }
 
+struct share {
+    atomic_size_t refs;
+    allocator_t *allocator;
+};
+
+static struct share *share_of(void *buffer) {
+    return (struct share *)((char *)buffer - SHARE_HEADER);
+}
+
+static void *share_alloc(allocator_t *allocator, size_t size) {
+    struct share *share = allocate_aligned(
+        allocator, SHARE_HEADER + size, SHARE_ALIGN
+    );
+    if (!share)
+        return NULL;
+
+    atomic_init(&share->refs, 1);
+    share->allocator = allocator;
+    return (char *)share + SHARE_HEADER;
+}
+
+static void share_release(void *buffer, size_t size) {
+    struct share *share = share_of(buffer);
+    if (atomic_fetch_sub_explicit(&share->refs, 1, memory_order_acq_rel) == 1)
+        deallocate(share->allocator, share, SHARE_HEADER + size);
+}
+
+/* Buffers of shared strings are managed by this allocator, so the existing
+   growing and freeing paths copy or release them as needed. New buffers have
+   no string they were shared from to take an allocator from, so they use the
+   standard one. */
+static void *shared_alloc(allocator_t *self, size_t size, size_t align) {
+    if (align > SHARE_ALIGN)
+        return NULL;
+
+    return share_alloc(&standard_allocator, size);
+}
+
+static void *shared_realloc(
+    allocator_t *self, void *ptr, size_t old, size_t size, size_t align
+) {
+    if (!ptr)
+        return shared_alloc(self, size, align);
+    if (align > SHARE_ALIGN)
+        return NULL;
+
+    struct share *share = share_of(ptr);
+    if (atomic_load_explicit(&share->refs, memory_order_acquire) == 1) {
+        share = reallocate(
+            share->allocator, share, SHARE_HEADER + old, SHARE_HEADER + size
+        );
+        return share ? (char *)share + SHARE_HEADER : NULL;
+    }
+
+    char *out = share_alloc(share->allocator, size);
+    if (!out)
+        return NULL;
+
+    memcpy(out, ptr, MIN(old, size));
+    share_release(ptr, old);
+    return out;
+}
+
+static void shared_free(allocator_t *self, void *ptr, size_t size) {
+    if (ptr)
+        share_release(ptr, size);
+}
+
+allocator_t pstr__shared = {
+    .alloc = shared_alloc,
+    .realloc = shared_realloc,
+    .free = shared_free,
+};
+
+int pstr__unshare(pstring_t *str) {
+    struct share *share = share_of(pstrbuf(str));
+    if (atomic_load_explicit(&share->refs, memory_order_acquire) == 1)
+        return PSTRING_OK;
+
+    char *buffer = share_alloc(share->allocator, pstrcap(str) + 1);
+    if (!buffer)
+        return PSTRING_ENOMEM;
+
+    memcpy(buffer, pstrbuf(str), pstrlen(str));
+    buffer[pstrlen(str)] = '\0';
+    share_release(pstrbuf(str), pstrcap(str) + 1);
+    str->buffer = buffer;
+    return PSTRING_OK;
+}
+
+int pstrshare(pstring_t *out, pstring_t *str) {
+    if (!out || !str)
+        return PSTRING_EINVAL;
+
+    allocator_t *allocator = pstrallocator(str);
+    if (allocator && allocator != &pstr__shared) {
+        char *buffer = share_alloc(allocator, pstrcap(str) + 1);
+        if (!buffer)
+            return PSTRING_ENOMEM;
+
+        memcpy(buffer, pstrbuf(str), pstrlen(str) + 1);
+        deallocate(allocator, pstrbuf(str), pstrcap(str) + 1);
+        str->buffer = buffer;
+        str->base.allocator = &pstr__shared;
+    }
+
+    if (pstrallocator(str) == &pstr__shared) {
+        struct share *share = share_of(pstrbuf(str));
+        atomic_fetch_add_explicit(&share->refs, 1, memory_order_relaxed);
+    }
+
+    *out = *str;
+    return PSTRING_OK;
+}
+
+int pstrshared(const pstring_t *str) {
+    if (pstrallocator(str) != &pstr__shared)
+        return PSTRING_FALSE;
+
+    struct share *share = share_of(pstrbuf(str));
+    return atomic_load_explicit(&share->refs, memory_order_acquire) > 1;
+}
+
 int pstrdup(pstring_t *out, const pstring_t *str, allocator_t *allocator) {
     if (!out || !str)
         return PSTRING_EINVAL;
 
+    if (pstrallocator(str) == &pstr__shared)
+        return pstrshare(out, (pstring_t *)str);
+
     return pstrnew(out, pstrbuf(str), pstrlen(str), pstrallocator(str));
 }
 
@@ -310,6 +2817,9 @@ int pstrcut(pstring_t *str, size_t from, size_t to) {
             return PSTRING_OK;
         }
 
+        if (pstr__writable(str))
+            return PSTRING_ENOMEM;
+
         if (from > 0)
             memmove(pstrslot(str, 0), pstrslot(str, from), to - from);
         pstr__setlen(str, to - from);
@@ -355,6 +2865,9 @@ int pstrreserve(pstring_t *str, size_t count) {
     if (!str)
         return PSTRING_EINVAL;
 
+    if (pstr__writable(str))
+        return PSTRING_ENOMEM;
+
     if (count > 0 && pstrlen(str) + count > pstrcap(str))
         if (pstrgrow(str, GROWTH(pstrlen(str), count)))
             return PSTRING_ENOMEM;
@@ -397,71 +2910,381 @@ int pstrshrink(pstring_t *str) {
     size_t capacity = ALIGN(pstrlen(str) + 1, ALIGNMENT);
     char *buffer = reallocate(pstrallocator(str), pstrbuf(str), old, capacity);
 
-    if (!buffer)
-        return PSTRING_ENOMEM;
+    if (!buffer)
+        return PSTRING_ENOMEM;
+
+    str->buffer = buffer;
+    str->base.capacity = capacity - 1;
+    return PSTRING_OK;
+}
+
+int pstrequal(const pstring_t *left, const pstring_t *right) {
+    if (left == right)
+        return PSTRING_TRUE;
+
+    size_t length = pstrlen(left);
+    if (length != pstrlen(right))
+        return PSTRING_FALSE;
+
+    const char *leftBuf = pstrbuf(left);
+    const char *rightBuf = pstrbuf(right);
+    size_t i = 0;
+
+    if (g_impl.size > 0) {
+        uint64_t full = pstr__mask(g_impl.size);
+
+        for (; length - i >= g_impl.size; i += g_impl.size)
+            if (full != g_impl.compare(&leftBuf[i], &rightBuf[i]))
+                return PSTRING_FALSE;
+    }
+
+    for (; i < length; i++)
+        if (leftBuf[i] != rightBuf[i])
+            return PSTRING_FALSE;
+
+    return PSTRING_TRUE;
+}
+
+PSTR_API int pstrequals(
+    const pstring_t *left, const char *right, size_t length
+) {
+    pstring_t tmp;
+    pstrwrap(&tmp, (char *)right, length, length);
+    return pstrequal(left, &tmp);
+}
+
+int pstrcmp(const pstring_t *left, const pstring_t *right) {
+    if (left == right)
+        return 0;
+
+    size_t length = MIN(pstrlen(left), pstrlen(right));
+    const char *leftBuf = pstrbuf(left);
+    const char *rightBuf = pstrbuf(right);
+    size_t i = 0;
+
+    if (g_impl.size > 0) {
+        for (; length - i >= g_impl.size; i += g_impl.size) {
+            uint64_t result = ~g_impl.compare(&leftBuf[i], &rightBuf[i]);
+            result &= pstr__mask(g_impl.size);
+
+            if (result) {
+                size_t at = i + pf_ctz64(result);
+                return leftBuf[at] - rightBuf[at];
+            }
+        }
+    }
+
+    for (; i < length; i++)
+        if (leftBuf[i] != rightBuf[i])
+            return leftBuf[i] - rightBuf[i];
+
+    return 0;
+}
+
+static inline int lower_ascii(int c) {
+    return c >= 'A' && c <= 'Z' ? c | 0x20 : c;
+}
+
+static inline int upper_ascii(int c) {
+    return c >= 'a' && c <= 'z' ? c & ~0x20 : c;
+}
+
+/* Characters are changed in place when their mapping has the same UTF-8
+   length, which is the case for all but a few dozen of them. Invalid
+   sequences are copied as they are. */
+static size_t change_case_utf8(
+    char *dst, const char *src, size_t length, int upper
+) {
+    uint32_t chr;
+    char tmp[4];
+
+    const char *next = pstr_read_utf8(src, &src[length], &chr);
+    size_t size = next - src;
+    uint32_t mapped = upper ? pstr_toupper(chr) : pstr_tolower(chr);
+
+    if (mapped != chr && (size_t)(pstr_write_utf8(tmp, mapped) - tmp) == size)
+        memcpy(dst, tmp, size);
+    else if (dst != src)
+        memcpy(dst, src, size);
+
+    return size;
+}
+
+static void change_case(char *dst, const char *src, size_t length, int upper) {
+    for (size_t i = 0; i < length;) {
+        if (g_impl.size > 0 && length - i >= g_impl.size) {
+            /* converts the whole vector, only characters from the first
+               non-ASCII byte onwards need to be looked at again */
+            uint64_t wide = g_impl.change_case(&dst[i], &src[i], upper);
+            if (!wide) {
+                i += g_impl.size;
+                continue;
+            }
+
+            i += pf_ctz64(wide);
+        } else if (!(src[i] & 0x80)) {
+            dst[i] = (char)(upper ? upper_ascii(src[i]) : lower_ascii(src[i]));
+            i++;
+            continue;
+        }
+
+        i += change_case_utf8(&dst[i], &src[i], length - i, upper);
+    }
+}
+
+static int change_case_into(pstring_t *dst, const pstring_t *src, int upper) {
+    if (!dst || !src || dst == src)
+        return PSTRING_EINVAL;
+
+    size_t length = pstrlen(src);
+    if (pstrreserve(dst, length))
+        return PSTRING_ENOMEM;
+
+    change_case(pstrend(dst), pstrbuf(src), length, upper);
+    pstr__setlen(dst, pstrlen(dst) + length);
+    return PSTRING_OK;
+}
+
+int pstrlower(pstring_t *str) {
+    if (!str)
+        return PSTRING_EINVAL;
+    if (pstr__writable(str))
+        return PSTRING_ENOMEM;
+
+    change_case(pstrbuf(str), pstrbuf(str), pstrlen(str), 0);
+    return PSTRING_OK;
+}
+
+int pstrupper(pstring_t *str) {
+    if (!str)
+        return PSTRING_EINVAL;
+    if (pstr__writable(str))
+        return PSTRING_ENOMEM;
+
+    change_case(pstrbuf(str), pstrbuf(str), pstrlen(str), 1);
+    return PSTRING_OK;
+}
+
+int pstrlower_into(pstring_t *dst, const pstring_t *src) {
+    return change_case_into(dst, src, 0);
+}
+
+int pstrupper_into(pstring_t *dst, const pstring_t *src) {
+    return change_case_into(dst, src, 1);
+}
+
+/* Reads a character with its case folded. Bytes of invalid sequences are
+   read one at a time, and are mapped past the last code point so they
+   only ever match themselves. */
+static const char *read_folded(
+    const char *chr, const char *end, uint32_t *out
+) {
+    unsigned char byte = (unsigned char)*chr;
+
+    if (byte < 0x80) {
+        *out = (uint32_t)lower_ascii(byte);
+        return chr + 1;
+    }
+
+    const char *next = pstr_read_utf8(chr, end, out);
+
+    if (*out == 0xFFFD && (next - chr != 3 || memcmp(chr, "\xEF\xBF\xBD", 3))) {
+        *out = 0x110000 + byte;
+        return chr + 1;
+    }
+
+    *out = pstr_tolower(pstr_toupper(*out));
+    return next;
+}
+
+/* Compares `left` and `right` ignoring case until either of them ends,
+   storing the number of bytes compared from each of them. Vectors are
+   compared as long as they contain equal ASCII characters. */
+static int compare_case(
+    const char *left,
+    size_t llen,
+    size_t *lused,
+    const char *right,
+    size_t rlen,
+    size_t *rused
+) {
+    size_t i = 0, j = 0;
+    int result = 0;
+
+    while (i < llen && j < rlen) {
+        if (g_impl.size > 0 && llen - i >= g_impl.size
+            && rlen - j >= g_impl.size) {
+            uint64_t diff = ~g_impl.compare_case(&left[i], &right[j]);
+            diff &= pstr__mask(g_impl.size);
+
+            if (!diff) {
+                i += g_impl.size;
+                j += g_impl.size;
+                continue;
+            }
+
+            i += pf_ctz64(diff);
+            j += pf_ctz64(diff);
+        }
+
+        uint32_t lchr, rchr;
+        const char *lnext = read_folded(&left[i], &left[llen], &lchr);
+        const char *rnext = read_folded(&right[j], &right[rlen], &rchr);
+
+        if (lchr != rchr) {
+            result = lchr < rchr ? -1 : 1;
+            break;
+        }
+
+        i = lnext - left;
+        j = rnext - right;
+    }
+
+    *lused = i;
+    *rused = j;
+    return result;
+}
+
+int pstrcasecmp(const pstring_t *left, const pstring_t *right) {
+    if (left == right)
+        return 0;
+
+    size_t llen = pstrlen(left), rlen = pstrlen(right), i, j;
+    int result
+        = compare_case(pstrbuf(left), llen, &i, pstrbuf(right), rlen, &j);
+
+    if (result)
+        return result;
+
+    return (i < llen) - (j < rlen);
+}
 
-    str->buffer = buffer;
-    str->base.capacity = capacity - 1;
-    return PSTRING_OK;
+int pstrcaseequal(const pstring_t *left, const pstring_t *right) {
+    return pstrcasecmp(left, right) ? PSTRING_FALSE : PSTRING_TRUE;
 }
 
-int pstrequal(const pstring_t *left, const pstring_t *right) {
-    if (left == right)
-        return PSTRING_TRUE;
+/* Checks for well-formed byte sequences from Table 3-7 of the Unicode
+   standard, which rule out overlong forms, surrogates and code points
+   past U+10FFFF. ASCII is skipped a word at a time. */
+static int valid_utf8(const char *buffer, size_t length) {
+    const unsigned char *bytes = (const unsigned char *)buffer;
 
-    size_t length = pstrlen(left);
-    if (length != pstrlen(right))
-        return PSTRING_FALSE;
+    for (size_t i = 0; i < length;) {
+        uint64_t word;
 
-    const char *leftBuf = pstrbuf(left);
-    const char *rightBuf = pstrbuf(right);
-    size_t i = 0, mask = (1ull << g_impl.size) - 1;
+        if (length - i >= sizeof(word)) {
+            memcpy(&word, &bytes[i], sizeof(word));
+            if (!(word & 0x8080808080808080)) {
+                i += sizeof(word);
+                continue;
+            }
+        }
 
-    if (g_impl.size > 0) {
-        for (; length - i >= g_impl.size; i += g_impl.size)
-            if (mask != g_impl.compare(&leftBuf[i], &rightBuf[i]))
-                return PSTRING_FALSE;
-    }
+        unsigned char lead = bytes[i];
+        if (lead < 0x80) {
+            i++;
+            continue;
+        }
 
-    for (; i < length; i++)
-        if (leftBuf[i] != rightBuf[i])
+        if (lead < 0xC2 || lead > 0xF4)
+            return PSTRING_FALSE;
+
+        size_t size = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : 2;
+        unsigned char low = 0x80, high = 0xBF;
+
+        if (lead == 0xE0)
+            low = 0xA0;
+        else if (lead == 0xED)
+            high = 0x9F;
+        else if (lead == 0xF0)
+            low = 0x90;
+        else if (lead == 0xF4)
+            high = 0x8F;
+
+        if (length - i < size || bytes[i + 1] < low || bytes[i + 1] > high)
             return PSTRING_FALSE;
 
+        for (size_t j = 2; j < size; j++)
+            if ((bytes[i + j] & 0xC0) != 0x80)
+                return PSTRING_FALSE;
+
+        i += size;
+    }
+
     return PSTRING_TRUE;
 }
 
-PSTR_API int pstrequals(
-    const pstring_t *left, const char *right, size_t length
-) {
-    pstring_t tmp;
-    pstrwrap(&tmp, (char *)right, length, length);
-    return pstrequal(left, &tmp);
+int pstrvalid_utf8(const pstring_t *str) {
+    if (!str)
+        return PSTRING_FALSE;
+
+    if (g_impl.valid_utf8)
+        return g_impl.valid_utf8(pstrbuf(str), pstrlen(str));
+
+    return valid_utf8(pstrbuf(str), pstrlen(str));
 }
 
-int pstrcmp(const pstring_t *left, const pstring_t *right) {
-    if (left == right)
+size_t pstrlen_utf8(const pstring_t *str) {
+    if (!str)
         return 0;
 
-    size_t length = MIN(pstrlen(left), pstrlen(right));
-    const char *leftBuf = pstrbuf(left);
-    const char *rightBuf = pstrbuf(right);
-    size_t i = 0;
+    const char *buffer = pstrbuf(str);
+    size_t length = pstrlen(str);
 
-    if (g_impl.size > 0) {
-        for (; length - i >= g_impl.size; i += g_impl.size) {
-            int result = ~g_impl.compare(&leftBuf[i], &rightBuf[i]);
+    if (g_impl.size > 0)
+        return g_impl.count_utf8(buffer, length, PSTRING_FALSE);
 
-            if (result) {
-                int bit = pstr__clz_masked(result, g_impl.size);
-                return leftBuf[bit] - rightBuf[bit];
-            }
-        }
-    }
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++)
+        count += pstr__utf8_units(buffer[i], PSTRING_FALSE);
 
-    for (; i < length; i++)
-        if (leftBuf[i] != rightBuf[i])
-            return leftBuf[i] - rightBuf[i];
+    return count;
+}
+
+size_t pstrlen_utf16(const pstring_t *str) {
+    if (!str)
+        return 0;
 
+    const char *buffer = pstrbuf(str);
+    size_t length = pstrlen(str);
+
+    if (g_impl.size > 0)
+        return g_impl.count_utf8(buffer, length, PSTRING_TRUE);
+
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++)
+        count += pstr__utf8_units(buffer[i], PSTRING_TRUE);
+
+    return count;
+}
+
+size_t pstr__decode_utf8(
+    void *dst,
+    size_t *units,
+    const char *src,
+    size_t length,
+    size_t width,
+    int swap
+) {
+    if (g_impl.size > 0)
+        return g_impl.decode_utf8(dst, units, src, length, width, swap);
+
+    *units = 0;
+    return 0;
+}
+
+size_t pstr__encode_utf8(
+    char *dst,
+    size_t *bytes,
+    const void *src,
+    size_t length,
+    size_t width,
+    int swap
+) {
+    if (g_impl.size > 0)
+        return g_impl.encode_utf8(dst, bytes, src, length, width, swap);
+
+    *bytes = 0;
     return 0;
 }
 
@@ -572,6 +3395,9 @@ int pstrremove(pstring_t *str, size_t from, size_t to) {
     if (from >= len || to > len)
         return PSTRING_EINVAL;
 
+    if (pstr__writable(str))
+        return PSTRING_ENOMEM;
+
     if (to < len)
         memmove(pstrslot(str, from), pstrslot(str, to), len - to);
     pstr__setlen(str, len - (to - from));
@@ -582,7 +3408,7 @@ int pstrcpy(pstring_t *dst, const pstring_t *src) {
     if (!dst || !src)
         return PSTRING_EINVAL;
 
-    pstr__setlen(dst, 0);
+    pstrclear(dst);
     return pstrcat(dst, src);
 }
 
@@ -619,7 +3445,7 @@ char *pstrchr(const pstring_t *str, int ch) {
 
     if (g_impl.size > 0) {
         for (; length - i >= g_impl.size; i += g_impl.size) {
-            int result = g_impl.match_chr(&buffer[i], ch);
+            uint64_t result = g_impl.match_chr(&buffer[i], ch);
 
             if (result) {
                 int bit = pf_ctz64(result);
@@ -646,7 +3472,7 @@ char *pstrrchr(const pstring_t *str, int ch) {
     if (g_impl.size > 0) {
         for (; length - i >= g_impl.size; i += g_impl.size) {
             char *slot = &buffer[length - i - g_impl.size];
-            int result = g_impl.match_chr(slot, ch);
+            uint64_t result = g_impl.match_chr(slot, ch);
 
             if (result) {
                 int bit = pstr__clz_masked(result, g_impl.size);
@@ -670,14 +3496,14 @@ size_t pstrspn(const pstring_t *str, const char *set) {
     size_t length = pstrlen(str);
     size_t setlen = pstr__nlen(set, PSTRING_MAX_SET);
     size_t i = 0;
-    int result = 0;
+    uint64_t result = 0;
 
     if (g_impl.size > 0) {
         for (; length - i >= g_impl.size; i += g_impl.size) {
             result = g_impl.match_set(&buffer[i], set, setlen);
 
-            if (~result) {
-                int bit = result ? pf_ctz64(~result) : 0;
+            if (~result & pstr__mask(g_impl.size)) {
+                int bit = pf_ctz64(~result);
                 return i + bit;
             }
         }
@@ -703,14 +3529,14 @@ size_t pstrcspn(const pstring_t *str, const char *set) {
     size_t length = pstrlen(str);
     size_t setlen = pstr__nlen(set, PSTRING_MAX_SET);
     size_t i = 0;
-    int result = 0;
+    uint64_t result = 0;
 
     if (g_impl.size > 0) {
         for (; length - i >= g_impl.size; i += g_impl.size) {
             result = g_impl.match_set(&buffer[i], set, setlen);
 
             if (result) {
-                int bit = ~result ? pf_ctz64(result) : 0;
+                int bit = pf_ctz64(result);
                 return i + bit;
             }
         }
@@ -732,15 +3558,15 @@ size_t pstrrspn(const pstring_t *str, const char *set) {
     size_t setlen = pstr__nlen(set, PSTRING_MAX_SET);
     const char *buffer = pstrbuf(str);
     size_t i = 0;
-    int result = 0;
+    uint64_t result = 0;
 
     if (g_impl.size > 0) {
         for (; length - i >= g_impl.size; i += g_impl.size) {
             const char *slot = &buffer[length - i - g_impl.size];
             result = g_impl.match_set(slot, set, setlen);
 
-            if (~result) {
-                int bit = result ? pstr__clz_masked(~result, g_impl.size) : 0;
+            if (~result & pstr__mask(g_impl.size)) {
+                int bit = pstr__clz_masked(~result, g_impl.size);
                 return i + bit;
             }
         }
@@ -766,7 +3592,7 @@ size_t pstrrcspn(const pstring_t *str, const char *set) {
     size_t setlen = pstr__nlen(set, PSTRING_MAX_SET);
     const char *buffer = pstrbuf(str);
     size_t i = 0;
-    int result = 0;
+    uint64_t result = 0;
 
     if (g_impl.size > 0) {
         for (; length - i >= g_impl.size; i += g_impl.size) {
@@ -774,7 +3600,7 @@ size_t pstrrcspn(const pstring_t *str, const char *set) {
             result = g_impl.match_set(slot, set, setlen);
 
             if (result) {
-                int bit = ~result ? pstr__clz_masked(result, g_impl.size) : 0;
+                int bit = pstr__clz_masked(result, g_impl.size);
                 return i + bit;
             }
         }
@@ -800,7 +3626,7 @@ char *pstrpbrk(const pstring_t *str, const char *set) {
 
     if (g_impl.size > 0) {
         for (; length - i >= g_impl.size; i += g_impl.size) {
-            int result = g_impl.match_set(&buffer[i], set, setlen);
+            uint64_t result = g_impl.match_set(&buffer[i], set, setlen);
 
             if (result) {
                 int bit = pf_ctz64(result);
@@ -829,8 +3655,8 @@ char *pstrcpbrk(const pstring_t *str, const char *set) {
 
     if (g_impl.size > 0) {
         for (; length - i >= g_impl.size; i += g_impl.size) {
-            int result = g_impl.match_set(&buffer[i], set, setlen);
-            result = ~result & ((1 << g_impl.size) - 1);
+            uint64_t result = g_impl.match_set(&buffer[i], set, setlen);
+            result = ~result & pstr__mask(g_impl.size);
 
             if (result) {
                 int bit = pf_ctz64(result);
@@ -862,7 +3688,7 @@ char *pstrrpbrk(const pstring_t *str, const char *set) {
 
     if (g_impl.size > 0) {
         for (; length - i >= g_impl.size; i += g_impl.size) {
-            int result = g_impl.match_set(
+            uint64_t result = g_impl.match_set(
                 &buffer[length - i - g_impl.size], set, setlen
             );
 
@@ -873,7 +3699,7 @@ char *pstrrpbrk(const pstring_t *str, const char *set) {
         }
     }
 
-    for (; i > 0; i--) {
+    for (; i < length; i++) {
         for (size_t j = 0; j < setlen; j++)
             if (buffer[length - i - 1] == set[j])
                 return &buffer[length - i - 1];
@@ -893,13 +3719,13 @@ char *pstrrcpbrk(const pstring_t *str, const char *set) {
 
     if (g_impl.size > 0) {
         for (; length - i >= g_impl.size; i += g_impl.size) {
-            int result = g_impl.match_set(
+            uint64_t result = g_impl.match_set(
                 &buffer[length - i - g_impl.size], set, setlen
             );
-            result = ~result & ((1 << g_impl.size) - 1);
+            result = ~result & pstr__mask(g_impl.size);
 
             if (result) {
-                int bit = ~result ? pstr__clz_masked(result, g_impl.size) : 0;
+                int bit = pstr__clz_masked(result, g_impl.size);
                 return &buffer[length - i - bit - 1];
             }
         }
@@ -917,30 +3743,414 @@ char *pstrrcpbrk(const pstring_t *str, const char *set) {
     return NULL;
 }
 
+int pstrset_init(pstrset_t *out, const char *chars, size_t length) {
+    if (!out || !chars)
+        return PSTRING_EINVAL;
+
+    if (length == 0)
+        length = strlen(chars);
+
+    memset(out, 0, sizeof(*out));
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)chars[i];
+        unsigned char *row = c < 0x80 ? out->low : out->high;
+
+        row[c & 0x0f] |= 1 << ((c >> 4) & 7);
+        out->bitmap[c >> 3] |= 1 << (c & 7);
+    }
+
+    return PSTRING_OK;
+}
+
+/* Returns the index of the first character of `buffer` whose membership in
+   `set` matches `member`, or `length` if there is none. */
+static size_t find_class(
+    const char *buffer, size_t length, const pstrset_t *set, int member
+) {
+    uint64_t invert = member ? 0 : UINT64_MAX;
+    size_t i = 0;
+
+    if (g_impl.size > 0 && g_impl.match_class) {
+        uint64_t full = pstr__mask(g_impl.size);
+
+        for (; length - i >= g_impl.size; i += g_impl.size) {
+            uint64_t result = g_impl.match_class(&buffer[i], set);
+            result = (result ^ invert) & full;
+
+            if (result)
+                return i + pf_ctz64(result);
+        }
+    }
+
+    for (; i < length; i++)
+        if (pstrset_has(set, buffer[i]) == member)
+            return i;
+
+    return length;
+}
+
+/* Returns the index of the last character of `buffer` whose membership in
+   `set` matches `member`, or `SIZE_MAX` if there is none. */
+static size_t rfind_class(
+    const char *buffer, size_t length, const pstrset_t *set, int member
+) {
+    uint64_t invert = member ? 0 : UINT64_MAX;
+    size_t i = 0;
+
+    if (g_impl.size > 0 && g_impl.match_class) {
+        uint64_t full = pstr__mask(g_impl.size);
+
+        for (; length - i >= g_impl.size; i += g_impl.size) {
+            size_t slot = length - i - g_impl.size;
+            uint64_t result = g_impl.match_class(&buffer[slot], set);
+            result = (result ^ invert) & full;
+
+            if (result)
+                return slot + 63 - pf_clz64(result);
+        }
+    }
+
+    for (; i < length; i++)
+        if (pstrset_has(set, buffer[length - i - 1]) == member)
+            return length - i - 1;
+
+    return SIZE_MAX;
+}
+
+size_t pstrspn_set(const pstring_t *str, const pstrset_t *set) {
+    if (!str || !set)
+        return 0;
+
+    return find_class(pstrbuf(str), pstrlen(str), set, 0);
+}
+
+size_t pstrcspn_set(const pstring_t *str, const pstrset_t *set) {
+    if (!str || !set)
+        return 0;
+
+    return find_class(pstrbuf(str), pstrlen(str), set, 1);
+}
+
+char *pstrpbrk_set(const pstring_t *str, const pstrset_t *set) {
+    if (!str || !set)
+        return NULL;
+
+    size_t i = find_class(pstrbuf(str), pstrlen(str), set, 1);
+    return i < pstrlen(str) ? &pstrbuf(str)[i] : NULL;
+}
+
+char *pstrcpbrk_set(const pstring_t *str, const pstrset_t *set) {
+    if (!str || !set)
+        return NULL;
+
+    size_t i = find_class(pstrbuf(str), pstrlen(str), set, 0);
+    return i < pstrlen(str) ? &pstrbuf(str)[i] : NULL;
+}
+
+/* Computes the maximal suffix of `needle` and it's period,
+   using reversed byte ordering if `reverse` is set. */
+static size_t maximal_suffix(
+    const unsigned char *needle, size_t length, size_t *period, int reverse
+) {
+    size_t ip = SIZE_MAX, jp = 0, k = 1, p = 1;
+
+    while (jp + k < length) {
+        unsigned char a = needle[ip + k];
+        unsigned char b = needle[jp + k];
+
+        if (a == b) {
+            if (k == p) {
+                jp += p;
+                k = 1;
+            } else {
+                k++;
+            }
+        } else if (reverse ? a < b : a > b) {
+            jp += k;
+            k = 1;
+            p = jp - ip;
+        } else {
+            ip = jp++;
+            k = p = 1;
+        }
+    }
+
+    *period = p;
+    return ip;
+}
+
+/* Crochemore-Perrin Two-Way algorithm, which runs in linear time
+   and constant space regardless of how repetitive the input is. */
+static char *two_way(
+    const char *buffer, size_t length, const char *sub, size_t sublen
+) {
+    const unsigned char *hay = (const unsigned char *)buffer;
+    const unsigned char *needle = (const unsigned char *)sub;
+
+    if (length < sublen)
+        return NULL;
+
+    size_t period, rperiod;
+    size_t suffix = maximal_suffix(needle, sublen, &period, 0);
+    size_t rsuffix = maximal_suffix(needle, sublen, &rperiod, 1);
+
+    if (rsuffix + 1 > suffix + 1) {
+        suffix = rsuffix;
+        period = rperiod;
+    }
+
+    size_t memory = 0, reset;
+    if (memcmp(needle, &needle[period], suffix + 1)) {
+        reset = 0;
+        period = MAX(suffix, sublen - suffix - 1) + 1;
+    } else {
+        reset = sublen - period;
+    }
+
+    for (size_t i = 0, k; i <= length - sublen;) {
+        k = MAX(suffix + 1, memory);
+        while (k < sublen && needle[k] == hay[i + k])
+            k++;
+
+        if (k < sublen) {
+            i += k - suffix;
+            memory = 0;
+            continue;
+        }
+
+        k = suffix + 1;
+        while (k > memory && needle[k - 1] == hay[i + k - 1])
+            k--;
+
+        if (k <= memory)
+            return (char *)&buffer[i];
+
+        i += period;
+        memory = reset;
+    }
+
+    return NULL;
+}
+
 char *pstrstr(const pstring_t *str, const pstring_t *sub) {
     if (!str || !sub || pstrlen(sub) > pstrlen(str))
         return NULL;
 
-    if (pstrlen(sub) == 0)
+    size_t sublen = pstrlen(sub);
+    if (sublen == 0)
         return pstrbuf(str);
+    if (sublen == 1)
+        return pstrchr(str, pstrbuf(sub)[0]);
+
+    const char *needle = pstrbuf(sub);
+    char *buffer = pstrbuf(str);
+    size_t length = pstrlen(str);
+    size_t count = length - sublen + 1; /* possible match positions */
+    size_t i = 0, work = 0;
+
+    char first = needle[0];
+    char last = needle[sublen - 1];
+
+    if (g_impl.size > 0) {
+        while (count - i >= g_impl.size) {
+            uint64_t result
+                = g_impl.match_pair(&buffer[i], first, last, sublen - 1);
+
+            for (; result; result &= result - 1) {
+                size_t at = i + pf_ctz64(result);
+                if (0 == memcmp(&buffer[at + 1], &needle[1], sublen - 2))
+                    return &buffer[at];
+                work += sublen;
+            }
+
+            i += g_impl.size;
+            if (work > SEARCH_BUDGET(i))
+                return two_way(&buffer[i], length - i, needle, sublen);
+        }
+    }
+
+    for (; i < count; i++) {
+        if (buffer[i] != first || buffer[i + sublen - 1] != last)
+            continue;
+        if (0 == memcmp(&buffer[i + 1], &needle[1], sublen - 2))
+            return &buffer[i];
+
+        work += sublen;
+        if (work > SEARCH_BUDGET(i))
+            return two_way(&buffer[i + 1], length - i - 1, needle, sublen);
+    }
 
-    char ch = pstrbuf(sub)[0];
-    char *end = pstrend(str) - pstrlen(sub) + 1;
+    return NULL;
+}
+
+static int match_case(
+    const char *buffer, size_t length, const char *needle, size_t sublen
+) {
+    size_t used, subused;
+    int result = compare_case(buffer, length, &used, needle, sublen, &subused);
+    return result == 0 && subused == sublen;
+}
+
+/* Writes a character read by `read_folded` as UTF-8, with the bytes of
+   invalid sequences, mapped past the last code point, written as four bytes
+   the same way. This keeps the encoding prefix-free, so matches of a folded
+   string inside another start and end at the edges of characters. */
+static size_t write_folded(char *dst, uint32_t chr) {
+    if (chr <= 0x10FFFF)
+        return pstr_write_utf8(dst, chr) - dst;
+
+    dst[0] = (char)(0xF0 | chr >> 18);
+    dst[1] = (char)(0x80 | (chr >> 12 & 0x3F));
+    dst[2] = (char)(0x80 | (chr >> 6 & 0x3F));
+    dst[3] = (char)(0x80 | (chr & 0x3F));
+    return 4;
+}
+
+static size_t fold(char *dst, const char *src, size_t length) {
+    const char *end = &src[length];
+    size_t size = 0;
+
+    while (src < end) {
+        uint32_t chr;
+        src = read_folded(src, end, &chr);
+        size += write_folded(&dst[size], chr);
+    }
+
+    return size;
+}
+
+/* Searches for `sub` ignoring case in `str` from index `from` in linear time,
+   by folding both into a scratch buffer and searching it with the Two-Way
+   algorithm. Folding changes the lengths of characters, so the match is
+   found in `str` by folding it again up to the match. */
+static int casestr_two_way(
+    const pstring_t *str, size_t from, const pstring_t *sub, char **out
+) {
+    allocator_t *allocator = pstrallocator(str);
+    const char *buffer = &pstrbuf(str)[from];
+    size_t length = pstrlen(str) - from, sublen = pstrlen(sub);
+
+    if (!allocator)
+        allocator = &standard_allocator;
+    if (length > SIZE_MAX / 4 - sublen)
+        return PSTRING_ENOMEM;
 
+    /* characters never take more than four bytes after folding */
+    size_t size = (length + sublen) * 4;
+    char *scratch = allocate(allocator, size);
+    if (!scratch)
+        return PSTRING_ENOMEM;
+
+    size_t folded = fold(scratch, buffer, length);
+    char *needle = &scratch[folded];
+    char *match
+        = two_way(scratch, folded, needle, fold(needle, pstrbuf(sub), sublen));
+
+    *out = NULL;
+    if (match) {
+        const char *chr = buffer, *end = &buffer[length];
+        char tmp[4];
+
+        for (size_t at = 0; at < (size_t)(match - scratch);) {
+            uint32_t code;
+            chr = read_folded(chr, end, &code);
+            at += write_folded(tmp, code);
+        }
+
+        *out = (char *)chr;
+    }
+
+    deallocate(allocator, scratch, size);
+    return PSTRING_OK;
+}
+
+/* Any non-ASCII character might fold into the first character of `sub`, so
+   every non-ASCII byte is a candidate along with ASCII matches of it. Like
+   `pstrstr`, the search switches to the Two-Way algorithm once verifying
+   candidates takes too long, unless `sub` starts with a continuation byte,
+   which can match in the middle of a character, or there's no memory to
+   fold the strings. */
+char *pstrcasestr(const pstring_t *str, const pstring_t *sub) {
+    if (!str || !sub)
+        return NULL;
+
+    const char *needle = pstrbuf(sub);
+    char *buffer = pstrbuf(str);
+    size_t sublen = pstrlen(sub);
+    size_t length = pstrlen(str);
+    size_t i = 0, work = 0;
+    uint32_t first;
     char *match;
+
+    if (sublen == 0)
+        return buffer;
+
+    int linear = (needle[0] & 0xC0) != 0x80;
+    read_folded(needle, &needle[sublen], &first);
+    int ch = first < 0x80 ? (int)first : 0x80;
+
+    if (g_impl.size > 0) {
+        for (; length - i >= g_impl.size; i += g_impl.size) {
+            uint64_t result = g_impl.match_case(&buffer[i], ch);
+
+            for (; result; result &= result - 1) {
+                size_t at = i + pf_ctz64(result);
+                if (match_case(&buffer[at], length - at, needle, sublen))
+                    return &buffer[at];
+                work += sublen;
+            }
+
+            size_t next = i + g_impl.size;
+            if (linear && work > SEARCH_BUDGET(next)) {
+                if (!casestr_two_way(str, next, sub, &match))
+                    return match;
+                linear = 0;
+            }
+        }
+    }
+
+    for (; i < length; i++) {
+        if (!(buffer[i] & 0x80) && lower_ascii(buffer[i]) != ch)
+            continue;
+        if (match_case(&buffer[i], length - i, needle, sublen))
+            return &buffer[i];
+
+        work += sublen;
+        if (linear && work > SEARCH_BUDGET(i)) {
+            if (!casestr_two_way(str, i + 1, sub, &match))
+                return match;
+            linear = 0;
+        }
+    }
+
+    return NULL;
+}
+
+int pstrtok(pstring_t *dst, const pstring_t *src, const char *set) {
+    if (!dst || !src)
+        return PSTRING_EINVAL;
+
+    if (!set) {
+        pstrslice(dst, src, 0, 0);
+        return PSTRING_OK;
+    }
+
     pstring_t search;
-    pstrrange(&search, NULL, pstrbuf(str), end);
 
-    while ((match = pstrchr(&search, ch))) {
-        if (0 == memcmp(match, pstrbuf(sub), pstrlen(sub)))
-            return match;
-        pstrrange(&search, NULL, match + 1, end);
-    }
+    pstrrange(&search, src, pstrend(dst), pstrend(src));
+    const char *start = pstrcpbrk(&search, set);
+
+    pstrrange(&search, src, start, pstrend(src));
+    const char *end = pstrpbrk(&search, set);
 
-    return NULL;
+    if (!start)
+        return PSTRING_ENOENT;
+
+    pstrrange(dst, src, start, end ? end : pstrend(src));
+    return PSTRING_OK;
 }
 
-int pstrtok(pstring_t *dst, const pstring_t *src, const char *set) {
+int pstrtok_set(pstring_t *dst, const pstring_t *src, const pstrset_t *set) {
     if (!dst || !src)
         return PSTRING_EINVAL;
 
@@ -950,16 +4160,15 @@ int pstrtok(pstring_t *dst, const pstring_t *src, const char *set) {
     }
 
     pstring_t search;
-
     pstrrange(&search, src, pstrend(dst), pstrend(src));
-    const char *start = pstrcpbrk(&search, set);
-
-    pstrrange(&search, src, start, pstrend(src));
-    const char *end = pstrpbrk(&search, set);
 
+    const char *start = pstrcpbrk_set(&search, set);
     if (!start)
         return PSTRING_ENOENT;
 
+    pstrrange(&search, src, start, pstrend(src));
+    const char *end = pstrpbrk_set(&search, set);
+
     pstrrange(dst, src, start, end ? end : pstrend(src));
     return PSTRING_OK;
 }
@@ -987,10 +4196,196 @@ int pstrsplit(pstring_t *dst, const pstring_t *src, const pstring_t *sep) {
     return prev == pstrend(src) ? PSTRING_ENOENT : PSTRING_OK;
 }
 
+struct fields {
+    pstring_t *out;
+    size_t max;
+    size_t count;
+    const char *start; /* start of the current field */
+};
+
+/* Ends the current field at `end`, the next one starts `skip` bytes later. */
+static inline void add_field(
+    struct fields *fields, const char *end, size_t skip
+) {
+    if (fields->count < fields->max)
+        pstrrange(&fields->out[fields->count], NULL, fields->start, end);
+
+    fields->count++;
+    fields->start = end + skip;
+}
+
+static void split_chr(
+    struct fields *fields, const char *buffer, size_t length, char sep
+) {
+    size_t i = 0;
+
+    if (g_impl.size > 0) {
+        uint64_t full = pstr__mask(g_impl.size);
+
+        for (; length - i >= g_impl.size; i += g_impl.size) {
+            uint64_t result = g_impl.match_chr(&buffer[i], sep) & full;
+            for (; result; result &= result - 1)
+                add_field(fields, &buffer[i + pf_ctz64(result)], 1);
+        }
+    }
+
+    for (; i < length; i++)
+        if (buffer[i] == sep)
+            add_field(fields, &buffer[i], 1);
+}
+
+static void split_str(
+    struct fields *fields,
+    const char *buffer,
+    size_t length,
+    const pstring_t *sep
+) {
+    const char *needle = pstrbuf(sep);
+    size_t sublen = pstrlen(sep);
+    size_t count = length - sublen + 1; /* possible separator positions */
+    size_t i = 0, work = 0;
+
+    if (g_impl.size > 0) {
+        char first = needle[0];
+        char last = needle[sublen - 1];
+
+        while (count - i >= g_impl.size && work <= SEARCH_BUDGET(i)) {
+            uint64_t result
+                = g_impl.match_pair(&buffer[i], first, last, sublen - 1);
+
+            for (; result; result &= result - 1) {
+                const char *at = &buffer[i + pf_ctz64(result)];
+                if (at < fields->start)
+                    continue;
+
+                if (0 == memcmp(&at[1], &needle[1], sublen - 2))
+                    add_field(fields, at, sublen);
+                else
+                    work += sublen;
+            }
+
+            i += g_impl.size;
+        }
+    }
+
+    /* the rest is searched one separator at a time, which is linear even
+       when there are many false positives */
+    pstring_t rest;
+    const char *end = &buffer[length];
+    const char *match;
+
+    pstrrange(&rest, NULL, MAX(fields->start, &buffer[i]), end);
+    while ((match = pstrstr(&rest, sep))) {
+        add_field(fields, match, sublen);
+        pstrrange(&rest, NULL, fields->start, end);
+    }
+}
+
+size_t pstrsplit_all(
+    const pstring_t *src, const pstring_t *sep, pstring_t *out, size_t max
+) {
+    if (!src || !sep || pstrlen(sep) == 0)
+        return 0;
+
+    const char *buffer = pstrbuf(src);
+    size_t length = pstrlen(src);
+    struct fields fields = { out, out ? max : 0, 0, buffer };
+
+    if (pstrlen(sep) == 1)
+        split_chr(&fields, buffer, length, pstrbuf(sep)[0]);
+    else if (pstrlen(sep) <= length)
+        split_str(&fields, buffer, length, sep);
+
+    add_field(&fields, &buffer[length], 0);
+    return fields.count;
+}
+
+size_t pstrsplit_set(
+    const pstring_t *src, const pstrset_t *set, pstring_t *out, size_t max
+) {
+    if (!src || !set)
+        return 0;
+
+    const char *buffer = pstrbuf(src);
+    size_t length = pstrlen(src);
+    struct fields fields = { out, out ? max : 0, 0, buffer };
+    size_t i = 0;
+
+    if (g_impl.size > 0 && g_impl.match_class) {
+        uint64_t full = pstr__mask(g_impl.size);
+
+        for (; length - i >= g_impl.size; i += g_impl.size) {
+            uint64_t result = g_impl.match_class(&buffer[i], set) & full;
+            for (; result; result &= result - 1)
+                add_field(&fields, &buffer[i + pf_ctz64(result)], 1);
+        }
+    }
+
+    for (; i < length; i++)
+        if (pstrset_has(set, buffer[i]))
+            add_field(&fields, &buffer[i], 1);
+
+    add_field(&fields, &buffer[length], 0);
+    return fields.count;
+}
+
+static size_t count_matches(
+    const pstring_t *str, const pstring_t *sub, size_t max
+) {
+    pstring_t search;
+    size_t count = 0;
+    char *match;
+
+    pstrslice(&search, str, 0, pstrlen(str));
+    while (count < max && (match = pstrstr(&search, sub))) {
+        pstrrange(&search, NULL, &match[pstrlen(sub)], pstrend(str));
+        count++;
+    }
+
+    return count;
+}
+
+size_t pstrcount(const pstring_t *str, const pstring_t *sub) {
+    if (!str || !sub || pstrlen(sub) == 0)
+        return 0;
+
+    return count_matches(str, sub, SIZE_MAX);
+}
+
+/* Copies `length` bytes from `in` to `out`, replacing the first `count`
+   instances of `sub` with `repl`. `out` may overlap `in` as long as it
+   never gets ahead of the unread input. Returns the end of the output. */
+static char *replace_forward(
+    char *out,
+    char *in,
+    size_t length,
+    const pstring_t *sub,
+    const pstring_t *repl,
+    size_t count
+) {
+    pstring_t search;
+    char *end = &in[length];
+    char *match;
+
+    while (count-- > 0) {
+        pstrrange(&search, NULL, in, end);
+        match = pstrstr(&search, sub);
+
+        memmove(out, in, match - in);
+        out += match - in;
+        memcpy(out, pstrbuf(repl), pstrlen(repl));
+        out += pstrlen(repl);
+        in = &match[pstrlen(sub)];
+    }
+
+    memmove(out, in, end - in);
+    return &out[end - in];
+}
+
 int pstrrepl(
     pstring_t *str, const pstring_t *src, const pstring_t *dst, size_t max
 ) {
-    if (!str || !src || !dst)
+    if (!str || !src || !dst || pstrlen(src) == 0)
         return PSTRING_EINVAL;
 
     if (max == 0)
@@ -998,32 +4393,64 @@ int pstrrepl(
 
     size_t slen = pstrlen(src);
     size_t dlen = pstrlen(dst);
-
-    pstring_t search;
-    pstrslice(&search, str, 0, pstrlen(str));
     size_t length = pstrlen(str);
-    long diff = dlen - slen;
-    char *match;
+    size_t count = count_matches(str, src, max);
+    size_t shift = 0;
 
-    while (max-- > 0) {
-        if (!(match = pstrstr(&search, src)))
-            break;
+    if (count == 0)
+        return PSTRING_OK;
 
-        if (diff > 0 && pstrreserve(str, length + diff))
-            return PSTRING_ENOMEM;
+    if (pstr__writable(str))
+        return PSTRING_ENOMEM;
 
-        if (dlen > 0) {
-            memcpy(&match[dlen], match + slen, pstrend(str) - match - slen);
-            memcpy(match, pstrbuf(dst), dlen);
-        } else {
-            memcpy(match, &match[slen], pstrend(str) - match - slen);
-        }
+    /* when growing, move the contents to the end of the reserved space
+       first so the output can be written front to back without ever
+       overtaking the input */
+    if (dlen > slen) {
+        shift = count * (dlen - slen);
+        if (shift / count != dlen - slen || pstrreserve(str, shift))
+            return PSTRING_ENOMEM;
 
-        length += diff;
-        pstr__setlen(str, length);
-        pstrrange(&search, NULL, &match[dlen], pstrend(str));
+        memmove(pstrslot(str, shift), pstrbuf(str), length);
     }
 
+    char *end = replace_forward(
+        pstrbuf(str), pstrslot(str, shift), length, src, dst, count
+    );
+
+    pstr__setlen(str, end - pstrbuf(str));
+    return PSTRING_OK;
+}
+
+int pstrrepl_into(
+    pstring_t *dst,
+    const pstring_t *src,
+    const pstring_t *from,
+    const pstring_t *to,
+    size_t max
+) {
+    if (!dst || !src || !from || !to || dst == src || pstrlen(from) == 0)
+        return PSTRING_EINVAL;
+
+    if (max == 0)
+        max = SIZE_MAX;
+
+    size_t dlen = pstrlen(to);
+    size_t count = count_matches(src, from, max);
+    size_t length = pstrlen(src) - count * pstrlen(from);
+
+    if (dlen > 0 && count > SIZE_MAX / dlen)
+        return PSTRING_ENOMEM;
+    if (count * dlen > SIZE_MAX - length - pstrlen(dst))
+        return PSTRING_ENOMEM;
+    if (pstrreserve(dst, length + count * dlen))
+        return PSTRING_ENOMEM;
+
+    char *end = replace_forward(
+        pstrend(dst), pstrbuf(src), pstrlen(src), from, to, count
+    );
+
+    pstr__setlen(dst, end - pstrbuf(dst));
     return PSTRING_OK;
 }
 
@@ -1041,6 +4468,9 @@ int pstrreplc(pstring_t *str, char src, char dst, size_t max) {
     if (!str || src == dst)
         return PSTRING_EINVAL;
 
+    if (pstr__writable(str))
+        return PSTRING_ENOMEM;
+
     pstring_t search;
     char *match = pstrbuf(str);
 
@@ -1103,6 +4533,19 @@ int pstrstrip(pstring_t *str, const char *chars) {
     return pstrcut(str, left - pstrbuf(str), (right + 1) - pstrbuf(str));
 }
 
+int pstrstrip_set(pstring_t *str, const pstrset_t *set) {
+    if (!str || !set)
+        return PSTRING_EINVAL;
+
+    size_t length = pstrlen(str);
+    size_t left = find_class(pstrbuf(str), length, set, 0);
+    if (left == length)
+        return pstrcut(str, 0, 0);
+
+    size_t right = rfind_class(pstrbuf(str), length, set, 0);
+    return pstrcut(str, left, right + 1);
+}
+
 static int count_indent(const pstring_t *str, int max, int tab, int *out) {
     const char *chr;
     int length = 0;
@@ -1126,6 +4569,9 @@ int pstrdedent(pstring_t *str, int count, int tab) {
     if (!str)
         return PSTRING_EINVAL;
 
+    if (pstr__writable(str))
+        return PSTRING_ENOMEM;
+
     if (count <= 0)
         count = INT_MAX;
     if (tab <= 0)
@@ -1162,6 +4608,9 @@ int pstrindent(pstring_t *str, int count, int tab) {
     if (!str)
         return PSTRING_EINVAL;
 
+    if (pstr__writable(str))
+        return PSTRING_ENOMEM;
+
     if (count < 0)
         count = 0;
     if (tab <= 0)
@@ -1233,68 +4682,206 @@ int pstrftime(pstring_t *dst, const char *fmt, struct tm *src) {
     return written > 0 ? PSTRING_OK : PSTRING_ENOMEM;
 }
 
-static int distance(const pstring_t *left, const pstring_t *right, int **rows) {
-    const char *lbuf = pstrbuf(left);
-    const char *rbuf = pstrbuf(right);
-
-#define MIN3(a, b, c) (PF_MIN(PF_MIN((a), (b)), (c)))
-    int *transpose = rows[0];
-    int *prev = rows[1];
-    int *curr = rows[2];
-
-    for (int j = 0; j <= pstrlen(right); j++)
-        prev[j] = j;
-
-    for (int i = 1; i <= pstrlen(left); i++) {
-        curr[0] = i;
+/* Checks if a distance of `score`, after `left` more columns, has to end up
+   above `max`, since every column can lower it by at most one. */
+#define DISTANCE_EXCEEDS(score, max, left) \
+    ((score) > (max) && (score) - (max) > (left))
+
+/* Words of state used by `distance_blocks`, which is kept on the stack for
+   patterns of up to `DISTANCE_STACK_BLOCKS` blocks of 64 characters. */
+#define DISTANCE_STATE(blocks) ((256 + 3) * (blocks))
+#define DISTANCE_STACK_BLOCKS 4
+
+/* Hyyrö's bit-parallel optimal string alignment distance for patterns of
+   at most 64 characters, or plain Levenshtein if `transpose` is zero.
+   Bit `i` of `vp` and `vn` holds the positive and negative vertical delta
+   at row `i` of the current column, and `d0` marks rows whose diagonal
+   delta is zero. */
+static size_t distance_word(
+    const unsigned char *pattern,
+    size_t m,
+    const unsigned char *text,
+    size_t n,
+    size_t max,
+    uint64_t transpose
+) {
+    uint64_t peq[256] = { 0 };
+    uint64_t vp = UINT64_MAX, vn = 0, d0 = 0, prev = 0;
+    uint64_t high = (uint64_t)1 << (m - 1);
+    size_t score = m;
+
+    for (size_t i = 0; i < m; i++)
+        peq[pattern[i]] |= (uint64_t)1 << i;
+
+    for (size_t j = 0; j < n; j++) {
+        uint64_t pm = peq[text[j]];
+        uint64_t tr = ((~d0 & pm) << 1) & prev & transpose;
+        d0 = (((pm & vp) + vp) ^ vp) | pm | vn | tr;
+
+        uint64_t hp = vn | ~(d0 | vp);
+        uint64_t hn = d0 & vp;
+        score += (hp & high) != 0;
+        score -= (hn & high) != 0;
+
+        if (DISTANCE_EXCEEDS(score, max, n - j - 1))
+            return max + 1;
+
+        hp = (hp << 1) | 1;
+        hn <<= 1;
+        vp = hn | ~(d0 | hp);
+        vn = hp & d0;
+        prev = pm;
+    }
 
-        for (int j = 1; j <= pstrlen(right); j++) {
-            int cost = (lbuf[i - 1] == rbuf[j - 1]) ? 0 : 1;
+    return score;
+}
 
-            curr[j] = MIN3(curr[j - 1] + 1, prev[j] + 1, prev[j - 1] + cost);
+/* Blocked variant of `distance_word` for longer patterns, which passes the
+   horizontal delta and the transposition bit from each block of 64 rows
+   to the one below it. */
+static size_t distance_blocks(
+    const unsigned char *pattern,
+    size_t m,
+    const unsigned char *text,
+    size_t n,
+    size_t max,
+    uint64_t transpose,
+    uint64_t *state
+) {
+    size_t blocks = (m + 63) / 64;
+    uint64_t *peq = state;
+    uint64_t *vp = &state[256 * blocks];
+    uint64_t *vn = &vp[blocks];
+    uint64_t *d0 = &vn[blocks];
+    uint64_t high = (uint64_t)1 << ((m - 1) % 64);
+    size_t score = m;
+
+    for (size_t i = 0; i < m; i++)
+        peq[pattern[i] * blocks + i / 64] |= (uint64_t)1 << (i % 64);
+
+    for (size_t b = 0; b < blocks; b++) {
+        vp[b] = UINT64_MAX;
+        vn[b] = d0[b] = 0;
+    }
 
-            if (i > 1 && j > 1 && lbuf[i - 1] == rbuf[j - 2]
-                && lbuf[i - 2] == rbuf[j - 1]) {
-                curr[j] = MIN(curr[j], transpose[j - 2] + cost);
-            }
+    for (size_t j = 0; j < n; j++) {
+        const uint64_t *pm = &peq[text[j] * blocks];
+        const uint64_t *prev = j > 0 ? &peq[text[j - 1] * blocks] : NULL;
+        uint64_t carry = 0;
+        int hin = 1, hout = 0;
+
+        for (size_t b = 0; b < blocks; b++) {
+            uint64_t eq = pm[b];
+            uint64_t moved = ~d0[b] & eq;
+            uint64_t tr = 0;
+            if (prev)
+                tr = ((moved << 1) | carry) & prev[b] & transpose;
+            carry = moved >> 63;
+
+            uint64_t xv = eq | vn[b] | tr;
+            if (hin < 0)
+                eq |= 1;
+
+            uint64_t xh = (((eq & vp[b]) + vp[b]) ^ vp[b]) | eq | tr;
+            uint64_t hp = vn[b] | ~(xh | vp[b]);
+            uint64_t hn = vp[b] & xh;
+            uint64_t bit = b == blocks - 1 ? high : (uint64_t)1 << 63;
+
+            hout = (hp & bit) ? 1 : (hn & bit) ? -1 : 0;
+            hp <<= 1;
+            hn <<= 1;
+            if (hin < 0)
+                hn |= 1;
+            else if (hin > 0)
+                hp |= 1;
+
+            d0[b] = xh | xv;
+            vp[b] = hn | ~(xv | hp);
+            vn[b] = hp & xv;
+            hin = hout;
         }
 
-        int *tmp = transpose;
-        transpose = prev;
-        prev = curr;
-        curr = tmp;
+        score += hout;
+        if (DISTANCE_EXCEEDS(score, max, n - j - 1))
+            return max + 1;
     }
 
-    return prev[pstrlen(right)];
+    return score;
 }
 
-int pstrdistance(const pstring_t *left, const pstring_t *right) {
+int pstr__distance(
+    const pstring_t *left, const pstring_t *right, size_t max, int transpose
+) {
     if (!left || !right)
         return PSTRING_EINVAL;
 
-    size_t mlen = PF_MAX(pstrlen(left), pstrlen(right)) + 1;
+    const unsigned char *pattern = (const unsigned char *)pstrbuf(left);
+    const unsigned char *text = (const unsigned char *)pstrbuf(right);
+    size_t m = pstrlen(left), n = pstrlen(right);
+
+    if (max > INT_MAX - 1)
+        max = INT_MAX - 1;
+
+    /* the distance is symmetric, so the shorter string becomes the
+       pattern, which needs fewer machine words */
+    if (m > n) {
+        const unsigned char *tmp = pattern;
+        pattern = text;
+        text = tmp;
+        m = pstrlen(right);
+        n = pstrlen(left);
+    }
 
-    if (pstrlen(left) == 0 || pstrlen(right) == 0)
-        return mlen - 1;
+    while (m > 0 && *pattern == *text) {
+        pattern++;
+        text++;
+        m--;
+        n--;
+    }
+    while (m > 0 && pattern[m - 1] == text[n - 1]) {
+        m--;
+        n--;
+    }
 
-#define PSTRDISTANCE_BUF_SIZE 1024
-    int _buffer[3 * PSTRDISTANCE_BUF_SIZE];
-    int *buffer = _buffer;
+    if (n - m > max)
+        return max + 1;
+    if (m == 0)
+        return n;
+    uint64_t mask = transpose ? UINT64_MAX : 0;
+    if (m <= 64)
+        return distance_word(pattern, m, text, n, max, mask);
+
+    size_t blocks = (m + 63) / 64;
+    size_t size = DISTANCE_STATE(blocks) * sizeof(uint64_t);
+    if (blocks <= DISTANCE_STACK_BLOCKS) {
+        uint64_t state[DISTANCE_STATE(DISTANCE_STACK_BLOCKS)];
+        memset(state, 0, size);
+        return distance_blocks(pattern, m, text, n, max, mask, state);
+    }
 
-    if (mlen > PSTRDISTANCE_BUF_SIZE)
-        buffer = allocate(&standard_allocator, mlen * sizeof(int));
+    allocator_t *allocator = pstrallocator(left);
+    if (!allocator)
+        allocator = &standard_allocator;
 
-    if (buffer == NULL)
+    uint64_t *state = zallocate(allocator, size);
+    if (!state)
         return PSTRING_ENOMEM;
 
-    int *rows[3] = { buffer, &buffer[mlen], &buffer[2 * mlen] };
-    int result = distance(left, right, rows);
-
-    if (mlen > PSTRDISTANCE_BUF_SIZE)
-        deallocate(&standard_allocator, buffer, mlen * sizeof(int));
+    size_t result = distance_blocks(pattern, m, text, n, max, mask, state);
+    deallocate(allocator, state, size);
     return result;
 }
 
+int pstrdistance_bounded(
+    const pstring_t *left, const pstring_t *right, size_t max
+) {
+    return pstr__distance(left, right, max, 1);
+}
+
+int pstrdistance(const pstring_t *left, const pstring_t *right) {
+    return pstr__distance(left, right, SIZE_MAX, 1);
+}
+
 #ifdef PSTRING_USE_XXHASH
 
     #include <xxhash.h>
@@ -1303,27 +4890,290 @@ size_t pstrhash(const pstring_t *str) {
     return XXH3_64bits(pstrbuf(str), pstrlen(str));
 }
 
+size_t pstrhash_seeded(const pstring_t *str, size_t seed) {
+    return XXH3_64bits_withSeed(pstrbuf(str), pstrlen(str), seed);
+}
+
+void pstrhash_many_seeded(
+    const pstring_t *strs, size_t count, size_t seed, size_t *out
+) {
+    if (!strs || !out)
+        return;
+
+    for (size_t i = 0; i < count; i++)
+        out[i] = XXH3_64bits_withSeed(
+            pstrbuf(&strs[i]), pstrlen(&strs[i]), seed
+        );
+}
+
+int pstrhash_init(pstrhash_state_t *state, size_t seed) {
+    if (!state)
+        return PSTRING_EINVAL;
+
+    state->xxh3 = XXH3_createState();
+    if (!state->xxh3)
+        return PSTRING_ENOMEM;
+
+    XXH3_64bits_reset_withSeed(state->xxh3, seed);
+    return PSTRING_OK;
+}
+
+int pstrhash_updates(
+    pstrhash_state_t *state, const char *data, size_t length
+) {
+    if (!state || !state->xxh3 || (!data && length > 0))
+        return PSTRING_EINVAL;
+
+    XXH3_64bits_update(state->xxh3, data, length);
+    return PSTRING_OK;
+}
+
+size_t pstrhash_final(pstrhash_state_t *state) {
+    if (!state || !state->xxh3)
+        return 0;
+
+    size_t hash = XXH3_64bits_digest(state->xxh3);
+    XXH3_freeState(state->xxh3);
+    state->xxh3 = NULL;
+    return hash;
+}
+
 #else
 
-size_t pstrhash(const pstring_t *str) {
-    #if SIZE_MAX == 0xFFFFFFFFFFFFFFFFull
-        #define HASH_FNV_PRIME 0x00000100000001b3ull
-        #define HASH_FNV_OFFSET 0xcbf29ce484222325ull
-    #elif SIZE_MAX == 0xFFFFFFFFull
-        #define HASH_FNV_PRIME 0x01000193ull
-        #define HASH_FNV_OFFSET 0x811c9dc5ull
+/* wyhash (final version 4) by Wang Yi, released into the public domain,
+   reading the input 8 bytes at a time with one 128-bit multiply per 16 */
+static const uint64_t g_wyp[4] = {
+    0x2d358dccaa6c78a5ull,
+    0x8bb84b93962eacc9ull,
+    0x4b33a62ed433d4a3ull,
+    0x4d5a2da51de1aa47ull,
+};
+
+static inline void wy_mum(uint64_t *a, uint64_t *b) {
+    #ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+    #else
+    uint64_t ha = *a >> 32, hb = *b >> 32;
+    uint64_t la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32), lo = t + (rm1 << 32);
+    uint64_t carry = (t < rl) + (lo < t);
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
     #endif
+}
 
-    size_t hash = HASH_FNV_OFFSET;
-    size_t length = pstrlen(str);
-    const char *bytes = pstrbuf(str);
+static inline uint64_t wy_mix(uint64_t a, uint64_t b) {
+    wy_mum(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t wy_read8(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    #if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+    #endif
+    return v;
+}
+
+static inline uint64_t wy_read4(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    #if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+    #endif
+    return v;
+}
+
+static inline uint64_t wy_final(
+    uint64_t a, uint64_t b, uint64_t seed, uint64_t length
+) {
+    a ^= g_wyp[1];
+    b ^= seed;
+    wy_mum(&a, &b);
+    return wy_mix(a ^ g_wyp[0] ^ length, b ^ g_wyp[1]);
+}
 
-    while (length--) {
-        hash ^= (size_t)(unsigned char)*bytes++;
-        hash *= HASH_FNV_PRIME;
+/* Hashes inputs of up to 16 bytes. */
+static inline uint64_t wy_short(
+    const uint8_t *p, size_t length, uint64_t seed
+) {
+    uint64_t a = 0, b = 0;
+
+    if (length >= 4) {
+        size_t mid = (length >> 3) << 2;
+        a = (wy_read4(p) << 32) | wy_read4(p + mid);
+        b = (wy_read4(p + length - 4) << 32) | wy_read4(p + length - 4 - mid);
+    } else if (length > 0) {
+        a = ((uint64_t)p[0] << 16) | ((uint64_t)p[length >> 1] << 8)
+            | p[length - 1];
     }
 
-    return hash;
+    return wy_final(a, b, seed, length);
+}
+
+/* Mixes a block of 48 bytes into three independent lanes. */
+static inline void wy_block(const uint8_t *p, uint64_t seeds[3]) {
+    seeds[0] = wy_mix(wy_read8(p) ^ g_wyp[1], wy_read8(p + 8) ^ seeds[0]);
+    seeds[1] = wy_mix(wy_read8(p + 16) ^ g_wyp[2], wy_read8(p + 24) ^ seeds[1]);
+    seeds[2] = wy_mix(wy_read8(p + 32) ^ g_wyp[3], wy_read8(p + 40) ^ seeds[2]);
+}
+
+/* Hashes the last 1 to 48 bytes of an input longer than 16 bytes, which
+   reads up to 15 bytes before `p` when there are fewer than 16 left. */
+static inline uint64_t wy_tail(
+    const uint8_t *p, size_t i, uint64_t seed, uint64_t length
+) {
+    while (i > 16) {
+        seed = wy_mix(wy_read8(p) ^ g_wyp[1], wy_read8(p + 8) ^ seed);
+        i -= 16;
+        p += 16;
+    }
+
+    return wy_final(wy_read8(p + i - 16), wy_read8(p + i - 8), seed, length);
+}
+
+static inline uint64_t wy_seed(uint64_t seed) {
+    return seed ^ wy_mix(seed ^ g_wyp[0], g_wyp[1]);
+}
+
+/* Hashes any input with a seed already mixed by `wy_seed`. */
+static inline uint64_t wy_mixed(
+    const uint8_t *p, size_t length, uint64_t seed
+) {
+    if (length <= 16)
+        return wy_short(p, length, seed);
+
+    uint64_t seeds[3] = { seed, seed, seed };
+    size_t i = length;
+
+    if (i > 48) {
+        do {
+            wy_block(p, seeds);
+            p += 48;
+            i -= 48;
+        } while (i > 48);
+        seeds[0] ^= seeds[1] ^ seeds[2];
+    }
+
+    return wy_tail(p, i, seeds[0], length);
+}
+
+static uint64_t wyhash(const uint8_t *p, size_t length, uint64_t seed) {
+    return wy_mixed(p, length, wy_seed(seed));
+}
+
+size_t pstrhash(const pstring_t *str) {
+    return (size_t)wyhash((const uint8_t *)pstrbuf(str), pstrlen(str), 0);
+}
+
+size_t pstrhash_seeded(const pstring_t *str, size_t seed) {
+    return (size_t)wyhash((const uint8_t *)pstrbuf(str), pstrlen(str), seed);
+}
+
+void pstrhash_many_seeded(
+    const pstring_t *strs, size_t count, size_t seed, size_t *out
+) {
+    if (!strs || !out)
+        return;
+
+    /* the seed is mixed once for all strings, and the strings' independent
+       multiply chains are overlapped by the CPU */
+    uint64_t mixed = wy_seed(seed);
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *p = (const uint8_t *)pstrbuf(&strs[i]);
+        out[i] = (size_t)wy_mixed(p, pstrlen(&strs[i]), mixed);
+    }
+}
+
+/* The state hashes a block of 48 bytes only once more input follows it, as
+   `wyhash` does, keeping the rest after the last 16 bytes already hashed. */
+#define HASH_BLOCK 48
+#define HASH_HISTORY 16
+
+static size_t hash_pending(uint64_t length) {
+    return length <= HASH_BLOCK ? length : (length - 1) % HASH_BLOCK + 1;
+}
+
+int pstrhash_init(pstrhash_state_t *state, size_t seed) {
+    if (!state)
+        return PSTRING_EINVAL;
+
+    uint64_t mixed = wy_seed(seed);
+    state->seeds[0] = state->seeds[1] = state->seeds[2] = mixed;
+    state->length = 0;
+    state->xxh3 = NULL;
+    return PSTRING_OK;
+}
+
+int pstrhash_updates(
+    pstrhash_state_t *state, const char *data, size_t length
+) {
+    if (!state || (!data && length > 0))
+        return PSTRING_EINVAL;
+
+    const uint8_t *p = (const uint8_t *)data;
+    uint8_t *pending = &state->buffer[HASH_HISTORY];
+    size_t count = hash_pending(state->length);
+
+    state->length += length;
+    while (length > 0) {
+        if (count == HASH_BLOCK) {
+            wy_block(pending, state->seeds);
+            memcpy(state->buffer, &pending[HASH_BLOCK - 16], HASH_HISTORY);
+            count = 0;
+        }
+
+        /* whole blocks are hashed straight from `data` */
+        if (count == 0) {
+            while (length > HASH_BLOCK) {
+                wy_block(p, state->seeds);
+                memcpy(state->buffer, &p[HASH_BLOCK - 16], HASH_HISTORY);
+                p += HASH_BLOCK;
+                length -= HASH_BLOCK;
+            }
+        }
+
+        size_t take = MIN(HASH_BLOCK - count, length);
+        memcpy(&pending[count], p, take);
+        count += take;
+        p += take;
+        length -= take;
+    }
+
+    return PSTRING_OK;
+}
+
+size_t pstrhash_final(pstrhash_state_t *state) {
+    if (!state)
+        return 0;
+
+    const uint8_t *pending = &state->buffer[HASH_HISTORY];
+    uint64_t seed = state->seeds[0];
+
+    if (state->length <= 16)
+        return (size_t)wy_short(pending, state->length, seed);
+    if (state->length > HASH_BLOCK)
+        seed ^= state->seeds[1] ^ state->seeds[2];
+
+    return (size_t)wy_tail(
+        pending, hash_pending(state->length), seed, state->length
+    );
 }
 
 #endif
+
+void pstrhash_many(const pstring_t *strs, size_t count, size_t *out) {
+    pstrhash_many_seeded(strs, count, 0, out);
+}
+
+int pstrhash_update(pstrhash_state_t *state, const pstring_t *data) {
+    if (!data)
+        return PSTRING_EINVAL;
+
+    return pstrhash_updates(state, pstrbuf(data), pstrlen(data));
+}
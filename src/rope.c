@@ -0,0 +1,465 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <pstring/pstring.h>
+#include <pstring/rope.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include "allocator_std.h"
+
+/* Chunks are stored in an implicit treap: nodes are ordered by position and
+   every node has a random priority not smaller than the priorities of its
+   children, which keeps the expected depth logarithmic. Every node knows the
+   number of bytes in its subtree, so positions are found by descending from
+   the root. Small edits are done inside a single chunk, larger ones split
+   the tree around the edited range and merge the parts back together. */
+#define CHUNK_SIZE 2048
+#define NODE_SIZE (sizeof(struct pstrrope_node) + CHUNK_SIZE)
+
+struct pstrrope_node {
+    struct pstrrope_node *left;
+    struct pstrrope_node *right;
+    size_t size;       /* bytes in the subtree */
+    unsigned priority; /* never smaller than the priority of the children */
+    unsigned length;   /* bytes in this chunk */
+    char data[];
+};
+
+typedef struct pstrrope_node node_t;
+
+static size_t size_of(const node_t *node) {
+    return node ? node->size : 0;
+}
+
+static void update(node_t *node) {
+    node->size = size_of(node->left) + node->length + size_of(node->right);
+}
+
+static allocator_t *allocator_of(pstrrope_t *rope) {
+    if (!rope->allocator)
+        rope->allocator = &standard_allocator;
+    return rope->allocator;
+}
+
+static node_t *new_node(pstrrope_t *rope, const char *data, size_t length) {
+    node_t *node = allocate(allocator_of(rope), NODE_SIZE);
+    if (!node)
+        return NULL;
+
+    /* xorshift32, seeded from the address of the rope */
+    unsigned seed = rope->seed ? rope->seed : (unsigned)(uintptr_t)rope | 1;
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    rope->seed = seed;
+
+    node->left = node->right = NULL;
+    node->priority = seed;
+    node->length = (unsigned)length;
+    node->size = length;
+    memcpy(node->data, data, length);
+    return node;
+}
+
+static void free_nodes(allocator_t *allocator, node_t *node) {
+    while (node) {
+        node_t *right = node->right;
+        free_nodes(allocator, node->left);
+        deallocate(allocator, node, NODE_SIZE);
+        node = right;
+    }
+}
+
+static node_t *merge(node_t *left, node_t *right) {
+    if (!left) {
+        return right;
+    } else if (!right) {
+        return left;
+    } else if (left->priority >= right->priority) {
+        left->right = merge(left->right, right);
+        update(left);
+        return left;
+    } else {
+        right->left = merge(left, right->left);
+        update(right);
+        return right;
+    }
+}
+
+/* Merges two trees like `merge`, first moving the first chunk of `right`
+   into the last chunk of `left` if both fit in one, so repeated edits and
+   concatenations don't leave behind a trail of small chunks. */
+static node_t *join(allocator_t *allocator, node_t *left, node_t *right) {
+    if (!left || !right)
+        return merge(left, right);
+
+    node_t *last = left;
+    while (last->right)
+        last = last->right;
+
+    node_t **link = &right;
+    while ((*link)->left)
+        link = &(*link)->left;
+
+    node_t *first = *link;
+    size_t n = first->length;
+    if (last->length + n > CHUNK_SIZE)
+        return merge(left, right);
+
+    memcpy(&last->data[last->length], first->data, n);
+    last->length += (unsigned)n;
+    for (node_t *node = left; node; node = node->right)
+        node->size += n;
+
+    /* the right child of the first chunk takes its place, which keeps the
+       order of priorities */
+    for (node_t *node = right; node != first; node = node->left)
+        node->size -= n;
+    *link = first->right;
+    deallocate(allocator, first, NODE_SIZE);
+
+    return merge(left, right);
+}
+
+/* Splits the tree into the bytes before `at` and the rest. When `at` falls
+   inside a chunk, its tail is moved into `*spare`, which is then consumed,
+   so splitting never fails halfway. */
+static void split(
+    node_t *node, size_t at, node_t **spare, node_t **left, node_t **right
+) {
+    if (!node) {
+        *left = *right = NULL;
+        return;
+    }
+    size_t before = size_of(node->left);
+    if (at <= before) {
+        split(node->left, at, spare, left, &node->left);
+        update(node);
+        *right = node;
+    } else if (at >= before + node->length) {
+        split(
+            node->right, at - before - node->length, spare, &node->right, right
+        );
+        update(node);
+        *left = node;
+    } else {
+        /* the tail takes the place of the node in the right part, with the
+           same priority, so the order of priorities is kept */
+        size_t offset = at - before;
+        node_t *tail = *spare;
+        *spare = NULL;
+        tail->length = node->length - (unsigned)offset;
+        memcpy(tail->data, &node->data[offset], tail->length);
+        tail->priority = node->priority;
+        tail->left = NULL;
+        tail->right = node->right;
+        update(tail);
+
+        node->length = (unsigned)offset;
+        node->right = NULL;
+        update(node);
+        *left = node;
+        *right = tail;
+    }
+}
+
+/* Inserts into the chunk containing `at` if it has enough space and `src`
+   does not point into it. */
+static int insert_inplace(node_t *node, size_t at, const char *src, size_t n) {
+    if (!node)
+        return 0;
+
+    size_t before = size_of(node->left);
+    int done;
+    if (at < before || (at == before && node->left)) {
+        done = insert_inplace(node->left, at, src, n);
+    } else if (at <= before + node->length) {
+        size_t offset = at - before;
+        done = node->length + n <= CHUNK_SIZE
+            && (src >= &node->data[CHUNK_SIZE] || &src[n] <= node->data);
+        if (done) {
+            memmove(
+                &node->data[offset + n],
+                &node->data[offset],
+                node->length - offset
+            );
+            memcpy(&node->data[offset], src, n);
+            node->length += (unsigned)n;
+        }
+    } else {
+        done = insert_inplace(node->right, at - before - node->length, src, n);
+    }
+    if (done)
+        node->size += n;
+    return done;
+}
+
+/* Removes the range from the chunk containing it, if it's not spread over
+   multiple chunks. Chunks left empty are removed from the tree, others have
+   their position and their remaining length stored in `*start` and `*left`,
+   which are left untouched otherwise. */
+static int remove_inplace(
+    allocator_t *allocator,
+    node_t **link,
+    size_t from,
+    size_t n,
+    size_t *start,
+    size_t *left
+) {
+    node_t *node = *link;
+    size_t before = size_of(node->left);
+    int done;
+    if (from < before) {
+        done = remove_inplace(allocator, &node->left, from, n, start, left);
+    } else if (from < before + node->length) {
+        size_t offset = from - before;
+        done = offset + n <= node->length;
+        if (done && n == node->length) {
+            *link = merge(node->left, node->right);
+            deallocate(allocator, node, NODE_SIZE);
+            return done;
+        } else if (done) {
+            memmove(
+                &node->data[offset],
+                &node->data[offset + n],
+                node->length - offset - n
+            );
+            node->length -= (unsigned)n;
+            *start = before;
+            *left = node->length;
+        }
+    } else {
+        done = remove_inplace(
+            allocator,
+            &node->right,
+            from - before - node->length,
+            n,
+            start,
+            left
+        );
+        *start += before + node->length;
+    }
+    if (done)
+        node->size -= n;
+    return done;
+}
+
+/* Joins the chunk between `from` and `to` with the chunks next to it, if
+   they fit in one, so repeated small removals don't leave behind a trail of
+   small chunks. The tree is split only at the edges of chunks, which never
+   uses the spare chunk. */
+static void merge_around(
+    allocator_t *allocator, pstrrope_t *rope, size_t from, size_t to
+) {
+    node_t *spare = NULL, *left, *right;
+    split(rope->root, to, &spare, &left, &right);
+    rope->root = join(allocator, left, right);
+    split(rope->root, from, &spare, &left, &right);
+    rope->root = join(allocator, left, right);
+}
+
+static const node_t *find(const node_t *node, size_t *at) {
+    while (node) {
+        size_t before = size_of(node->left);
+        if (*at < before) {
+            node = node->left;
+        } else if (*at < before + node->length) {
+            *at -= before;
+            return node;
+        } else {
+            *at -= before + node->length;
+            node = node->right;
+        }
+    }
+    return NULL;
+}
+
+int pstrrope_new(
+    pstrrope_t *out, const pstring_t *str, allocator_t *allocator
+) {
+    if (!out)
+        return PSTRING_EINVAL;
+
+    out->root = NULL;
+    out->allocator = allocator ? allocator : &standard_allocator;
+    out->seed = 0;
+    if (!str)
+        return PSTRING_OK;
+
+    int res = pstrrope_insert(out, 0, str);
+    if (res != PSTRING_OK)
+        pstrrope_free(out);
+
+    return res;
+}
+
+void pstrrope_free(pstrrope_t *rope) {
+    if (rope && rope->root) {
+        free_nodes(allocator_of(rope), rope->root);
+        rope->root = NULL;
+    }
+}
+
+size_t pstrrope_len(const pstrrope_t *rope) {
+    return rope ? size_of(rope->root) : 0;
+}
+
+char pstrrope_get(const pstrrope_t *rope, size_t i) {
+    if (!rope)
+        return '\0';
+
+    const node_t *node = find(rope->root, &i);
+    return node ? node->data[i] : '\0';
+}
+
+int pstrrope_insert(pstrrope_t *rope, size_t at, const pstring_t *src) {
+    if (!rope || !src || at > size_of(rope->root))
+        return PSTRING_EINVAL;
+
+    const char *buf = pstrbuf(src);
+    size_t length = pstrlen(src);
+    if (!length || insert_inplace(rope->root, at, buf, length))
+        return PSTRING_OK;
+
+    /* `src` may point into the rope, so all chunks are built before the
+       tree is modified */
+    allocator_t *allocator = allocator_of(rope);
+    node_t *spare = new_node(rope, "", 0);
+    node_t *middle = NULL;
+    if (!spare)
+        return PSTRING_ENOMEM;
+
+    for (size_t i = 0; i < length; i += CHUNK_SIZE) {
+        size_t n = length - i < CHUNK_SIZE ? length - i : CHUNK_SIZE;
+        node_t *node = new_node(rope, &buf[i], n);
+        if (!node) {
+            free_nodes(allocator, middle);
+            deallocate(allocator, spare, NODE_SIZE);
+            return PSTRING_ENOMEM;
+        }
+        middle = merge(middle, node);
+    }
+
+    node_t *left, *right;
+    split(rope->root, at, &spare, &left, &right);
+    rope->root = join(allocator, join(allocator, left, middle), right);
+    if (spare)
+        deallocate(allocator, spare, NODE_SIZE);
+
+    return PSTRING_OK;
+}
+
+int pstrrope_remove(pstrrope_t *rope, size_t from, size_t to) {
+    if (!rope || from > to || to > size_of(rope->root))
+        return PSTRING_EINVAL;
+
+    allocator_t *allocator = allocator_of(rope);
+    size_t start = 0, left = 0, n = to - from;
+    if (n == 0)
+        return PSTRING_OK;
+    if (remove_inplace(allocator, &rope->root, from, n, &start, &left)) {
+        if (left > 0 && left < CHUNK_SIZE / 2)
+            merge_around(allocator, rope, start, start + left);
+        return PSTRING_OK;
+    }
+
+    int res = PSTRING_ENOMEM;
+    node_t *spares[2] = { new_node(rope, "", 0), new_node(rope, "", 0) };
+    if (spares[0] && spares[1]) {
+        node_t *left, *middle, *right;
+        split(rope->root, to, &spares[0], &left, &right);
+        split(left, from, &spares[1], &left, &middle);
+        free_nodes(allocator, middle);
+        rope->root = join(allocator, left, right);
+        res = PSTRING_OK;
+    }
+
+    for (int i = 0; i < 2; i++)
+        if (spares[i])
+            deallocate(allocator, spares[i], NODE_SIZE);
+
+    return res;
+}
+
+int pstrrope_split(pstrrope_t *rope, size_t at, pstrrope_t *out) {
+    if (!rope || !out || rope == out || at > size_of(rope->root))
+        return PSTRING_EINVAL;
+
+    allocator_t *allocator = allocator_of(rope);
+    node_t *spare = new_node(rope, "", 0);
+    if (!spare)
+        return PSTRING_ENOMEM;
+
+    out->allocator = allocator;
+    out->seed = 0;
+    split(rope->root, at, &spare, &rope->root, &out->root);
+    if (spare)
+        deallocate(allocator, spare, NODE_SIZE);
+
+    return PSTRING_OK;
+}
+
+int pstrrope_concat(pstrrope_t *dst, pstrrope_t *src) {
+    if (!dst || !src || dst == src)
+        return PSTRING_EINVAL;
+    if (!src->root)
+        return PSTRING_OK;
+    if (allocator_of(dst) != allocator_of(src))
+        return PSTRING_EINVAL;
+
+    dst->root = join(allocator_of(dst), dst->root, src->root);
+    src->root = NULL;
+    return PSTRING_OK;
+}
+
+int pstrrope_chunk(const pstrrope_t *rope, size_t at, pstring_t *out) {
+    if (!rope || !out)
+        return PSTRING_EINVAL;
+
+    const node_t *node = find(rope->root, &at);
+    if (!node)
+        return PSTRING_ENOENT;
+
+    return pstrrange(out, NULL, &node->data[at], &node->data[node->length]);
+}
+
+int pstrrope_substr(
+    const pstrrope_t *rope, pstring_t *dst, size_t from, size_t to
+) {
+    if (!rope || !dst || from > to || to > size_of(rope->root))
+        return PSTRING_EINVAL;
+
+    int res = pstrreserve(dst, to - from);
+    pstring_t chunk;
+    while (res == PSTRING_OK && from < to) {
+        pstrrope_chunk(rope, from, &chunk);
+        if (pstrlen(&chunk) > to - from)
+            pstrslice(&chunk, &chunk, 0, to - from);
+        from += pstrlen(&chunk);
+        res = pstrcat(dst, &chunk);
+    }
+    return res;
+}
+
+int pstrrope_flatten(const pstrrope_t *rope, pstring_t *dst) {
+    return pstrrope_substr(rope, dst, 0, pstrrope_len(rope));
+}
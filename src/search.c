@@ -0,0 +1,514 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <pstring/pstring.h>
+#include <pstring/search.h>
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "allocator_std.h"
+
+#define NO_OUTPUT UINT32_MAX
+#define ROOT 0
+
+/* searches starting from the root jump to the next byte that can begin
+   a match, as long as there are few enough distinct first bytes */
+#define PREFILTER_SIZE 64
+
+struct output {
+    uint32_t id;     /* needle ending in this state */
+    uint32_t length; /* length of that needle */
+    uint32_t link;   /* closest suffix state with an output */
+};
+
+/* Aho-Corasick automaton, stored as a complete transition table over
+   classes of bytes that appear in the needles. */
+typedef struct pstrsearch_t {
+    allocator_t *allocator;
+    size_t count;
+    size_t maxlen;
+
+    size_t states;
+    size_t capacity;
+    size_t classes;
+    uint32_t *next;
+    struct output *out;
+
+    uint8_t classmap[256];
+    pstrset_t prefilter;
+    int filtered;
+    pstring_t needle;
+} pstrsearch_t;
+
+static int grow_states(pstrsearch_t *search) {
+    size_t capacity = search->capacity ? search->capacity * 2 : 64;
+    size_t old = search->capacity;
+
+    uint32_t *next = reallocate(
+        search->allocator,
+        search->next,
+        old * search->classes * sizeof(uint32_t),
+        capacity * search->classes * sizeof(uint32_t)
+    );
+
+    if (!next)
+        return PSTRING_ENOMEM;
+    search->next = next;
+
+    struct output *out = reallocate(
+        search->allocator,
+        search->out,
+        old * sizeof(struct output),
+        capacity * sizeof(struct output)
+    );
+
+    if (!out)
+        return PSTRING_ENOMEM;
+    search->out = out;
+
+    search->capacity = capacity;
+    return PSTRING_OK;
+}
+
+static int add_state(pstrsearch_t *search, uint32_t *out) {
+    if (search->states >= UINT32_MAX)
+        return PSTRING_ENOMEM;
+
+    if (search->states == search->capacity && grow_states(search))
+        return PSTRING_ENOMEM;
+
+    size_t state = search->states++;
+    memset(
+        &search->next[state * search->classes],
+        0,
+        search->classes * sizeof(uint32_t)
+    );
+
+    search->out[state].id = NO_OUTPUT;
+    search->out[state].length = 0;
+    search->out[state].link = ROOT;
+    *out = state;
+    return PSTRING_OK;
+}
+
+static void build_classes(
+    pstrsearch_t *search, const pstring_t *needles, size_t count
+) {
+    memset(search->classmap, 0, sizeof(search->classmap));
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *buffer = (const uint8_t *)pstrbuf(&needles[i]);
+
+        for (size_t j = 0; j < pstrlen(&needles[i]); j++)
+            search->classmap[buffer[j]] = 1;
+    }
+
+    /* class 0 is shared by all bytes that don't appear in any needle */
+    search->classes = 1;
+    for (int ch = 0; ch < 256; ch++)
+        if (search->classmap[ch])
+            search->classmap[ch] = search->classes++;
+}
+
+static void build_prefilter(
+    pstrsearch_t *search, const pstring_t *needles, size_t count
+) {
+    size_t length = 0;
+    uint8_t seen[256] = { 0 };
+    char first[PREFILTER_SIZE];
+
+    for (size_t i = 0; i < count; i++) {
+        uint8_t ch = pstrbuf(&needles[i])[0];
+
+        if (!seen[ch] && length == PREFILTER_SIZE) {
+            search->filtered = 0;
+            return;
+        }
+
+        if (!seen[ch]) {
+            seen[ch] = 1;
+            first[length++] = ch;
+        }
+    }
+
+    search->filtered = pstrset_init(&search->prefilter, first, length) == 0;
+}
+
+static int build_trie(
+    pstrsearch_t *search, const pstring_t *needles, size_t count
+) {
+    uint32_t state;
+    if (add_state(search, &state))
+        return PSTRING_ENOMEM;
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *buffer = (const uint8_t *)pstrbuf(&needles[i]);
+        size_t length = pstrlen(&needles[i]);
+
+        if (length == 0 || length >= UINT32_MAX)
+            return PSTRING_EINVAL;
+
+        state = ROOT;
+        for (size_t j = 0; j < length; j++) {
+            uint32_t *edge
+                = &search->next[state * search->classes
+                                + search->classmap[buffer[j]]];
+
+            if (*edge == ROOT) {
+                uint32_t created;
+                if (add_state(search, &created))
+                    return PSTRING_ENOMEM;
+
+                /* `add_state` might have moved the table */
+                edge = &search->next[state * search->classes
+                                     + search->classmap[buffer[j]]];
+                *edge = created;
+            }
+
+            state = *edge;
+        }
+
+        if (search->out[state].id == NO_OUTPUT) {
+            search->out[state].id = i;
+            search->out[state].length = length;
+        }
+
+        if (search->maxlen < length)
+            search->maxlen = length;
+    }
+
+    return PSTRING_OK;
+}
+
+/* Turns the trie into a complete automaton by following failure links
+   in breadth-first order, so that searching never has to backtrack. */
+static int build_links(pstrsearch_t *search) {
+    size_t size = search->states * sizeof(uint32_t);
+    uint32_t *queue = allocate(search->allocator, 2 * size);
+    if (!queue)
+        return PSTRING_ENOMEM;
+
+    uint32_t *fail = &queue[search->states];
+    size_t head = 0, tail = 0;
+    size_t classes = search->classes;
+
+    for (size_t c = 0; c < classes; c++) {
+        uint32_t child = search->next[c];
+        if (child != ROOT) {
+            fail[child] = ROOT;
+            queue[tail++] = child;
+        }
+    }
+
+    while (head < tail) {
+        uint32_t state = queue[head++];
+        uint32_t *row = &search->next[state * classes];
+        uint32_t *failrow = &search->next[fail[state] * classes];
+
+        for (size_t c = 0; c < classes; c++) {
+            uint32_t child = row[c];
+
+            if (child == ROOT) {
+                row[c] = failrow[c];
+                continue;
+            }
+
+            uint32_t link = failrow[c];
+            fail[child] = link;
+            search->out[child].link = search->out[link].id != NO_OUTPUT
+                ? link
+                : search->out[link].link;
+            queue[tail++] = child;
+        }
+    }
+
+    deallocate(search->allocator, queue, 2 * size);
+    return PSTRING_OK;
+}
+
+pstrsearch_t *pstrsearch_new(
+    const pstring_t *needles, size_t count, allocator_t *allocator
+) {
+    /* ids of matched needles are returned as an `int` */
+    if (!needles || count == 0 || count > INT_MAX)
+        return NULL;
+
+    if (!allocator)
+        allocator = &standard_allocator;
+
+    pstrsearch_t *search = zallocate(allocator, sizeof(*search));
+    if (!search)
+        return NULL;
+
+    search->allocator = allocator;
+    search->count = count;
+
+    int error;
+
+    if (count == 1) {
+        /* a lone needle is faster to find with `pstrstr` */
+        error = pstrlen(needles) == 0;
+        if (!error)
+            error = pstrnew(
+                &search->needle, pstrbuf(needles), pstrlen(needles), allocator
+            );
+    } else {
+        build_classes(search, needles, count);
+        error = build_trie(search, needles, count) || build_links(search);
+        if (!error)
+            build_prefilter(search, needles, count);
+    }
+
+    if (error) {
+        pstrsearch_free(search);
+        return NULL;
+    }
+
+    return search;
+}
+
+void pstrsearch_free(pstrsearch_t *search) {
+    if (!search)
+        return;
+
+    deallocate(
+        search->allocator,
+        search->next,
+        search->capacity * search->classes * sizeof(uint32_t)
+    );
+
+    deallocate(
+        search->allocator,
+        search->out,
+        search->capacity * sizeof(struct output)
+    );
+
+    pstrfree(&search->needle);
+    deallocate(search->allocator, search, sizeof(*search));
+}
+
+size_t pstrsearch_count(const pstrsearch_t *search) {
+    return search ? search->count : 0;
+}
+
+static inline uint32_t step(
+    const pstrsearch_t *search, uint32_t state, char chr
+) {
+    uint8_t c = search->classmap[(uint8_t)chr];
+    return search->next[state * search->classes + c];
+}
+
+static inline uint32_t first_output(
+    const pstrsearch_t *search, uint32_t state
+) {
+    const struct output *out = &search->out[state];
+    return out->id != NO_OUTPUT ? state : out->link;
+}
+
+/* Returns the position of the next byte that can start a match. */
+static inline const char *skip(
+    const pstrsearch_t *search, const char *from, const char *end
+) {
+    if (!search->filtered)
+        return from;
+
+    pstring_t rest;
+    pstrrange(&rest, NULL, from, end);
+
+    const char *next = pstrpbrk_set(&rest, &search->prefilter);
+    return next ? next : end;
+}
+
+static int find_single(
+    const pstrsearch_t *search, const pstring_t *str, pstring_t *match
+) {
+    const char *found = pstrstr(str, &search->needle);
+    if (!found)
+        return PSTRING_ENOENT;
+
+    if (match)
+        pstrrange(match, NULL, found, found + pstrlen(&search->needle));
+    return 0;
+}
+
+int pstrsearch_find(
+    const pstrsearch_t *search, const pstring_t *str, pstring_t *match
+) {
+    if (!search || !str)
+        return PSTRING_EINVAL;
+
+    if (search->count == 1)
+        return find_single(search, str, match);
+
+    const char *chr = pstrbuf(str);
+    const char *end = pstrend(str);
+    const char *best = NULL, *limit = end;
+    uint32_t bestlen = 0, id = 0;
+    uint32_t state = ROOT;
+
+    while (chr < limit) {
+        if (state == ROOT && (chr = skip(search, chr, limit)) >= limit)
+            break;
+
+        state = step(search, state, *chr++);
+
+        for (uint32_t s = first_output(search, state); s != ROOT;
+             s = search->out[s].link) {
+            const char *start = chr - search->out[s].length;
+
+            if (!best || start < best
+                || (start == best && search->out[s].length > bestlen)) {
+                best = start;
+                bestlen = search->out[s].length;
+                id = search->out[s].id;
+
+                /* later matches can't start at or before `best` */
+                if ((size_t)(end - best) > search->maxlen)
+                    limit = best + search->maxlen;
+            }
+        }
+    }
+
+    if (!best)
+        return PSTRING_ENOENT;
+
+    if (match)
+        pstrrange(match, NULL, best, best + bestlen);
+    return id;
+}
+
+static int each_single(
+    const pstrsearch_t *search,
+    const pstring_t *str,
+    pstrsearch_fn *fn,
+    void *user
+) {
+    pstring_t rest, match;
+    pstrslice(&rest, str, 0, pstrlen(str));
+    size_t length = pstrlen(&search->needle);
+
+    for (const char *found; (found = pstrstr(&rest, &search->needle));) {
+        pstrrange(&match, NULL, found, found + length);
+        if (fn(user, 0, &match))
+            return PSTRING_EINTR;
+
+        pstrrange(&rest, NULL, found + 1, pstrend(str));
+    }
+
+    return PSTRING_OK;
+}
+
+int pstrsearch_each(
+    const pstrsearch_t *search,
+    const pstring_t *str,
+    pstrsearch_fn *fn,
+    void *user
+) {
+    if (!search || !str || !fn)
+        return PSTRING_EINVAL;
+
+    if (search->count == 1)
+        return each_single(search, str, fn, user);
+
+    const char *chr = pstrbuf(str);
+    const char *end = pstrend(str);
+    uint32_t state = ROOT;
+    pstring_t match;
+
+    while (chr < end) {
+        if (state == ROOT && (chr = skip(search, chr, end)) >= end)
+            break;
+
+        state = step(search, state, *chr++);
+
+        for (uint32_t s = first_output(search, state); s != ROOT;
+             s = search->out[s].link) {
+            pstrrange(&match, NULL, chr - search->out[s].length, chr);
+            if (fn(user, search->out[s].id, &match))
+                return PSTRING_EINTR;
+        }
+    }
+
+    return PSTRING_OK;
+}
+
+int pstrsearch_repl(
+    const pstrsearch_t *search,
+    pstring_t *dst,
+    const pstring_t *src,
+    const pstring_t *to
+) {
+    if (!search || !dst || !src || !to || dst == src)
+        return PSTRING_EINVAL;
+
+    if (pstrreserve(dst, pstrlen(src)))
+        return PSTRING_ENOMEM;
+
+    pstring_t rest, match, gap;
+    pstrslice(&rest, src, 0, pstrlen(src));
+
+    for (int id; (id = pstrsearch_find(search, &rest, &match)) >= 0;) {
+        pstrrange(&gap, NULL, pstrbuf(&rest), pstrbuf(&match));
+        if (pstrcat(dst, &gap) || pstrcat(dst, &to[id]))
+            return PSTRING_ENOMEM;
+
+        pstrrange(&rest, NULL, pstrend(&match), pstrend(src));
+    }
+
+    return pstrcat(dst, &rest) ? PSTRING_ENOMEM : PSTRING_OK;
+}
+
+int pstrrepl_many(
+    pstring_t *str, const pstring_t *from, const pstring_t *to, size_t n
+) {
+    if (!str || !from || !to || n == 0)
+        return PSTRING_EINVAL;
+
+    for (size_t i = 0; i < n; i++)
+        if (pstrlen(&from[i]) == 0)
+            return PSTRING_EINVAL;
+
+    pstrsearch_t *search = pstrsearch_new(from, n, pstrallocator(str));
+    if (!search)
+        return PSTRING_ENOMEM;
+
+    pstring_t out;
+    int error = pstralloc(&out, pstrlen(str), pstrallocator(str));
+    if (!error)
+        error = pstrsearch_repl(search, &out, str, to);
+
+    pstrsearch_free(search);
+    if (error)
+        return error;
+
+    if (pstrowned(str)) {
+        pstrfree(str);
+        *str = out;
+        return PSTRING_OK;
+    }
+
+    /* slices are rewritten in place, if the result fits */
+    error = pstrlen(&out) <= pstrcap(str) ? pstrcpy(str, &out)
+                                          : PSTRING_ENOMEM;
+    pstrfree(&out);
+    return error;
+}
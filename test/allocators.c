@@ -0,0 +1,104 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+#include <pf_assert.h>
+#include <pf_test.h>
+
+#include <pstring/allocators.h>
+#include <pstring/dictionary.h>
+#include <pstring/pstring.h>
+
+#include <stdint.h>
+#include <string.h>
+
+int test_allocators_arena(int seed, int rep) {
+    pstrarena_t *arena = pstrarena_new(0, NULL);
+    allocator_t *allocator = pstrarena_allocator(arena);
+    pstring_t str, other;
+
+    pf_assert_not_null(arena);
+    pf_assert_ok(pstrnew(&str, "hello", 0, allocator));
+    pf_assert(pstrallocator(&str) == allocator);
+    pf_assert(0 == (uintptr_t)pstrbuf(&str) % 16);
+
+    /* the most recent allocation grows in place */
+    char *buffer = pstrbuf(&str);
+    for (int i = 0; i < 100; i++)
+        pf_assert_ok(pstrcats(&str, " world", 6));
+    pf_assert(buffer == pstrbuf(&str));
+    pf_assert(605 == pstrlen(&str));
+
+    pf_assert_ok(pstrnew(&other, "other", 0, allocator));
+    pf_assert_ok(pstrcats(&str, "!", 1));
+    pf_assert(pstrequals(&other, "other", 0));
+    pf_assert('!' == pstrbuf(&str)[605]);
+    pf_assert(pstrarena_used(arena) > 605);
+
+    /* a reset hands out the same memory again */
+    buffer = pstrbuf(&str);
+    pstrarena_reset(arena);
+    pf_assert(0 == pstrarena_used(arena));
+    pf_assert_ok(pstrnew(&str, "again", 0, allocator));
+    pf_assert(pstrequals(&str, "again", 0));
+
+    /* allocations larger than a block get their own block */
+    pf_assert_ok(pstralloc(&other, 1024 * 1024, allocator));
+    memset(pstrbuf(&other), 'x', 1024 * 1024);
+    pf_assert(pstrequals(&str, "again", 0));
+
+    pstrarena_free(arena);
+    return 0;
+}
+
+int test_allocators_pool(int seed, int rep) {
+    pstrpool_t *pool = pstrpool_new(NULL);
+    allocator_t *allocator = pstrpool_allocator(pool);
+    pstring_t str, key = PSTRWRAP("key");
+
+    pf_assert_not_null(pool);
+    pf_assert_ok(pstralloc(&str, 100, allocator));
+    pf_assert(0 == (uintptr_t)pstrbuf(&str) % 16);
+
+    /* freed blocks are reused by allocations of the same class */
+    char *buffer = pstrbuf(&str);
+    pstrfree(&str);
+    pf_assert_ok(pstralloc(&str, 110, allocator));
+    pf_assert(buffer == pstrbuf(&str));
+
+    for (int i = 0; i < 2000; i++)
+        pf_assert_ok(pstrcats(&str, "0123456789", 10));
+    pf_assert(20000 == pstrlen(&str));
+    pf_assert('9' == pstrbuf(&str)[19999]);
+    pstrfree(&str);
+
+    pstrdict_t *dict = pstrdict_new(NULL, allocator);
+    pf_assert_not_null(dict);
+    pf_assert_ok(pstrdict_set(dict, &key, "value"));
+    pf_assert(0 == strcmp("value", pstrdict_get(dict, &key)));
+    pstrdict_free(dict);
+
+    pstrpool_free(pool);
+    return 0;
+}
+
+const struct pf_test suite_allocators[] = {
+    { test_allocators_arena, "/pstring/allocators/arena", 1 },
+    { test_allocators_pool, "/pstring/allocators/pool", 1 },
+    { 0 },
+};
@@ -0,0 +1,112 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+#include <pf_assert.h>
+#include <pf_test.h>
+
+#include <pstring/builder.h>
+#include <pstring/io.h>
+#include <pstring/pstring.h>
+
+int test_builder_cat(int seed, int rep) {
+    pstrbuilder_t builder;
+    pstring_t str = { 0 };
+
+    pf_assert(PSTRING_EINVAL == pstrbuilder_new(NULL, 0, NULL));
+    pf_assert_ok(pstrbuilder_new(&builder, 0, NULL));
+    pf_assert(0 == pstrbuilder_len(&builder));
+
+    pf_assert_ok(pstrbuilder_cats(&builder, "hello", 0));
+    pf_assert_ok(pstrbuilder_catc(&builder, ' '));
+    pf_assert_ok(pstrbuilder_cat(&builder, PSTR("world")));
+    pf_assert_ok(pstrbuilder_cat(&builder, PSTR("")));
+    pf_assert(PSTRING_EINVAL == pstrbuilder_cat(&builder, NULL));
+    pf_assert(11 == pstrbuilder_len(&builder));
+
+    pf_assert_ok(pstrcats(&str, "> ", 0));
+    pf_assert_ok(pstrbuilder_join(&builder, &str));
+    pf_assert(pstrequals(&str, "> hello world", 0));
+
+    pstrfree(&str);
+    pstrbuilder_free(&builder);
+    pf_assert(0 == pstrbuilder_len(&builder));
+    return 0;
+}
+
+int test_builder_join(int seed, int rep) {
+    pstrbuilder_t builder = { 0 };
+    pstrbuilder_stats_t stats;
+    pstring_t str = { 0 };
+
+    for (int i = 0; i < 1000; i++)
+        pf_assert_ok(pstrbuilder_cats(&builder, "0123456789", 10));
+
+    /* segments double in size, so bytes are never copied between them */
+    pf_assert_ok(pstrbuilder_stats(&builder, &stats));
+    pf_assert(10000 == stats.length);
+    pf_assert(stats.capacity >= stats.length);
+    pf_assert(stats.segments > 1 && stats.segments < 10);
+
+    pf_assert_ok(pstrbuilder_join(&builder, &str));
+    pf_assert(10000 == pstrlen(&str));
+    pf_assert(pstrcap(&str) < 10100);
+    for (int i = 0; i < 10000; i++)
+        pf_assert('0' + i % 10 == pstrbuf(&str)[i]);
+
+    pstrfree(&str);
+    pstrbuilder_free(&builder);
+
+    /* a large enough initial capacity needs a single segment */
+    pf_assert_ok(pstrbuilder_new(&builder, 10000, NULL));
+    for (int i = 0; i < 1000; i++)
+        pf_assert_ok(pstrbuilder_cats(&builder, "0123456789", 10));
+
+    pf_assert_ok(pstrbuilder_stats(&builder, &stats));
+    pf_assert(1 == stats.segments && 10000 == stats.capacity);
+
+    pstrbuilder_free(&builder);
+    return 0;
+}
+
+int test_builder_write(int seed, int rep) {
+    pstrbuilder_t builder = { 0 };
+    pstring_t str = { 0 };
+    pstream_t stream;
+
+    for (int i = 0; i < 100; i++)
+        pf_assert_ok(pstrbuilder_cats(&builder, "abcdefghij", 10));
+
+    pf_assert_ok(pstream_string(&stream, &str));
+    pf_assert_ok(pstrbuilder_write(&builder, &stream));
+    pstream_close(&stream);
+
+    pf_assert(1000 == pstrlen(&str));
+    pf_assert('a' == pstrbuf(&str)[0] && 'j' == pstrbuf(&str)[999]);
+
+    pstrfree(&str);
+    pstrbuilder_free(&builder);
+    return 0;
+}
+
+const struct pf_test suite_builder[] = {
+    { test_builder_cat, "/pstring/builder/cat", 1 },
+    { test_builder_join, "/pstring/builder/join", 1 },
+    { test_builder_write, "/pstring/builder/write", 1 },
+    { 0 },
+};
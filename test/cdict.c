@@ -0,0 +1,187 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <pf_assert.h>
+#include <pf_test.h>
+
+#include <pstring/cdict.h>
+#include <pstring/pstring.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+#define THREADS 4
+#define KEYS 1000
+
+static char g_names[KEYS][16];
+static pstring_t g_keys[KEYS];
+
+static void init_keys(void) {
+    for (int i = 0; i < KEYS; i++) {
+        int length = snprintf(g_names[i], sizeof(g_names[i]), "route-%d", i);
+        pstrwrap(&g_keys[i], g_names[i], length, length);
+    }
+}
+
+int test_cdict_new(int seed, int rep) {
+    pstrcdict_t *dict = pstrcdict_new(0, NULL);
+    pf_assert_not_null(dict);
+    pf_assert(0 == pstrcdict_count(dict));
+    pf_assert_null(pstrcdict_get(dict, PSTR("missing")));
+    pstrcdict_free(dict);
+
+    dict = pstrcdict_new(3, NULL);
+    pf_assert_not_null(dict);
+    pf_assert(PSTRING_EINVAL == pstrcdict_set(dict, NULL, dict));
+    pf_assert(PSTRING_EINVAL == pstrcdict_set(dict, PSTR("a"), NULL));
+    pf_assert(PSTRING_EINVAL == pstrcdict_remove(dict, NULL));
+    pf_assert(PSTRING_EINVAL == pstrcdict_insert(NULL, PSTR("a"), dict));
+    pf_assert_null(pstrcdict_get(NULL, PSTR("a")));
+    pf_assert(0 == pstrcdict_count(NULL));
+    pstrcdict_free(dict);
+
+    pstrcdict_free(NULL);
+    return 0;
+}
+
+int test_cdict_get_set(int seed, int rep) {
+    pstring_t hello = PSTRWRAP("hello");
+    int values[2];
+
+    init_keys();
+    pstrcdict_t *dict = pstrcdict_new(4, NULL);
+    pf_assert_not_null(dict);
+
+    pf_assert_ok(pstrcdict_insert(dict, &hello, &values[0]));
+    pf_assert(PSTRING_EEXIST == pstrcdict_insert(dict, &hello, &values[1]));
+    pf_assert(pstrcdict_get(dict, PSTR("hello")) == &values[0]);
+    pf_assert_ok(pstrcdict_set(dict, &hello, &values[1]));
+    pf_assert(pstrcdict_get(dict, PSTR("hello")) == &values[1]);
+    pf_assert(1 == pstrcdict_count(dict));
+
+    pf_assert_ok(pstrcdict_remove(dict, PSTR("hello")));
+    pf_assert(PSTRING_ENOENT == pstrcdict_remove(dict, PSTR("hello")));
+    pf_assert_null(pstrcdict_get(dict, PSTR("hello")));
+
+    /* shards grow, and reclaim removed slots while churning */
+    for (int i = 0; i < KEYS; i++)
+        pf_assert_ok(pstrcdict_set(dict, &g_keys[i], g_names[i]));
+    pf_assert(KEYS == pstrcdict_count(dict));
+
+    for (int round = 0; round < 20; round++) {
+        for (int i = round % 2; i < KEYS; i += 2)
+            pf_assert_ok(pstrcdict_remove(dict, &g_keys[i]));
+        for (int i = round % 2; i < KEYS; i += 2)
+            pf_assert_ok(pstrcdict_insert(dict, &g_keys[i], g_names[i]));
+    }
+
+    pf_assert(KEYS == pstrcdict_count(dict));
+    for (int i = 0; i < KEYS; i++)
+        pf_assert(pstrcdict_get(dict, &g_keys[i]) == g_names[i]);
+
+    pstrcdict_free(dict);
+    return 0;
+}
+
+struct reader {
+    pstrcdict_t *dict;
+    atomic_int *ready, *done;
+    size_t lookups;
+    size_t errors;
+};
+
+/* The first half of the keys is never changed, while the writer keeps
+   setting, replacing and removing the second half. */
+static void *read_keys(void *arg) {
+    struct reader *reader = arg;
+
+    while (!atomic_load(reader->done)) {
+        for (int i = 0; i < KEYS; i++) {
+            char *value = pstrcdict_get(reader->dict, &g_keys[i]);
+
+            if (i < KEYS / 2)
+                reader->errors += value != g_names[i];
+            else
+                reader->errors += value && value != g_names[i]
+                    && value != &g_names[i][1];
+        }
+
+        if (reader->lookups == 0)
+            atomic_fetch_add(reader->ready, 1);
+        reader->lookups += KEYS;
+    }
+
+    return NULL;
+}
+
+int test_cdict_threads(int seed, int rep) {
+    struct reader readers[THREADS];
+    pthread_t threads[THREADS];
+    atomic_int ready = 0, done = 0;
+
+    init_keys();
+    pstrcdict_t *dict = pstrcdict_new(8, NULL);
+    pf_assert_not_null(dict);
+
+    for (int i = 0; i < KEYS / 2; i++)
+        pf_assert_ok(pstrcdict_set(dict, &g_keys[i], g_names[i]));
+
+    for (int i = 0; i < THREADS; i++) {
+        readers[i] = (struct reader) { dict, &ready, &done, 0, 0 };
+        pf_assert(0 == pthread_create(
+            &threads[i], NULL, read_keys, &readers[i]
+        ));
+    }
+
+    /* every reader is running before the writer starts */
+    while (atomic_load(&ready) < THREADS)
+        sched_yield();
+
+    for (int round = 0; round < 50; round++) {
+        for (int i = KEYS / 2; i < KEYS; i++)
+            pf_assert_ok(pstrcdict_set(dict, &g_keys[i], g_names[i]));
+        for (int i = KEYS / 2; i < KEYS; i++)
+            pf_assert_ok(pstrcdict_set(dict, &g_keys[i], &g_names[i][1]));
+        for (int i = KEYS / 2; i < KEYS; i += 1 + round % 2)
+            pf_assert_ok(pstrcdict_remove(dict, &g_keys[i]));
+    }
+
+    atomic_store(&done, 1);
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        pf_assert(readers[i].lookups > 0);
+        pf_assert(0 == readers[i].errors);
+    }
+
+    for (int i = 0; i < KEYS / 2; i++)
+        pf_assert(pstrcdict_get(dict, &g_keys[i]) == g_names[i]);
+
+    pstrcdict_free(dict);
+    return 0;
+}
+
+const struct pf_test suite_cdict[] = {
+    { test_cdict_new, "/pstring/cdict/new", 1 },
+    { test_cdict_get_set, "/pstring/cdict/get_set", 1 },
+    { test_cdict_threads, "/pstring/cdict/threads", 1 },
+    { 0 },
+};
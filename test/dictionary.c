@@ -24,6 +24,20 @@
 #include <pstring/dictionary.h>
 #include <pstring/pstring.h>
 
+#include <stdint.h>
+#include <stdio.h>
+
+/* Fills `names` with "key0", "key1"... up to `distinct` keys, repeating them
+   until there are `count`, and wraps each of them into `keys`. */
+static void fill_keys(
+    char (*names)[8], pstring_t *keys, int count, int distinct
+) {
+    for (int i = 0; i < count; i++) {
+        int length = snprintf(names[i], 8, "key%d", i % distinct);
+        pstrwrap(&keys[i], names[i], length, length);
+    }
+}
+
 int test_pstrdict_new(int seed, int rep) {
     pstrdict_t *dict = pstrdict_new(NULL, NULL);
     pf_assert_not_null(dict);
@@ -45,6 +59,12 @@ int test_pstrdict_reserve(int seed, int rep) {
     pf_assert_ok(pstrdict_reserve(dict, 10));
     pf_assert(10 <= pstrdict_capacity(dict));
 
+    /* sizes that can't be allocated fail instead of overflowing */
+    size_t capacity = pstrdict_capacity(dict);
+    pf_assert(pstrdict_reserve(dict, SIZE_MAX / 16 * 15) == PSTRING_ENOMEM);
+    pf_assert(pstrdict_reserve(dict, SIZE_MAX) == PSTRING_ENOMEM);
+    pf_assert(pstrdict_capacity(dict) == capacity);
+
     pstrdict_free(dict);
     return 0;
 }
@@ -109,6 +129,31 @@ int test_pstrdict_insert_remove(int seed, int rep) {
     return 0;
 }
 
+int test_pstrdict_grow_removed(int seed, int rep) {
+    char names[100][8];
+    pstring_t keys[100];
+
+    pstrdict_t *dict = pstrdict_new(NULL, NULL);
+    pf_assert_not_null(dict);
+
+    fill_keys(names, keys, 100, 100);
+    for (int i = 0; i < 100; i++)
+        pf_assert_ok(pstrdict_set(dict, &keys[i], names[i]));
+
+    for (int i = 0; i < 100; i += 2)
+        pf_assert_ok(pstrdict_remove(dict, &keys[i]));
+
+    /* growing moves only the pairs still present */
+    pf_assert_ok(pstrdict_reserve(dict, pstrdict_capacity(dict)));
+    pf_assert(50 == pstrdict_count(dict));
+
+    for (int i = 0; i < 100; i++)
+        pf_assert(pstrdict_get(dict, &keys[i]) == (i % 2 ? names[i] : NULL));
+
+    pstrdict_free(dict);
+    return 0;
+}
+
 int sum_each(void *user, pstring_t *key, void *value) {
     *(int *)user += *(int *)value;
     return 0;
@@ -148,11 +193,283 @@ int test_pstrdict_each(int seed, int rep) {
     return 0;
 }
 
+/* Appends `value` to a null-terminated array of values. */
+static int record_each(void *user, pstring_t *key, void *value) {
+    void **order = user;
+    while (*order)
+        order++;
+    *order = value;
+    return 0;
+}
+
+int test_pstrdict_seeded(int seed, int rep) {
+    char names[64][8];
+    pstring_t keys[64];
+    int values[64];
+
+    pstrdict_t *left = pstrdict_new_seeded(42, NULL);
+    pstrdict_t *right = pstrdict_new_seeded(42, NULL);
+    pstrdict_t *random = pstrdict_new(NULL, NULL);
+    pf_assert_not_null(left);
+    pf_assert_not_null(right);
+    pf_assert_not_null(random);
+
+    fill_keys(names, keys, 64, 64);
+    for (int i = 0; i < 64; i++) {
+        values[i] = i;
+
+        pf_assert_ok(pstrdict_insert(left, &keys[i], &values[i]));
+        pf_assert_ok(pstrdict_insert(right, &keys[i], &values[i]));
+        pf_assert_ok(pstrdict_insert(random, &keys[i], &values[i]));
+    }
+
+    /* the same seed places keys the same way */
+    void *lorder[65] = { 0 }, *rorder[65] = { 0 };
+    pf_assert_ok(pstrdict_each(left, record_each, lorder));
+    pf_assert_ok(pstrdict_each(right, record_each, rorder));
+    pf_assert_memcmp(lorder, rorder, sizeof(lorder));
+
+    for (int i = 0; i < 64; i++) {
+        pf_assert(pstrdict_get(left, &keys[i]) == &values[i]);
+        pf_assert(pstrdict_get(right, &keys[i]) == &values[i]);
+        pf_assert(pstrdict_get(random, &keys[i]) == &values[i]);
+    }
+
+    pstrdict_free(left);
+    pstrdict_free(right);
+    pstrdict_free(random);
+    return 0;
+}
+
+int test_pstrdict_set_many(int seed, int rep) {
+    char names[1000][8];
+    pstring_t keys[1000];
+    int values[1000];
+    void *pointers[1000];
+
+    fill_keys(names, keys, 1000, 900);
+    for (int i = 0; i < 1000; i++) {
+        values[i] = i;
+        pointers[i] = &values[i];
+    }
+
+    pstrdict_t *dict = pstrdict_new(NULL, NULL);
+    pf_assert_not_null(dict);
+
+    pf_assert_ok(pstrdict_set_many(dict, keys, pointers, 1000));
+    pf_assert(pstrdict_count(dict) == 900);
+
+    /* later duplicates replace the values of earlier ones */
+    for (int i = 0; i < 900; i++) {
+        int *value = pstrdict_get(dict, &keys[i]);
+        pf_assert_not_null(value);
+        pf_assert(*value == (i < 100 ? i + 900 : i));
+    }
+
+    pointers[0] = NULL;
+    pf_assert(PSTRING_EINVAL == pstrdict_set_many(dict, keys, pointers, 1));
+    pf_assert_ok(pstrdict_set_many(dict, NULL, NULL, 0));
+
+    pstrdict_free(dict);
+    return 0;
+}
+
+static size_t g_hashed;
+
+static size_t counting_hash(const pstring_t *str) {
+    g_hashed++;
+    return pstrhash(str);
+}
+
+int test_pstrdict_hashed(int seed, int rep) {
+    int values[3] = { 1, 2, 3 };
+    pstring_t shared = PSTRWRAP("shared"), second = PSTRWRAP("other");
+    pstrkey_t key, other;
+
+    pstrdict_t *left = pstrdict_new(counting_hash, NULL);
+    pstrdict_t *right = pstrdict_new(counting_hash, NULL);
+    pf_assert_not_null(left);
+    pf_assert_not_null(right);
+
+    /* the key is hashed once, then used with both dictionaries */
+    g_hashed = 0;
+    pf_assert_ok(pstrdict_key(left, &key, &shared));
+    pf_assert_ok(pstrdict_key(left, &other, &second));
+
+    pf_assert_null(pstrdict_get_hashed(left, &key));
+    pf_assert_ok(pstrdict_set_hashed(left, &key, &values[0]));
+    pf_assert_ok(pstrdict_insert_hashed(right, &key, &values[1]));
+    pf_assert(
+        PSTRING_EEXIST == pstrdict_insert_hashed(right, &key, &values[2])
+    );
+    pf_assert_ok(pstrdict_finsert_hashed(right, &other, &values[2]));
+    pf_assert(pstrdict_get_hashed(left, &key) == &values[0]);
+    pf_assert(pstrdict_get_hashed(right, &key) == &values[1]);
+    pf_assert(pstrdict_get_hashed(right, &other) == &values[2]);
+    pf_assert(g_hashed == 2);
+
+    /* and finds the same pairs as the key hashed again */
+    pf_assert(pstrdict_get(right, PSTR("shared")) == &values[1]);
+    pf_assert_ok(pstrdict_remove_hashed(right, &key));
+    pf_assert(PSTRING_ENOENT == pstrdict_remove_hashed(right, &key));
+    pf_assert_null(pstrdict_get(right, PSTR("shared")));
+
+    /* dictionaries hashing keys differently hash the key again */
+    pstrdict_t *random = pstrdict_new(NULL, NULL);
+    pstrdict_t *seeded = pstrdict_new_seeded(seed, NULL);
+    pf_assert_not_null(random);
+    pf_assert_not_null(seeded);
+
+    g_hashed = 0;
+    pf_assert_ok(pstrdict_set_hashed(random, &key, &values[0]));
+    pf_assert_ok(pstrdict_insert_hashed(seeded, &key, &values[1]));
+    pf_assert(g_hashed == 0);
+    pf_assert(pstrdict_get(random, PSTR("shared")) == &values[0]);
+    pf_assert(pstrdict_get(seeded, PSTR("shared")) == &values[1]);
+
+    pf_assert_ok(pstrdict_key(seeded, &key, &shared));
+    pf_assert(pstrdict_get_hashed(random, &key) == &values[0]);
+    pf_assert(pstrdict_get_hashed(left, &key) == &values[0]);
+    pf_assert(g_hashed == 1);
+    pf_assert_ok(pstrdict_remove_hashed(random, &key));
+    pf_assert_null(pstrdict_get(random, PSTR("shared")));
+
+    pstrdict_free(random);
+    pstrdict_free(seeded);
+
+    pf_assert(PSTRING_EINVAL == pstrdict_key(left, &key, NULL));
+    pf_assert(PSTRING_EINVAL == pstrdict_set_hashed(left, NULL, &values[0]));
+    pf_assert_null(pstrdict_get_hashed(left, NULL));
+
+    pstrdict_free(left);
+    pstrdict_free(right);
+    return 0;
+}
+
+int test_pstrdict_grow(int seed, int rep) {
+    char names[1000][8];
+    pstring_t keys[1000];
+
+    pstrdict_t *dict = pstrdict_new(counting_hash, NULL);
+    pf_assert_not_null(dict);
+
+    /* growing places pairs by their stored hashes, without hashing again */
+    g_hashed = 0;
+    fill_keys(names, keys, 1000, 1000);
+    for (int i = 0; i < 1000; i++)
+        pf_assert_ok(pstrdict_set(dict, &keys[i], names[i]));
+
+    pf_assert(g_hashed == 1000);
+    pf_assert(pstrdict_capacity(dict) >= 1000);
+
+    for (int i = 0; i < 1000; i++)
+        pf_assert(pstrdict_get(dict, &keys[i]) == names[i]);
+
+    pstrdict_free(dict);
+    return 0;
+}
+
+int test_pstrdict_churn(int seed, int rep) {
+    char names[1000][8];
+    pstring_t keys[1000];
+
+    pstrdict_t *dict = pstrdict_new(NULL, NULL);
+    pf_assert_not_null(dict);
+
+    fill_keys(names, keys, 1000, 1000);
+    for (int i = 0; i < 200; i++)
+        pf_assert_ok(pstrdict_set(dict, &keys[i], names[i]));
+
+    size_t capacity = pstrdict_capacity(dict);
+
+    /* removed slots are reused and reclaimed, so a steady number of pairs
+       doesn't grow the table */
+    for (int i = 200; i < 20000; i++) {
+        pstring_t *old = &keys[(i - 200) % 1000];
+        pf_assert_ok(pstrdict_remove(dict, old));
+        pf_assert_null(pstrdict_get(dict, old));
+        pf_assert_ok(pstrdict_set(dict, &keys[i % 1000], names[i % 1000]));
+    }
+
+    pf_assert(pstrdict_count(dict) == 200);
+    pf_assert(pstrdict_capacity(dict) == capacity);
+
+    for (int i = 19800; i < 20000; i++)
+        pf_assert(pstrdict_get(dict, &keys[i % 1000]) == names[i % 1000]);
+    for (int i = 19000; i < 19800; i++)
+        pf_assert_null(pstrdict_get(dict, &keys[i % 1000]));
+
+    pstrdict_free(dict);
+    return 0;
+}
+
+int test_pstrdict_compact_shrink(int seed, int rep) {
+    char names[1000][8];
+    pstring_t keys[1000];
+
+    pstrdict_t *dict = pstrdict_new(NULL, NULL);
+    pf_assert_not_null(dict);
+
+    fill_keys(names, keys, 1000, 1000);
+    for (int i = 0; i < 1000; i++)
+        pf_assert_ok(pstrdict_set(dict, &keys[i], names[i]));
+
+    for (int i = 0; i < 1000; i += 2)
+        pf_assert_ok(pstrdict_remove(dict, &keys[i]));
+
+    size_t capacity = pstrdict_capacity(dict);
+    pf_assert_ok(pstrdict_compact(dict));
+    pf_assert(pstrdict_capacity(dict) == capacity);
+    pf_assert(pstrdict_count(dict) == 500);
+
+    for (int i = 0; i < 1000; i++)
+        pf_assert(pstrdict_get(dict, &keys[i]) == (i % 2 ? names[i] : NULL));
+
+    for (int i = 1; i < 900; i += 2)
+        pf_assert_ok(pstrdict_remove(dict, &keys[i]));
+
+    pf_assert_ok(pstrdict_shrink(dict));
+    pf_assert(pstrdict_capacity(dict) < capacity);
+    pf_assert(pstrdict_count(dict) == 50);
+
+    for (int i = 0; i < 1000; i++) {
+        void *expected = i >= 900 && i % 2 ? names[i] : NULL;
+        pf_assert(pstrdict_get(dict, &keys[i]) == expected);
+    }
+
+    pstrdict_clear(dict);
+    pf_assert_ok(pstrdict_shrink(dict));
+    pf_assert(pstrdict_capacity(dict) == 0);
+
+    pf_assert_ok(pstrdict_set(dict, &keys[0], names[0]));
+    pf_assert(pstrdict_get(dict, &keys[0]) == names[0]);
+
+    /* empty tables are freed even at the smallest capacity */
+    pf_assert(pstrdict_capacity(dict) == 16);
+    pf_assert_ok(pstrdict_remove(dict, &keys[0]));
+    pf_assert_ok(pstrdict_shrink(dict));
+    pf_assert(pstrdict_capacity(dict) == 0);
+    pf_assert_ok(pstrdict_shrink(dict));
+
+    pf_assert(PSTRING_EINVAL == pstrdict_compact(NULL));
+    pf_assert(PSTRING_EINVAL == pstrdict_shrink(NULL));
+
+    pstrdict_free(dict);
+    return 0;
+}
+
 const struct pf_test suite_dict[] = {
     { test_pstrdict_new, "/pstring/dict/new", 1 },
     { test_pstrdict_reserve, "/pstring/dict/reserve", 1 },
     { test_pstrdict_get_set, "/pstring/dict/get_set", 1 },
     { test_pstrdict_insert_remove, "/pstring/dict/insert_remove", 1 },
+    { test_pstrdict_grow_removed, "/pstring/dict/grow_removed", 1 },
     { test_pstrdict_each, "/pstring/dict/each", 1 },
+    { test_pstrdict_seeded, "/pstring/dict/seeded", 1 },
+    { test_pstrdict_set_many, "/pstring/dict/set_many", 1 },
+    { test_pstrdict_hashed, "/pstring/dict/hashed", 1 },
+    { test_pstrdict_grow, "/pstring/dict/grow", 1 },
+    { test_pstrdict_churn, "/pstring/dict/churn", 1 },
+    { test_pstrdict_compact_shrink, "/pstring/dict/compact_shrink", 1 },
     { 0 },
 };
@@ -21,6 +21,7 @@
 #include <limits.h>
 #include <pf_assert.h>
 #include <pf_test.h>
+#include <string.h>
 
 #include <pstring/encoding.h>
 #include <pstring/pstring.h>
@@ -180,6 +181,123 @@ int test_encoding_utf8(int seed, int rep) {
     TEST_DEC_UTF8("\uC704", 0xC704);
     TEST_DEC_UTF8("\U0010FFFF", 0x0010FFFF);
     TEST_DEC_UTF8("\U00010345", 0x00010345);
+    TEST_ENC_UTF8(0x00110000, "\uFFFD");
+
+    length = 0;
+    pf_assert_ok(pstrdec_utf8(NULL, &length, &PSTRWRAP("\u0024\xC3\u1234")));
+    pf_assert(length == 3);
+
+    pstrfree(&dst);
+    return 0;
+}
+
+int test_encoding_utf8_valid(int seed, int rep) {
+    char text[160];
+
+    pf_assert_true(pstrvalid_utf8(&PSTRWRAP("")));
+    pf_assert_true(pstrvalid_utf8(&PSTRWRAP("\u0024\u0392\uC704\U0010FFFF")));
+    pf_assert(pstrlen_utf8(&PSTRWRAP("\u0024\u0392\uC704\U0010FFFF")) == 4);
+
+    pf_assert_false(pstrvalid_utf8(&PSTRWRAP("\x80")));
+    pf_assert_false(pstrvalid_utf8(&PSTRWRAP("\xC0\xAF")));
+    pf_assert_false(pstrvalid_utf8(&PSTRWRAP("\xE0\x9F\xBF")));
+    pf_assert_false(pstrvalid_utf8(&PSTRWRAP("\xED\xA0\x80")));
+    pf_assert_false(pstrvalid_utf8(&PSTRWRAP("\xF4\x90\x80\x80")));
+    pf_assert_false(pstrvalid_utf8(&PSTRWRAP("\xF8\x88\x80\x80\x80")));
+    pf_assert(pstrlen_utf8(&PSTRWRAP("\x80\xC3\xA9")) == 1);
+
+    /* a character cut short anywhere in a longer string */
+    for (size_t i = 0; i + 3 <= sizeof(text); i++) {
+        pstring_t str;
+        memset(text, 'a', sizeof(text));
+        memcpy(&text[i], "\xE2\x82\xAC", 3);
+        pstrwrap(&str, text, sizeof(text), sizeof(text));
+        pf_assert_true(pstrvalid_utf8(&str));
+
+        pstrwrap(&str, text, i + 2, i + 2);
+        pf_assert_false(pstrvalid_utf8(&str));
+        pf_assert(pstrlen_utf8(&str) == i + 1);
+    }
+
+    return 0;
+}
+
+int test_encoding_utf16(int seed, int rep) {
+    char utf8[] = "a\u00E9\u20AC\U0001F600";
+    const char le[] = "a\0\xE9\0\xAC\x20\x3D\xD8\0\xDE";
+    const char be[] = "\0a\0\xE9\x20\xAC\xD8\x3D\xDE\0";
+    const char *const runs[] = { "\u00E9", "\u20AC", "\u00E9a\u20AC" };
+    pstring_t dst = { 0 }, str;
+    uint16_t units[300];
+    char text[300];
+    size_t length = 0;
+
+    pf_assert_ok(pstrenc_utf16le(NULL, &length, &PSTRWRAP(utf8)));
+    pf_assert(length == 5);
+    pf_assert(pstrlen_utf16(&PSTRWRAP(utf8)) == 5);
+
+    pf_assert_ok(pstrenc_utf16le(units, &length, &PSTRWRAP(utf8)));
+    pf_assert(length == 5);
+    pf_assert_memcmp(units, le, sizeof(le) - 1);
+    pf_assert_ok(pstrdec_utf16le(&dst, units, length));
+    pf_assert_memcmp(pstrbuf(&dst), utf8, sizeof(utf8) - 1);
+
+    pf_assert_ok(pstrenc_utf16be(units, &length, &PSTRWRAP(utf8)));
+    pf_assert_memcmp(units, be, sizeof(be) - 1);
+    pstrclear(&dst);
+    pf_assert_ok(pstrdec_utf16be(&dst, units, length));
+    pf_assert(pstrlen(&dst) == sizeof(utf8) - 1);
+    pf_assert_memcmp(pstrbuf(&dst), utf8, sizeof(utf8) - 1);
+
+    /* the surrogate pair doesn't fit */
+    length = 4;
+    pf_assert(
+        pstrenc_utf16le(units, &length, &PSTRWRAP(utf8)) == PSTRING_ENOMEM
+    );
+    pf_assert(length == 3);
+
+    /* unpaired surrogates and invalid UTF-8 */
+    memcpy(units, "\x00\xD8" "b\0" "\x00\xDC", 6);
+    pstrclear(&dst);
+    pf_assert_ok(pstrdec_utf16le(&dst, units, 3));
+    pf_assert(pstrlen(&dst) == 7);
+    pf_assert_memcmp(pstrbuf(&dst), "\uFFFDb\uFFFD", 7);
+
+    length = 3;
+    pf_assert_ok(pstrenc_utf16le(units, &length, &PSTRWRAP("\xED\xA0\x80")));
+    pf_assert(length == 1);
+    pf_assert_memcmp(units, "\xFD\xFF", 2);
+
+    /* long runs of ASCII around other characters */
+    for (size_t i = 0; i + 4 <= sizeof(text); i += 7) {
+        memset(text, 'a' + i % 26, sizeof(text));
+        memcpy(&text[i], "\xF0\x9F\x98\x80", 4);
+        pstrwrap(&str, text, sizeof(text), sizeof(text));
+
+        length = 300;
+        pf_assert_ok(pstrenc_utf16be(units, &length, &str));
+        pf_assert(length == sizeof(text) - 2);
+        pstrclear(&dst);
+        pf_assert_ok(pstrdec_utf16be(&dst, units, length));
+        pf_assert(pstrlen(&dst) == sizeof(text));
+        pf_assert_memcmp(pstrbuf(&dst), text, sizeof(text));
+    }
+
+    /* long runs of two and three byte characters */
+    for (size_t r = 0; r < sizeof(runs) / sizeof(*runs); r++) {
+        size_t size = strlen(runs[r]), count;
+        for (count = 0; count + size <= sizeof(text); count += size)
+            memcpy(&text[count], runs[r], size);
+        pstrwrap(&str, text, count, count);
+
+        length = 300;
+        pf_assert_ok(pstrenc_utf16le(units, &length, &str));
+        pf_assert(length == pstrlen_utf16(&str));
+        pstrclear(&dst);
+        pf_assert_ok(pstrdec_utf16le(&dst, units, length));
+        pf_assert(pstrlen(&dst) == count);
+        pf_assert_memcmp(pstrbuf(&dst), text, count);
+    }
 
     pstrfree(&dst);
     return 0;
@@ -249,6 +367,8 @@ const struct pf_test suite_encoding[] = {
     { test_encoding_base64, "/pstring/encoding/base64", 1 },
     { test_encoding_cstring, "/pstring/encoding/cstring", 1 },
     { test_encoding_utf8, "/pstring/encoding/utf8", 1 },
+    { test_encoding_utf8_valid, "/pstring/encoding/utf8_valid", 1 },
+    { test_encoding_utf16, "/pstring/encoding/utf16", 1 },
     { test_encoding_json, "/pstring/encoding/json", 1 },
     { test_encoding_xml, "/pstring/encoding/xml", 1 },
     { 0 },
@@ -0,0 +1,120 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <pf_assert.h>
+#include <pf_test.h>
+
+#include <pstring/fuzzy.h>
+#include <pstring/pstring.h>
+
+static const char *g_words[] = {
+    "book",  "books", "cake", "boo",   "boon", "cook",
+    "cape",  "cart",  "kitten", "sitting", "mitten", "bitten",
+    "",      "ca",    "abc",  "book",
+};
+
+#define WORD_COUNT (sizeof(g_words) / sizeof(*g_words))
+
+static pstrfuzzy_t *new_index(pstring_t *entries) {
+    for (size_t i = 0; i < WORD_COUNT; i++)
+        pstrwrap(&entries[i], (char *)g_words[i], 0, 0);
+
+    return pstrfuzzy_new(entries, WORD_COUNT, NULL);
+}
+
+int test_fuzzy_new(int seed, int rep) {
+    pstring_t entries[WORD_COUNT];
+
+    pf_assert_null(pstrfuzzy_new(NULL, 0, NULL));
+    pf_assert_null(pstrfuzzy_new(entries, 0, NULL));
+
+    pstrfuzzy_t *fuzzy = new_index(entries);
+    pf_assert_not_null(fuzzy);
+    pf_assert(WORD_COUNT == pstrfuzzy_count(fuzzy));
+
+    pstrfuzzy_free(fuzzy);
+    return 0;
+}
+
+static int count_matches(void *user, size_t index, size_t distance) {
+    size_t *counts = user;
+    counts[index] = distance + 1;
+    return 0;
+}
+
+int test_fuzzy_each(int seed, int rep) {
+    pstring_t entries[WORD_COUNT];
+    pstrfuzzy_t *fuzzy = new_index(entries);
+    pf_assert_not_null(fuzzy);
+
+    size_t found[WORD_COUNT] = { 0 };
+    pf_assert_ok(pstrfuzzy_each(fuzzy, PSTR("bok"), 1, count_matches, found));
+
+    for (size_t i = 0; i < WORD_COUNT; i++) {
+        int distance = pstrdistance(PSTR("bok"), &entries[i]);
+        pf_assert(found[i] == (distance <= 1 ? distance + 1 : 0));
+    }
+
+    /* "ac" is 2 edits away from "abc" but only 1 transposition from "ca" */
+    size_t swapped[WORD_COUNT] = { 0 };
+    pf_assert_ok(pstrfuzzy_each(fuzzy, PSTR("ac"), 1, count_matches, swapped));
+    pf_assert(2 == swapped[13] && 2 == swapped[14]);
+
+    pf_assert(
+        PSTRING_EINVAL == pstrfuzzy_each(NULL, PSTR("a"), 1, count_matches, 0)
+    );
+
+    pstrfuzzy_free(fuzzy);
+    return 0;
+}
+
+int test_fuzzy_nearest(int seed, int rep) {
+    pstring_t entries[WORD_COUNT];
+    pstrfuzzy_t *fuzzy = new_index(entries);
+    pf_assert_not_null(fuzzy);
+
+    pstrfuzzy_match_t out[4];
+    pf_assert(4 == pstrfuzzy_nearest(fuzzy, PSTR("book"), 10, out, 4));
+    pf_assert(0 == out[0].index && 0 == out[0].distance);
+    pf_assert(15 == out[1].index && 0 == out[1].distance);
+    pf_assert(1 == out[2].index && 1 == out[2].distance);
+    pf_assert(3 == out[3].index && 1 == out[3].distance);
+
+    pf_assert(1 == pstrfuzzy_nearest(fuzzy, PSTR("kiten"), 1, out, 4));
+    pf_assert(8 == out[0].index && 1 == out[0].distance);
+
+    pf_assert(3 == pstrfuzzy_nearest(fuzzy, PSTR("kiten"), 2, out, 4));
+    pf_assert(8 == out[0].index && 1 == out[0].distance);
+    pf_assert(10 == out[1].index && 2 == out[1].distance);
+    pf_assert(11 == out[2].index && 2 == out[2].distance);
+
+    pf_assert(0 == pstrfuzzy_nearest(fuzzy, PSTR("xyzzy"), 1, out, 4));
+    pf_assert(0 == pstrfuzzy_nearest(fuzzy, PSTR("book"), 1, out, 0));
+
+    pstrfuzzy_free(fuzzy);
+    return 0;
+}
+
+const struct pf_test suite_fuzzy[] = {
+    { test_fuzzy_new, "/pstring/fuzzy/new", 1 },
+    { test_fuzzy_each, "/pstring/fuzzy/each", 1 },
+    { test_fuzzy_nearest, "/pstring/fuzzy/nearest", 1 },
+    { 0 },
+};
@@ -0,0 +1,129 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+#include <pf_assert.h>
+#include <pf_test.h>
+
+#include <pstring/intern.h>
+#include <pstring/pstring.h>
+
+#include <pthread.h>
+#include <stdio.h>
+
+#define THREADS 4
+#define WORDS 1000
+
+int test_intern_new(int seed, int rep) {
+    pstrintern_t *intern = pstrintern_new(0, NULL);
+    pf_assert_not_null(intern);
+    pf_assert(0 == pstrintern_count(intern));
+    pstrintern_free(intern);
+
+    intern = pstrintern_new(16, NULL);
+    pf_assert_not_null(intern);
+    pf_assert(0 == pstrintern_count(intern));
+    pf_assert_null(pstrintern(intern, NULL));
+    pf_assert_null(pstrintern(NULL, PSTR("a")));
+    pstrintern_free(intern);
+    return 0;
+}
+
+int test_intern_find(int seed, int rep) {
+    pstrintern_t *intern = pstrintern_new(0, NULL);
+    char buffer[] = "hello world";
+    pstring_t str;
+
+    pf_assert_null(pstrintern_find(intern, PSTR("hello")));
+
+    const pstring_t *hello = pstrintern(intern, PSTR("hello"));
+    pf_assert_not_null(hello);
+    pf_assert(pstrequals(hello, "hello", 0));
+    pf_assert('\0' == *pstrend(hello));
+    pf_assert_null(pstrallocator(hello));
+
+    /* equal strings map to the same pointer, wherever they come from */
+    pstrwrap(&str, buffer, 5, 5);
+    pf_assert(hello == pstrintern(intern, &str));
+    pf_assert(hello == pstrintern_find(intern, &str));
+
+    const pstring_t *world = pstrintern(intern, PSTR("world"));
+    const pstring_t *empty = pstrintern(intern, PSTR(""));
+    pf_assert(world != hello && empty != hello && empty != world);
+    pf_assert(0 == pstrlen(empty));
+    pf_assert(empty == pstrintern(intern, PSTR("")));
+    pf_assert(3 == pstrintern_count(intern));
+
+    pstrintern_free(intern);
+    return 0;
+}
+
+struct worker {
+    pstrintern_t *intern;
+    const pstring_t *found[WORDS];
+};
+
+static void *intern_words(void *arg) {
+    struct worker *worker = arg;
+    char buffer[32];
+    pstring_t str;
+
+    for (int i = 0; i < WORDS; i++) {
+        int length = snprintf(buffer, sizeof(buffer), "word-%d", i);
+        pstrwrap(&str, buffer, length, length);
+        worker->found[i] = pstrintern(worker->intern, &str);
+    }
+
+    return NULL;
+}
+
+int test_intern_shards(int seed, int rep) {
+    struct worker workers[THREADS];
+    pthread_t threads[THREADS];
+    pstrintern_t *intern = pstrintern_new(8, NULL);
+    pf_assert_not_null(intern);
+
+    for (int i = 0; i < THREADS; i++) {
+        workers[i].intern = intern;
+        pf_assert(0 == pthread_create(
+            &threads[i], NULL, intern_words, &workers[i]
+        ));
+    }
+
+    for (int i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    pf_assert(WORDS == pstrintern_count(intern));
+    for (int i = 0; i < WORDS; i++) {
+        pf_assert_not_null(workers[0].found[i]);
+        for (int j = 1; j < THREADS; j++)
+            pf_assert(workers[0].found[i] == workers[j].found[i]);
+    }
+
+    pf_assert(pstrequals(workers[0].found[42], "word-42", 0));
+
+    pstrintern_free(intern);
+    return 0;
+}
+
+const struct pf_test suite_intern[] = {
+    { test_intern_new, "/pstring/intern/new", 1 },
+    { test_intern_find, "/pstring/intern/find", 1 },
+    { test_intern_shards, "/pstring/intern/shards", 1 },
+    { 0 },
+};
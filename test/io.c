@@ -177,11 +177,46 @@ int test_io_json(int seed, int rep) {
     return 0;
 }
 
+int test_io_hash(int seed, int rep) {
+    pstring_t str = { 0 };
+    pstream_t base, stream;
+    pstrhash_state_t state;
+
+    pf_assert_ok(pstrhash_init(&state, 0));
+    pf_assert_ok(pstream_string(&base, &str));
+    pf_assert_ok(pstream_hash(&stream, &base, &state));
+
+    for (int i = 0; i < 100; i++)
+        pf_assert_ok(pstream_printf(&stream, "line %d\n", i));
+
+    pf_assert(pstrlen(&str) == pstream_tell(&stream));
+    pf_assert(PSTRING_ENOSYS == pstream_seek(&stream, 0, PSTR_SEEK_SET));
+    pf_assert(pstrhash_final(&state) == pstrhash(&str));
+
+    /* reading back through a fresh state hashes the same bytes */
+    char buffer[7];
+
+    pf_assert_ok(pstrhash_init(&state, 0));
+    pf_assert_ok(pstream_string(&base, &str));
+    pf_assert_ok(pstream_seek(&base, 0, PSTR_SEEK_SET));
+    pf_assert_ok(pstream_hash(&stream, &base, &state));
+
+    while (pstream_read(&stream, buffer, sizeof(buffer)) > 0)
+        continue;
+
+    pf_assert(pstrhash_final(&state) == pstrhash(&str));
+
+    pstream_close(&stream);
+    pstrfree(&str);
+    return 0;
+}
+
 const struct pf_test suite_io[] = {
     { test_io_read, "/pstring/io/read", 1 },
     { test_io_write, "/pstring/io/write", 1 },
     { test_io_serialize, "/pstring/io/serialize", 1 },
     { test_io_format, "/pstring/io/format", 1 },
     { test_io_json, "/pstring/io/json", 1 },
+    { test_io_hash, "/pstring/io/hash", 1 },
     { 0 },
 };
@@ -28,6 +28,14 @@ extern const pf_test suite_dict[];
 extern const pf_test suite_encoding[];
 extern const pf_test suite_io[];
 extern const pf_test suite_pattern[];
+extern const pf_test suite_search[];
+extern const pf_test suite_fuzzy[];
+extern const pf_test suite_rope[];
+extern const pf_test suite_builder[];
+extern const pf_test suite_allocators[];
+extern const pf_test suite_intern[];
+extern const pf_test suite_parallel[];
+extern const pf_test suite_cdict[];
 
 static const pf_test *suites[] = {
     suite_pstring,
@@ -35,6 +43,14 @@ static const pf_test *suites[] = {
     suite_encoding,
     suite_io,
     suite_pattern,
+    suite_search,
+    suite_fuzzy,
+    suite_rope,
+    suite_builder,
+    suite_allocators,
+    suite_intern,
+    suite_parallel,
+    suite_cdict,
     NULL,
 };
 
@@ -44,6 +60,14 @@ static const char *names[] = {
     "encoding",
     "io",
     "pattern",
+    "search",
+    "fuzzy",
+    "rope",
+    "builder",
+    "allocators",
+    "intern",
+    "parallel",
+    "cdict",
     NULL,
 };
 
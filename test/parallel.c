@@ -0,0 +1,140 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+#include <pf_assert.h>
+#include <pf_test.h>
+
+#include <pstring/parallel.h>
+#include <pstring/pstring.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LENGTH (1024 * 1024 + 7)
+
+static const pstrpar_t par = { .threads = 4, .threshold = 1 };
+
+int test_parallel_search(int seed, int rep) {
+    char *buffer = malloc(LENGTH);
+    pstring_t str, sub = PSTRWRAP("needle");
+    pf_assert_not_null(buffer);
+
+    memset(buffer, 'n', LENGTH);
+    pstrwrap(&str, buffer, LENGTH, LENGTH);
+    pf_assert_null(pstrstr_par(&str, &sub, &par));
+    pf_assert_null(pstrchr_par(&str, 'x', &par));
+    pf_assert_null(pstrstr_par(&str, &sub, NULL));
+
+    /* matches at and across every possible chunk boundary */
+    for (size_t at = 1; at + 6 < LENGTH; at += 4093) {
+        memset(buffer, 'n', LENGTH);
+        memcpy(&buffer[at], "needle", 6);
+        memcpy(&buffer[LENGTH - 6], "needle", 6);
+        buffer[LENGTH - 1] = 'x';
+
+        pf_assert(pstrstr_par(&str, &sub, &par) == &buffer[at]);
+        pf_assert(pstrchr_par(&str, 'd', &par) == &buffer[at + 3]);
+        pf_assert(pstrchr_par(&str, 'x', &par) == &buffer[LENGTH - 1]);
+    }
+
+    free(buffer);
+    return 0;
+}
+
+int test_parallel_count(int seed, int rep) {
+    char *buffer = malloc(LENGTH);
+    pstring_t str;
+    pf_assert_not_null(buffer);
+
+    memset(buffer, 'a', LENGTH);
+    pstrwrap(&str, buffer, LENGTH, LENGTH);
+    pf_assert(pstrcount_par(&str, PSTR("a"), &par) == LENGTH);
+    pf_assert(pstrcount_par(&str, PSTR("aa"), &par) == LENGTH / 2);
+    pf_assert(pstrcount_par(&str, PSTR("aaa"), &par) == LENGTH / 3);
+    pf_assert(pstrcount_par(&str, PSTR("b"), &par) == 0);
+    pf_assert(pstrcount_par(&str, PSTR(""), &par) == 0);
+
+    /* overlapping matches in runs of random lengths */
+    srand(seed);
+    for (size_t i = 0; i < LENGTH; i++)
+        buffer[i] = rand() % 8 ? 'a' : 'b';
+
+    static const char *subs[] = { "aa", "aba", "aaaa", "ab", "bab" };
+    for (size_t i = 0; i < sizeof(subs) / sizeof(*subs); i++) {
+        pstring_t sub;
+        pstrwrap(&sub, (char *)subs[i], 0, 0);
+        pf_assert(pstrcount_par(&str, &sub, &par) == pstrcount(&str, &sub));
+    }
+
+    free(buffer);
+    return 0;
+}
+
+int test_parallel_replc(int seed, int rep) {
+    char *buffer = malloc(LENGTH), *expected = malloc(LENGTH);
+    pstring_t str;
+    pf_assert_not_null(buffer);
+    pf_assert_not_null(expected);
+
+    srand(seed);
+    for (size_t i = 0; i < LENGTH; i++)
+        buffer[i] = "xyz"[rand() % 3];
+
+    memcpy(expected, buffer, LENGTH);
+    for (size_t i = 0; i < LENGTH; i++)
+        if (expected[i] == 'x')
+            expected[i] = 'w';
+
+    pstrwrap(&str, buffer, LENGTH, LENGTH);
+    pf_assert(pstrreplc_par(&str, 'x', 'x', 0, &par) == PSTRING_EINVAL);
+    pf_assert_ok(pstrreplc_par(&str, 'x', 'w', 0, &par));
+    pf_assert_memcmp(buffer, expected, LENGTH);
+    pf_assert_null(pstrchr_par(&str, 'x', &par));
+
+    free(buffer);
+    free(expected);
+    return 0;
+}
+
+int test_parallel_shutdown(int seed, int rep) {
+    char *buffer = malloc(LENGTH);
+    pstring_t str;
+    pf_assert_not_null(buffer);
+
+    memset(buffer, 'a', LENGTH);
+    pstrwrap(&str, buffer, LENGTH, LENGTH);
+    pf_assert(pstrcount_par(&str, PSTR("a"), &par) == LENGTH);
+    pstrpar_shutdown();
+    pstrpar_shutdown();
+
+    /* scans after a shutdown start new workers */
+    pf_assert(pstrcount_par(&str, PSTR("a"), &par) == LENGTH);
+    pstrpar_shutdown();
+
+    free(buffer);
+    return 0;
+}
+
+const struct pf_test suite_parallel[] = {
+    { test_parallel_search, "/pstring/parallel/search", 1 },
+    { test_parallel_count, "/pstring/parallel/count", 1 },
+    { test_parallel_replc, "/pstring/parallel/replc", 1 },
+    { test_parallel_shutdown, "/pstring/parallel/shutdown", 1 },
+    { 0 },
+};
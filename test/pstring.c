@@ -181,6 +181,69 @@ static int test_pstring_compare(int seed, int repetitition) {
     return 0;
 }
 
+static int test_pstring_case(int seed, int repetition) {
+    char mixed[] = "The QUICK brown fox jumps over the lazy dog, "
+                   "\xC3\x89t\xC3\xA9 \xD0\x96\xD0\xB6 \xCE\xA3\xCF\x83!";
+    char lower[] = "the quick brown fox jumps over the lazy dog, "
+                   "\xC3\xA9t\xC3\xA9 \xD0\xB6\xD0\xB6 \xCF\x83\xCF\x83!";
+    char upper[] = "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG, "
+                   "\xC3\x89T\xC3\x89 \xD0\x96\xD0\x96 \xCE\xA3\xCE\xA3!";
+    pstring_t str, dst;
+
+    pf_assert_ok(pstrnew(&str, mixed, 0, NULL));
+    pf_assert_ok(pstrlower(&str));
+    pf_assert_true(pstrequals(&str, lower, 0));
+    pf_assert_ok(pstrupper(&str));
+    pf_assert_true(pstrequals(&str, upper, 0));
+
+    /* invalid bytes and length-changing mappings are kept as they are */
+    pf_assert_ok(pstrnew(&dst, "> ", 0, NULL));
+    pf_assert_ok(pstrupper_into(&dst, &PSTRWRAP("a\xFF\xC5\xBF\xC3\x9F")));
+    pf_assert_true(pstrequals(&dst, "> A\xFF\xC5\xBF\xC3\x9F", 0));
+    pf_assert(PSTRING_EINVAL == pstrlower_into(&dst, &dst));
+
+    pf_assert_true(pstrcaseequal(&PSTRWRAP(mixed), &PSTRWRAP(upper)));
+    pf_assert_true(pstrcaseequal(&PSTRWRAP("\xC5\xBFK"), &PSTRWRAP("sk")));
+    pf_assert_false(pstrcaseequal(&PSTRWRAP("\xFE"), &PSTRWRAP("\xFF")));
+    pf_assert(0 == pstrcasecmp(&PSTRWRAP(lower), &str));
+    pf_assert(0 > pstrcasecmp(&PSTRWRAP("apple"), &PSTRWRAP("Banana")));
+    pf_assert(0 < pstrcasecmp(&PSTRWRAP("ab"), &PSTRWRAP("A")));
+
+    char *match = pstrcasestr(&PSTRWRAP(mixed), &PSTRWRAP("LAZY DOG"));
+    pf_assert(match == pstrstr(&PSTRWRAP(mixed), &PSTRWRAP("lazy dog")));
+    match = pstrcasestr(&PSTRWRAP(mixed), &PSTRWRAP("\xC3\xA9T\xC3\x89"));
+    pf_assert(match == pstrchr(&PSTRWRAP(mixed), '\xC3'));
+    pf_assert_null(pstrcasestr(&PSTRWRAP(mixed), &PSTRWRAP("cat")));
+
+    /* repetitive inputs are searched in linear time after folding them, and
+       matches are found past characters that fold into fewer bytes */
+    static char hay[20024], needle[303];
+    for (int i = 0; i < 20; i += 2) {
+        hay[i] = '\xC5';
+        hay[i + 1] = '\xBF';
+    }
+    for (int i = 20; i < 20020; i++)
+        hay[i] = 'a';
+    for (int i = 0; i < 300; i++)
+        needle[i] = 'A';
+
+    pstring_t phay, pneedle;
+    pstrwrap(&phay, hay, 20022, sizeof(hay));
+    pstrwrap(&pneedle, needle, 303, sizeof(needle));
+    needle[300] = '\xC5';
+    needle[301] = '\xBF';
+    needle[302] = 'B';
+    pf_assert_null(pstrcasestr(&phay, &pneedle));
+
+    hay[20020] = 's';
+    hay[20021] = 'b';
+    pf_assert(&hay[19720] == pstrcasestr(&phay, &pneedle));
+
+    pstrfree(&dst);
+    pstrfree(&str);
+    return 0;
+}
+
 static int test_pstring_concat(int seed, int repetition) {
     pstring_t a = { 0 }, b = { 0 };
     pf_assert_ok(pstralloc(&a, 32, NULL));
@@ -256,6 +319,50 @@ static int test_pstring_copy(int seed, int repetition) {
     return 0;
 }
 
+static int test_pstring_share(int seed, int repetition) {
+    pstring_t str, first, second, slice = PSTRWRAP("slice");
+    pf_assert_ok(pstrnew(&str, "a string too long for sso buffers", 0, NULL));
+    pf_assert(!pstrshared(&str));
+
+    pf_assert_ok(pstrshare(&first, &str));
+    pf_assert_ok(pstrdup(&second, &first, NULL));
+    pf_assert(pstrshared(&str) && pstrshared(&first) && pstrshared(&second));
+    pf_assert(pstrbuf(&str) == pstrbuf(&first));
+    pf_assert(pstrbuf(&str) == pstrbuf(&second));
+
+    /* modifying a reference copies the buffer first */
+    pf_assert_ok(pstrcats(&first, "!", 1));
+    pf_assert(pstrbuf(&str) != pstrbuf(&first));
+    pf_assert(pstrequals(&first, "a string too long for sso buffers!", 0));
+    pf_assert(pstrequals(&str, "a string too long for sso buffers", 0));
+    pf_assert(!pstrshared(&first));
+
+    pf_assert_ok(pstrreplc(&second, ' ', '_', 0));
+    pf_assert(pstrequals(&second, "a_string_too_long_for_sso_buffers", 0));
+    pf_assert(pstrequals(&str, "a string too long for sso buffers", 0));
+    pf_assert(!pstrshared(&str));
+
+    /* the last reference writes in place */
+    char *buffer = pstrbuf(&str);
+    pf_assert_ok(pstrcut(&str, 2, 8));
+    pf_assert(buffer == pstrbuf(&str));
+    pf_assert(pstrequals(&str, "string", 0));
+
+    pstrfree(&second);
+    pstrfree(&first);
+
+    pf_assert_ok(pstrshare(&first, &str));
+    pstrclear(&first);
+    pf_assert(0 == pstrlen(&first));
+    pf_assert(pstrequals(&str, "string", 0));
+    pstrfree(&first);
+    pstrfree(&str);
+
+    pf_assert_ok(pstrshare(&first, &slice));
+    pf_assert(pstrbuf(&first) == pstrbuf(&slice));
+    return 0;
+}
+
 static int test_pstring_chr(int seed, int repetition) {
     char str[] = "foo foo bar buzz";
     pstring_t pstr = PSTRWRAP(str);
@@ -344,6 +451,67 @@ int test_pstring_breakset(int seed, int repetition) {
     return 0;
 }
 
+int test_pstring_set(int seed, int rep) {
+    pstring_t str = PSTRWRAP("AbccDef%$a3145bcb \xff\x80 AbccDef%$a3145bcb");
+    pstrset_t set;
+
+    pf_assert(PSTRING_EINVAL == pstrset_init(NULL, "a", 0));
+    pf_assert_ok(pstrset_init(&set, "AbcD", 0));
+    pf_assert_true(pstrset_has(&set, 'A'));
+    pf_assert_false(pstrset_has(&set, 'a'));
+
+    pf_assert(&pstrbuf(&str)[0] == pstrpbrk_set(&str, &set));
+    pf_assert(&pstrbuf(&str)[5] == pstrcpbrk_set(&str, &set));
+    pf_assert(5 == pstrspn_set(&str, &set));
+    pf_assert(0 == pstrcspn_set(&str, &set));
+
+    pf_assert_ok(pstrset_init(&set, "\x80\xff", 0));
+    pf_assert(&pstrbuf(&str)[18] == pstrpbrk_set(&str, &set));
+    pf_assert(18 == pstrcspn_set(&str, &set));
+
+    pf_assert_ok(pstrset_init(&set, "\0", 1));
+    pf_assert_null(pstrpbrk_set(&str, &set));
+    pf_assert(pstrlen(&str) == pstrcspn_set(&str, &set));
+
+    /* every byte value, checked against the bitmap */
+    char all[256];
+    for (int i = 0; i < 256; i++)
+        all[i] = (char)i;
+
+    pstring_t bytes;
+    pstrwrap(&bytes, all, sizeof(all), sizeof(all));
+
+    for (int i = 0; i < 256; i += 17) {
+        pf_assert_ok(pstrset_init(&set, &all[i], 256 - i));
+        pf_assert(i == pstrcspn_set(&bytes, &set));
+        pf_assert(&all[i] == pstrpbrk_set(&bytes, &set));
+
+        pf_assert_ok(pstrset_init(&set, all, i + 1));
+        pf_assert(i + 1 == pstrspn_set(&bytes, &set));
+    }
+
+    pstring_t token;
+    pf_assert_ok(pstrset_init(&set, ", ", 0));
+    str = PSTRWRAP("Hello, world!");
+    pf_assert_ok(pstrtok_set(&token, &str, NULL));
+    pf_assert_ok(pstrtok_set(&token, &str, &set));
+    pf_assert_true(pstrequals(&token, "Hello", 0));
+    pf_assert_ok(pstrtok_set(&token, &str, &set));
+    pf_assert_true(pstrequals(&token, "world!", 0));
+    pf_assert(PSTRING_ENOENT == pstrtok_set(&token, &str, &set));
+
+    pf_assert_ok(pstrset_init(&set, " \t\r\n", 0));
+    str = PSTRWRAP("\t\r\n  Hello, world!                          \n");
+    pf_assert_ok(pstrstrip_set(&str, &set));
+    pf_assert_true(pstrequals(&str, "Hello, world!", 0));
+
+    str = PSTRWRAP("                                       ");
+    pf_assert_ok(pstrstrip_set(&str, &set));
+    pf_assert(0 == pstrlen(&str));
+
+    return 0;
+}
+
 int test_pstring_strip(int seed, int rep) {
     pstring_t str = PSTRWRAP("   Hello, world!   ");
     pf_assert_ok(pstrlstrip(&str, NULL));
@@ -380,6 +548,34 @@ int test_pstring_substring(int seed, int repetition) {
     pstrslice(&slice, &PSTRWRAP("Hello, world!"), 5, 6);
     pf_assert(pstrbuf(&slice) == pstrstr(&str, &slice));
 
+    pstring_t lorem;
+    pstrwrap(&lorem, (char *)t_long, 0, 0);
+    pf_assert(strstr(t_long, "nisi") == pstrstr(&lorem, PSTR("nisi")));
+    pf_assert(strstr(t_long, "lectus.") == pstrstr(&lorem, PSTR("lectus.")));
+    pf_assert_null(pstrstr(&lorem, PSTR("amet lectum")));
+
+    pf_assert(pstrcount(PSTR("abababa"), PSTR("aba")) == 2);
+    pf_assert(pstrcount(PSTR("aaaa"), PSTR("a")) == 4);
+    pf_assert(pstrcount(&str, PSTR("o")) == 2);
+    pf_assert(pstrcount(&str, PSTR("!")) == 1);
+    pf_assert(pstrcount(&str, PSTR("")) == 0);
+    pf_assert(pstrcount(PSTR("ab"), PSTR("abc")) == 0);
+    pf_assert(pstrcount(NULL, PSTR("a")) == 0);
+
+    /* repetitive input that defeats the first and last byte filter */
+    char hay[4096], needle[128];
+    memset(hay, 'a', sizeof(hay));
+    memset(needle, 'a', sizeof(needle));
+    needle[sizeof(needle) - 2] = 'b';
+
+    pstring_t phay, pneedle;
+    pstrwrap(&phay, hay, sizeof(hay), sizeof(hay));
+    pstrwrap(&pneedle, needle, sizeof(needle), sizeof(needle));
+    pf_assert_null(pstrstr(&phay, &pneedle));
+
+    hay[3000] = 'b';
+    pf_assert(&hay[3000 - sizeof(needle) + 2] == pstrstr(&phay, &pneedle));
+
     return 0;
 }
 
@@ -400,7 +596,46 @@ int test_pstring_replace(int seed, int rep) {
     TEST_REPL(&str, "ABC", "a", 3, "aaa");
     TEST_REPL(&str, "aa", "AAAA", 0, "AAAAa");
     TEST_REPL(&str, "A", "", 0, "a");
+    TEST_REPL(&str, "a", "<a>", 0, "<a>");
+    TEST_REPL(&str, "b", "c", 0, "<a>");
+    pf_assert(
+        PSTRING_EINVAL == pstrrepl(&str, &PSTRWRAP(""), &PSTRWRAP("x"), 0)
+    );
+
+    pstring_t dst;
+    pf_assert_ok(pstrnew(&dst, "> ", 0, NULL));
+    pf_assert_ok(pstrrepl_into(
+        &dst, &PSTRWRAP("a.b.c"), &PSTRWRAP("."), &PSTRWRAP(", "), 0
+    ));
+    pf_assert_true(pstrequals(&dst, "> a, b, c", 0));
+    pf_assert_ok(pstrrepl_into(
+        &dst, &PSTRWRAP("..."), &PSTRWRAP("."), &PSTRWRAP(""), 2
+    ));
+    pf_assert_true(pstrequals(&dst, "> a, b, c.", 0));
+    pf_assert(
+        PSTRING_EINVAL
+        == pstrrepl_into(&dst, &dst, &PSTRWRAP("a"), &PSTRWRAP("b"), 0)
+    );
+
+    /* the output length would overflow, the huge replacement is never read */
+    pstring_t huge;
+    pstrwrap(&huge, "x", SIZE_MAX / 2, SIZE_MAX / 2);
+    pf_assert(
+        PSTRING_ENOMEM
+        == pstrrepl_into(&dst, &PSTRWRAP("aa"), &PSTRWRAP("a"), &huge, 0)
+    );
+    pf_assert_true(pstrequals(&dst, "> a, b, c.", 0));
+
+    pstrclear(&str);
+    for (int i = 0; i < 1000; i++)
+        pf_assert_ok(pstrcats(&str, "<b>x</b>", 0));
+
+    pf_assert_ok(pstrrepls(&str, "<b>", "<strong>", 0));
+    pf_assert(pstrlen(&str) == 1000 * 13);
+    pf_assert_true(pstrprefix(&str, "<strong>x</b><strong>", 0));
+    TEST_REPL(&str, "<strong>x</b>", "", 999, "<strong>x</b>");
 
+    pstrfree(&dst);
     pstrfree(&str);
     return 0;
 }
@@ -441,6 +676,40 @@ int test_pstring_split(int seed, int rep) {
     return 0;
 }
 
+int test_pstring_split_all(int seed, int rep) {
+    pstring_t src, fields[4];
+    pstrset_t set;
+
+    src = PSTRWRAP("id,name,,email");
+    pf_assert(pstrsplit_all(&src, &PSTRWRAP(","), fields, 4) == 4);
+    pf_assert_true(pstrequals(&fields[0], "id", 0));
+    pf_assert_true(pstrequals(&fields[1], "name", 0));
+    pf_assert_true(pstrlen(&fields[2]) == 0);
+    pf_assert_true(pstrequals(&fields[3], "email", 0));
+
+    pf_assert(pstrsplit_all(&src, &PSTRWRAP(","), fields, 2) == 4);
+    pf_assert_true(pstrequals(&fields[1], "name", 0));
+    pf_assert(pstrsplit_all(&src, &PSTRWRAP(","), NULL, 0) == 4);
+    pf_assert(pstrsplit_all(&src, &PSTRWRAP(""), fields, 4) == 0);
+    pf_assert(pstrsplit_all(&PSTRWRAP(""), &PSTRWRAP(","), NULL, 0) == 1);
+
+    src = PSTRWRAP("1<>2<><>3");
+    pf_assert(pstrsplit_all(&src, &PSTRWRAP("<>"), fields, 4) == 4);
+    pf_assert_true(pstrequals(&fields[1], "2", 0));
+    pf_assert_true(pstrlen(&fields[2]) == 0);
+    pf_assert_true(pstrequals(&fields[3], "3", 0));
+
+    pf_assert_ok(pstrset_init(&set, " \t", 0));
+    src = PSTRWRAP("a b\t\tc");
+    pf_assert(pstrsplit_set(&src, &set, fields, 4) == 4);
+    pf_assert_true(pstrequals(&fields[0], "a", 0));
+    pf_assert_true(pstrequals(&fields[1], "b", 0));
+    pf_assert_true(pstrlen(&fields[2]) == 0);
+    pf_assert_true(pstrequals(&fields[3], "c", 0));
+
+    return 0;
+}
+
 int test_pstring_insert_remove(int seed, int rep) {
     pstring_t str;
 
@@ -483,6 +752,115 @@ int test_pstring_distance(int seed, int rep) {
     pf_assert(1 == pstrdistance(PSTR("ab"), PSTR("ba")));
     pf_assert(1 == pstrdistance(PSTR("abc"), PSTR("acb")));
     pf_assert(3 == pstrdistance(PSTR("saturday"), PSTR("sunday")));
+    pf_assert(6 == pstrdistance(PSTR(""), PSTR("sunday")));
+
+    pf_assert(3 == pstrdistance_bounded(PSTR("kitten"), PSTR("sitting"), 3));
+    /* the distance is 8, so only stopping early returns max + 1 */
+    pf_assert(8 == pstrdistance(PSTR("abcdefgh"), PSTR("stuvwxyz")));
+    pf_assert(
+        3 == pstrdistance_bounded(PSTR("abcdefgh"), PSTR("stuvwxyz"), 2)
+    );
+    pf_assert(1 == pstrdistance_bounded(PSTR("abc"), PSTR("abcdefgh"), 0));
+    pf_assert(PSTRING_EINVAL == pstrdistance_bounded(NULL, PSTR("a"), 1));
+
+    /* patterns longer than a machine word */
+    char left[200], right[200];
+    for (int i = 0; i < 200; i++)
+        left[i] = right[i] = "ab"[i % 2];
+
+    pstring_t pleft, pright;
+    pstrwrap(&pleft, left, sizeof(left), sizeof(left));
+    pstrwrap(&pright, right, sizeof(right), sizeof(right));
+    pf_assert(0 == pstrdistance(&pleft, &pright));
+
+    right[0] = 'b';
+    right[1] = 'a';
+    right[150] = 'x';
+    pf_assert(2 == pstrdistance(&pleft, &pright));
+
+    pstrslice(&pright, &pright, 1, 199);
+    pf_assert(3 == pstrdistance(&pleft, &pright));
+    pf_assert(2 == pstrdistance_bounded(&pleft, &pright, 1));
+
+    /* patterns too long for the state to be kept on the stack */
+    char text[400];
+    for (int i = 0; i < 400; i++)
+        text[i] = "abc"[i % 3];
+
+    pf_assert_ok(pstrnew(&pleft, text, sizeof(text), NULL));
+    pstrwrap(&pright, text, sizeof(text), sizeof(text));
+    text[200] = 'x';
+    pf_assert(1 == pstrdistance(&pleft, &pright));
+    pf_assert(1 == pstrdistance(&pright, &pleft));
+    pstrfree(&pleft);
+
+    return 0;
+}
+
+int test_pstring_hash(int seed, int rep) {
+    char buffer[160], copy[161];
+    for (int i = 0; i < 160; i++)
+        buffer[i] = (char)(i * 7 + 1);
+
+    pf_assert(pstrhash(PSTR("")) == pstrhash(PSTR("")));
+    pf_assert(pstrhash(PSTR("")) != pstrhash(PSTR("\x01")));
+
+    /* equal contents hash equally at any alignment, every length differs */
+    for (size_t length = 1; length <= 128; length++) {
+        pstring_t str, other;
+        pstrwrap(&str, buffer, length, length);
+        memcpy(&copy[1], buffer, length);
+        pstrwrap(&other, &copy[1], length, length);
+
+        pf_assert(pstrhash(&str) == pstrhash(&other));
+        pf_assert(pstrhash_seeded(&str, 42) == pstrhash_seeded(&other, 42));
+        pf_assert(pstrhash_seeded(&str, 42) != pstrhash_seeded(&str, 43));
+
+        copy[length] ^= 1;
+        pf_assert(pstrhash(&str) != pstrhash(&other));
+
+        pstrslice(&other, &str, 0, length - 1);
+        pf_assert(pstrhash(&str) != pstrhash(&other));
+    }
+
+    /* hashing in pieces of any size matches hashing everything at once */
+    for (size_t length = 0; length <= 160; length += 1 + length / 8) {
+        pstring_t str;
+        pstrwrap(&str, buffer, sizeof(buffer), sizeof(buffer));
+        pstrslice(&str, &str, 0, length);
+
+        for (size_t piece = 1; piece <= 64; piece += piece < 4 ? 1 : 15) {
+            pstrhash_state_t state;
+            pf_assert_ok(pstrhash_init(&state, 7));
+
+            for (size_t i = 0; i < length; i += piece) {
+                size_t size = length - i < piece ? length - i : piece;
+                pf_assert_ok(pstrhash_updates(&state, &buffer[i], size));
+            }
+
+            pf_assert(pstrhash_final(&state) == pstrhash_seeded(&str, 7));
+        }
+    }
+
+    pstring_t strs[100];
+    size_t hashes[100];
+    for (size_t i = 0; i < 100; i++)
+        pstrwrap(&strs[i], &buffer[i], 1 + i % 60, 1 + i % 60);
+
+    pstrhash_many(strs, 100, hashes);
+    for (size_t i = 0; i < 100; i++)
+        pf_assert(hashes[i] == pstrhash(&strs[i]));
+
+    pstrhash_many_seeded(strs, 100, 9, hashes);
+    for (size_t i = 0; i < 100; i++)
+        pf_assert(hashes[i] == pstrhash_seeded(&strs[i], 9));
+
+    pstrhash_state_t state;
+    pf_assert_ok(pstrhash_init(&state, 0));
+    pf_assert_ok(pstrhash_update(&state, PSTR("Hello, ")));
+    pf_assert_ok(pstrhash_update(&state, PSTR("world!")));
+    pf_assert(pstrhash_final(&state) == pstrhash(PSTR("Hello, world!")));
+    pf_assert(PSTRING_EINVAL == pstrhash_init(NULL, 0));
 
     return 0;
 }
@@ -493,18 +871,23 @@ const struct pf_test suite_pstring[] = {
     { test_pstring_wrap_slice, "/pstring/wrap_slice", 1 },
     { test_pstring_resize, "/pstring/resize", 1 },
     { test_pstring_compare, "/pstring/compare", 1 },
+    { test_pstring_case, "/pstring/case", 1 },
     { test_pstring_concat, "/pstring/concat", 1 },
     { test_pstring_join, "/pstring/join", 1 },
     { test_pstring_copy, "/pstring/copy", 1 },
+    { test_pstring_share, "/pstring/share", 1 },
     { test_pstring_chr, "/pstring/chr", 1 },
     { test_pstring_span, "/pstring/span", 1 },
     { test_pstring_breakset, "/pstring/breakset", 1 },
+    { test_pstring_set, "/pstring/set", 1 },
     { test_pstring_strip, "/pstring/strip", 1 },
     { test_pstring_substring, "/pstring/substring", 1 },
     { test_pstring_replace, "/pstring/replace", 1 },
     { test_pstring_split, "/pstring/split", 1 },
+    { test_pstring_split_all, "/pstring/split_all", 1 },
     { test_pstring_insert_remove, "/pstring/insert_remove", 1 },
     { test_pstring_indent, "/pstring/indent", 1 },
     { test_pstring_distance, "/pstring/distance", 1 },
+    { test_pstring_hash, "/pstring/hash", 1 },
     { 0 },
 };
@@ -0,0 +1,194 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+#include <pf_assert.h>
+#include <pf_test.h>
+
+#include <pstring/pstring.h>
+#include <pstring/rope.h>
+
+#include <string.h>
+
+static int rope_equals(const pstrrope_t *rope, const char *expected) {
+    pstring_t flat = { 0 };
+    int res = pstrrope_flatten(rope, &flat) == PSTRING_OK
+        && pstrlen(&flat) == strlen(expected)
+        && memcmp(pstrbuf(&flat), expected, pstrlen(&flat)) == 0;
+    pstrfree(&flat);
+    return res;
+}
+
+int test_rope_new(int seed, int rep) {
+    pstrrope_t rope;
+
+    pf_assert(PSTRING_EINVAL == pstrrope_new(NULL, NULL, NULL));
+
+    pf_assert_ok(pstrrope_new(&rope, NULL, NULL));
+    pf_assert(0 == pstrrope_len(&rope));
+    pf_assert(rope_equals(&rope, ""));
+    pstrrope_free(&rope);
+
+    pf_assert_ok(pstrrope_new(&rope, PSTR("hello world"), NULL));
+    pf_assert(11 == pstrrope_len(&rope));
+    pf_assert('w' == pstrrope_get(&rope, 6));
+    pf_assert('\0' == pstrrope_get(&rope, 11));
+    pf_assert(rope_equals(&rope, "hello world"));
+    pstrrope_free(&rope);
+    pf_assert(0 == pstrrope_len(&rope));
+
+    return 0;
+}
+
+int test_rope_insert(int seed, int rep) {
+    pstrrope_t rope = { 0 };
+
+    pf_assert_ok(pstrrope_insert(&rope, 0, PSTR("world")));
+    pf_assert_ok(pstrrope_insert(&rope, 0, PSTR("hello ")));
+    pf_assert_ok(pstrrope_insert(&rope, 11, PSTR("!")));
+    pf_assert_ok(pstrrope_insert(&rope, 5, PSTR(",")));
+    pf_assert_ok(pstrrope_insert(&rope, 3, PSTR("")));
+    pf_assert(rope_equals(&rope, "hello, world!"));
+    pf_assert(PSTRING_EINVAL == pstrrope_insert(&rope, 14, PSTR("x")));
+    pf_assert(PSTRING_EINVAL == pstrrope_insert(&rope, 0, NULL));
+
+    /* large inserts are spread over multiple chunks */
+    pstring_t big = { 0 };
+    for (int i = 0; i < 1000; i++)
+        pf_assert_ok(pstrcat(&big, PSTR("0123456789")));
+
+    pf_assert_ok(pstrrope_insert(&rope, 7, &big));
+    pf_assert_ok(pstrrope_insert(&rope, 5000, PSTR("<>")));
+    pf_assert(10015 == pstrrope_len(&rope));
+    pf_assert('0' == pstrrope_get(&rope, 7));
+    pf_assert('<' == pstrrope_get(&rope, 5000));
+    pf_assert('>' == pstrrope_get(&rope, 5001));
+    pf_assert('3' == pstrrope_get(&rope, 5002));
+    pf_assert('w' == pstrrope_get(&rope, 10009));
+
+    pstrfree(&big);
+    pstrrope_free(&rope);
+    return 0;
+}
+
+int test_rope_remove(int seed, int rep) {
+    pstrrope_t rope;
+    pf_assert_ok(pstrrope_new(&rope, PSTR("hello, big world!"), NULL));
+
+    pf_assert_ok(pstrrope_remove(&rope, 5, 6));
+    pf_assert_ok(pstrrope_remove(&rope, 6, 10));
+    pf_assert_ok(pstrrope_remove(&rope, 3, 3));
+    pf_assert(rope_equals(&rope, "hello world!"));
+    pf_assert(PSTRING_EINVAL == pstrrope_remove(&rope, 4, 3));
+    pf_assert(PSTRING_EINVAL == pstrrope_remove(&rope, 0, 13));
+
+    pstring_t big = { 0 };
+    for (int i = 0; i < 1000; i++)
+        pf_assert_ok(pstrcat(&big, PSTR("abcdefghij")));
+
+    /* removals spanning several chunks */
+    pf_assert_ok(pstrrope_insert(&rope, 6, &big));
+    pf_assert_ok(pstrrope_remove(&rope, 10, 9990));
+    pf_assert(rope_equals(&rope, "hello abcdefghijabcdefghijworld!"));
+
+    /* the chunks left on both sides of the removal are merged */
+    pstring_t chunk;
+    pf_assert_ok(pstrrope_chunk(&rope, 6, &chunk));
+    pf_assert(26 == pstrlen(&chunk));
+    pf_assert_ok(pstrrope_remove(&rope, 0, pstrrope_len(&rope)));
+    pf_assert(0 == pstrrope_len(&rope));
+
+    /* small removals inside chunks merge them once they're half empty */
+    pf_assert_ok(pstrrope_insert(&rope, 0, &big));
+    for (int i = 0; i < 11; i++)
+        pf_assert_ok(pstrrope_remove(&rope, 100, 200));
+    for (int i = 0; i < 11; i++)
+        pf_assert_ok(pstrrope_remove(&rope, 1048, 1148));
+
+    size_t chunks = 0;
+    for (size_t at = 0; !pstrrope_chunk(&rope, at, &chunk);
+         at += pstrlen(&chunk))
+        chunks++;
+    pf_assert(7800 == pstrrope_len(&rope));
+    pf_assert(4 == chunks);
+    pf_assert('a' == pstrrope_get(&rope, 100));
+
+    pstrfree(&big);
+    pstrrope_free(&rope);
+    return 0;
+}
+
+int test_rope_split(int seed, int rep) {
+    pstrrope_t rope, tail;
+    pf_assert_ok(pstrrope_new(&rope, PSTR("hello world"), NULL));
+
+    pf_assert_ok(pstrrope_split(&rope, 5, &tail));
+    pf_assert(rope_equals(&rope, "hello"));
+    pf_assert(rope_equals(&tail, " world"));
+    pf_assert(PSTRING_EINVAL == pstrrope_split(&rope, 6, &tail));
+
+    pf_assert_ok(pstrrope_insert(&rope, 0, PSTR("well, ")));
+    pf_assert_ok(pstrrope_concat(&rope, &tail));
+    pf_assert(rope_equals(&rope, "well, hello world"));
+
+    /* the last chunk of `rope` and the first of `tail` are merged */
+    pstring_t chunk;
+    pf_assert_ok(pstrrope_chunk(&rope, 0, &chunk));
+    pf_assert(17 == pstrlen(&chunk));
+    pf_assert(0 == pstrrope_len(&tail));
+    pf_assert(PSTRING_EINVAL == pstrrope_concat(&rope, &rope));
+
+    pstrrope_free(&tail);
+    pstrrope_free(&rope);
+    return 0;
+}
+
+int test_rope_chunk(int seed, int rep) {
+    pstrrope_t rope;
+    pstring_t chunk, out = { 0 };
+    pf_assert_ok(pstrrope_new(&rope, PSTR("hello world"), NULL));
+
+    pf_assert_ok(pstrrope_chunk(&rope, 6, &chunk));
+    pf_assert(5 == pstrlen(&chunk));
+    pf_assert(0 == pstrcmp(&chunk, PSTR("world")));
+    pf_assert(PSTRING_ENOENT == pstrrope_chunk(&rope, 11, &chunk));
+
+    pf_assert_ok(pstrrope_insert(&rope, 5, &chunk));
+    size_t length = 0;
+    for (size_t at = 0; !pstrrope_chunk(&rope, at, &chunk);
+         at += pstrlen(&chunk))
+        length += pstrlen(&chunk);
+    pf_assert(16 == length);
+
+    pf_assert_ok(pstrrope_substr(&rope, &out, 3, 12));
+    pf_assert(0 == pstrcmp(&out, PSTR("loworld w")));
+    pf_assert(PSTRING_EINVAL == pstrrope_substr(&rope, &out, 3, 17));
+
+    pstrfree(&out);
+    pstrrope_free(&rope);
+    return 0;
+}
+
+const struct pf_test suite_rope[] = {
+    { test_rope_new, "/pstring/rope/new", 1 },
+    { test_rope_insert, "/pstring/rope/insert", 1 },
+    { test_rope_remove, "/pstring/rope/remove", 1 },
+    { test_rope_split, "/pstring/rope/split", 1 },
+    { test_rope_chunk, "/pstring/rope/chunk", 1 },
+    { 0 },
+};
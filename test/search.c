@@ -0,0 +1,177 @@
+/*  pstring - fully-featured string library for C
+
+    SPDX-FileCopyrightText: 2026 Предраг Јовановић
+    SPDX-License-Identifier: Apache-2.0
+
+    Copyright 2026 Предраг Јовановић
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include <pf_assert.h>
+#include <pf_test.h>
+
+#include <pstring/pstring.h>
+#include <pstring/search.h>
+
+#include <limits.h>
+
+int test_search_new(int seed, int rep) {
+    pstring_t needles[] = { PSTRWRAP("he"), PSTRWRAP("") };
+
+    pf_assert_null(pstrsearch_new(NULL, 0, NULL));
+    pf_assert_null(pstrsearch_new(needles, 2, NULL));
+    pf_assert_null(pstrsearch_new(needles, (size_t)INT_MAX + 1, NULL));
+
+    pstrsearch_t *search = pstrsearch_new(needles, 1, NULL);
+    pf_assert_not_null(search);
+    pf_assert(1 == pstrsearch_count(search));
+
+    pstrsearch_free(search);
+    return 0;
+}
+
+int test_search_find(int seed, int rep) {
+    pstring_t needles[] = {
+        PSTRWRAP("he"),  PSTRWRAP("she"), PSTRWRAP("his"),
+        PSTRWRAP("hers"), PSTRWRAP("s"),
+    };
+
+    pstrsearch_t *search = pstrsearch_new(needles, 5, NULL);
+    pf_assert_not_null(search);
+
+    pstring_t match;
+    pf_assert(1 == pstrsearch_find(search, PSTR("ushers"), &match));
+    pf_assert_true(pstrequals(&match, "she", 0));
+
+    pf_assert(3 == pstrsearch_find(search, PSTR("xhersx"), &match));
+    pf_assert_true(pstrequals(&match, "hers", 0));
+
+    pf_assert(2 == pstrsearch_find(search, PSTR("this"), &match));
+    pf_assert_true(pstrequals(&match, "his", 0));
+
+    pf_assert(PSTRING_ENOENT == pstrsearch_find(search, PSTR("xyz"), &match));
+    pf_assert(PSTRING_ENOENT == pstrsearch_find(search, PSTR(""), &match));
+    pf_assert(PSTRING_EINVAL == pstrsearch_find(NULL, PSTR("he"), &match));
+
+    pstrsearch_free(search);
+
+    search = pstrsearch_new(&PSTRWRAP("world"), 1, NULL);
+    pf_assert_not_null(search);
+    pf_assert(0 == pstrsearch_find(search, PSTR("Hello, world!"), &match));
+    pf_assert_true(pstrequals(&match, "world", 0));
+
+    pstrsearch_free(search);
+    return 0;
+}
+
+struct each_state {
+    size_t count;
+    size_t ids[16];
+    size_t ends[16];
+};
+
+static int collect(void *user, size_t id, pstring_t *match) {
+    struct each_state *state = user;
+    if (state->count == 16)
+        return 1;
+
+    state->ids[state->count] = id;
+    state->ends[state->count] = pstrlen(match);
+    state->count++;
+    return 0;
+}
+
+int test_search_each(int seed, int rep) {
+    pstring_t needles[] = {
+        PSTRWRAP("he"),  PSTRWRAP("she"), PSTRWRAP("his"),
+        PSTRWRAP("hers"), PSTRWRAP("s"),
+    };
+
+    pstrsearch_t *search = pstrsearch_new(needles, 5, NULL);
+    pf_assert_not_null(search);
+
+    struct each_state state = { 0 };
+    pf_assert_ok(pstrsearch_each(search, PSTR("ushers"), collect, &state));
+
+    /* s, she, he, hers, s */
+    pf_assert(5 == state.count);
+    pf_assert(4 == state.ids[0] && 1 == state.ids[1] && 0 == state.ids[2]);
+    pf_assert(3 == state.ids[3] && 4 == state.ids[4]);
+
+    state.count = 16;
+    pf_assert(
+        PSTRING_EINTR == pstrsearch_each(search, PSTR("she"), collect, &state)
+    );
+
+    pstrsearch_free(search);
+
+    search = pstrsearch_new(&PSTRWRAP("aa"), 1, NULL);
+    state.count = 0;
+    pf_assert_ok(pstrsearch_each(search, PSTR("aaaa"), collect, &state));
+    pf_assert(3 == state.count);
+
+    pstrsearch_free(search);
+    return 0;
+}
+
+int test_search_repl(int seed, int rep) {
+    pstring_t from[] = {
+        PSTRWRAP("<"), PSTRWRAP(">"), PSTRWRAP("&"), PSTRWRAP("&amp;"),
+    };
+    pstring_t to[] = {
+        PSTRWRAP("&lt;"), PSTRWRAP("&gt;"), PSTRWRAP("&amp;"), PSTRWRAP("&"),
+    };
+
+    pstring_t str;
+    pf_assert_ok(pstrnew(&str, "<a> & &amp; b", 0, NULL));
+    pf_assert_ok(pstrrepl_many(&str, from, to, 4));
+    pf_assert_true(pstrequals(&str, "&lt;a&gt; &amp; & b", 0));
+
+    /* replacements are not searched again */
+    pf_assert_ok(pstrrepl_many(&str, &PSTRWRAP("a"), &PSTRWRAP("aa"), 1));
+    pf_assert_true(pstrequals(&str, "&lt;aa&gt; &aamp; & b", 0));
+
+    pf_assert(PSTRING_EINVAL == pstrrepl_many(&str, from, to, 0));
+    pf_assert(
+        PSTRING_EINVAL == pstrrepl_many(&str, &PSTRWRAP(""), to, 1)
+    );
+
+    pstrsearch_t *search = pstrsearch_new(from, 4, NULL);
+    pf_assert_not_null(search);
+
+    pstring_t dst;
+    pf_assert_ok(pstrnew(&dst, "", 0, NULL));
+    pf_assert_ok(pstrsearch_repl(search, &dst, PSTR("1<2"), to));
+    pf_assert_ok(pstrsearch_repl(search, &dst, PSTR(" & 3>2"), to));
+    pf_assert_true(pstrequals(&dst, "1&lt;2 &amp; 3&gt;2", 0));
+
+    pstrfree(&str);
+
+    char buffer[16] = "a&amp;b";
+    pstrwrap(&str, buffer, 0, sizeof(buffer) - 1);
+    pf_assert_ok(pstrrepl_many(&str, from, to, 4));
+    pf_assert_true(pstrequals(&str, "a&b", 0));
+
+    pstrsearch_free(search);
+    pstrfree(&dst);
+    return 0;
+}
+
+const struct pf_test suite_search[] = {
+    { test_search_new, "/pstring/search/new", 1 },
+    { test_search_find, "/pstring/search/find", 1 },
+    { test_search_each, "/pstring/search/each", 1 },
+    { test_search_repl, "/pstring/search/repl", 1 },
+    { 0 },
+};